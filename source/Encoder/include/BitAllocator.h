@@ -0,0 +1,88 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BITALLOCATOR_H
+#define BITALLOCATOR_H
+
+#include <vector>
+
+#include "PsychohapticModel/include/PsychohapticModel.h"
+
+namespace haptics::encoder {
+
+// Greedy allocation of the bits of a wavelet block to its bands. Each bit goes to the band of
+// lowest mask to noise ratio (MNR) that is not yet quantized with MAXBITS bits, the first one on
+// ties. The MNR of the bands are kept in a binary heap, only the band given a bit being quantized
+// again and moved in the heap, so that each bit costs a single logarithm.
+class BitAllocator {
+public:
+  BitAllocator() = default;
+  // book holds the length of each band and book_cumulative the start of each band, followed by
+  // the length of the block
+  BitAllocator(std::vector<int> book_new, std::vector<int> book_cumulative_new);
+
+  // Allocates at most bitbudget bits to the bands of the wavelet coefficients block_dwt, quantized
+  // with the maximum qwavmax, given the band energies and signal to mask ratios of the model.
+  // Writes the number of bits of each band into bitalloc and the quantized coefficients into
+  // block_dwt_quant.
+  void allocate(std::vector<double> &block_dwt, double qwavmax, tools::modelResult &model,
+                int bitbudget, std::vector<double> &block_dwt_quant, std::vector<int> &bitalloc);
+
+private:
+  // Quantizes the band with its number of bits and returns its noise energy
+  [[nodiscard]] auto quantizeBand(std::vector<double> &block_dwt, double qwavmax, int bits,
+                                  size_t band, std::vector<double> &block_dwt_quant) const
+      -> double;
+  void updateMNR(tools::modelResult &model, std::vector<int> &bitalloc, size_t band);
+  // Moves the band in the heap after a change of its MNR
+  void reposition(size_t band);
+  // Band of lowest MNR, as found by WaveletEncoder::findMinInd
+  [[nodiscard]] auto lowestMNRBand() const -> size_t;
+  // Order of the heap: by MNR, NaN values last, then by band
+  [[nodiscard]] auto precedes(size_t band1, size_t band2) const -> bool;
+  void siftUp(size_t position);
+  void siftDown(size_t position);
+  void swapHeapEntries(size_t position1, size_t position2);
+
+  std::vector<int> book;
+  std::vector<int> book_cumulative;
+  // Magnitude of each coefficient relative to the maximum of the block
+  std::vector<double> relativeMagnitude;
+  std::vector<double> noiseenergy;
+  std::vector<double> MNR;
+  // Bands ordered as a binary heap on their MNR, and position of each band in the heap
+  std::vector<size_t> heap;
+  std::vector<size_t> heapPosition;
+};
+} // namespace haptics::encoder
+#endif // BITALLOCATOR_H
@@ -65,6 +65,8 @@ struct EncodingConfig {
   int wavelet_bitbudget = 0;
   bool wavelet_enabled = true;
   bool vectorial_enabled = true;
+  // Number of threads encoding the blocks of the wavelet band of a channel
+  size_t threadCount = 1;
 
   explicit EncodingConfig() = default;
   explicit EncodingConfig(double _curveFrequencyLimit, int _wavelet_blockLength,
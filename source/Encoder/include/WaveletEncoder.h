@@ -37,6 +37,7 @@
 #include <cmath>
 #include <vector>
 
+#include "BitAllocator.h"
 #include "FilterBank/include/Wavelet.h"
 #include "PsychohapticModel/include/PsychohapticModel.h"
 #include "Spiht/include/Spiht_Enc.h"
@@ -63,15 +64,16 @@ class WaveletEncoder {
 public:
   WaveletEncoder(int bl_new, int fs_new);
 
+  // Encodes the signal block by block into band. Blocks are independent from each other: with
+  // several threads, each thread encodes a contiguous range of blocks with its own psychohaptic
+  // model and SPIHT encoder, the resulting band being identical whatever the number of threads.
   auto encodeSignal(std::vector<double> &sig_time, int bitbudget, double f_cutoff, Band &band,
-                    unsigned int timescale) -> bool;
+                    unsigned int timescale, size_t threadCount = 1) -> bool;
   void encodeBlock(std::vector<double> &block_time, int bitbudget, double &scalar, int &maxbits,
                    std::vector<unsigned char> &bitstream);
   static void maximumWaveletCoefficient(std::vector<double> &sig, double &qwavmax,
                                         std::vector<unsigned char> &bitwavmax);
   void static maximumWaveletCoefficient(double qwavmax, std::vector<unsigned char> &bitwavmax);
-  void updateNoise(std::vector<double> &bandenergy, std::vector<double> &noiseenergy,
-                   std::vector<double> &SNR, std::vector<double> &MNR, std::vector<double> &SMR);
 
   static void uniformQuant(std::vector<double> &in, size_t start, double max, int bits,
                            size_t length, std::vector<double> &out);
@@ -85,11 +87,13 @@ public:
 private:
   tools::PsychohapticModel pm;
   Spiht_Enc spihtEnc;
+  Wavelet wavelet;
   int bl;
   int fs;
   int dwtlevel;
   std::vector<int> book;
   std::vector<int> book_cumulative;
+  BitAllocator bitAllocator;
 };
 } // namespace haptics::encoder
 #endif // WAVELETENCODER_H
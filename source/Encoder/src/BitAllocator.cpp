@@ -0,0 +1,214 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../include/BitAllocator.h"
+#include "../include/WaveletEncoder.h"
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+namespace haptics::encoder {
+
+constexpr double TRUNCATION_LIMIT = 4503599627370496.0; // 2^52
+
+BitAllocator::BitAllocator(std::vector<int> book_new, std::vector<int> book_cumulative_new)
+    : book(std::move(book_new)), book_cumulative(std::move(book_cumulative_new)) {
+
+  noiseenergy.resize(book.size());
+  MNR.resize(book.size());
+  heap.resize(book.size());
+  heapPosition.resize(book.size());
+}
+
+void BitAllocator::allocate(std::vector<double> &block_dwt, double qwavmax,
+                            tools::modelResult &model, int bitbudget,
+                            std::vector<double> &block_dwt_quant, std::vector<int> &bitalloc) {
+
+  block_dwt_quant.assign(block_dwt.size(), 0);
+  bitalloc.assign(book.size(), 0);
+  relativeMagnitude.assign(block_dwt.size(), 0);
+  if (qwavmax != 0) {
+    for (size_t i = 0; i < block_dwt.size(); i++) {
+      relativeMagnitude[i] = fabs(block_dwt[i]) / qwavmax;
+    }
+  }
+  int bitalloc_sum = 0;
+  const size_t last = book.size() - 1;
+  const int dwtlevel = (int)last;
+
+  // The coefficients are quantized to zero before any bit is allocated
+  int i = 0;
+  for (size_t band = 0; band < book.size(); band++) {
+    noiseenergy[band] = 0;
+    for (; i < book_cumulative[band + 1]; i++) {
+      noiseenergy[band] += block_dwt[i] * block_dwt[i];
+    }
+    updateMNR(model, bitalloc, band);
+    heap[band] = band;
+    heapPosition[band] = band;
+  }
+  for (size_t position = heap.size() / 2; position > 0; position--) {
+    siftDown(position - 1);
+  }
+
+  if (bitbudget > ((int)book.size() * spiht::MAXBITS)) {
+    bitbudget = ((int)book.size() * spiht::MAXBITS);
+  }
+
+  while (bitalloc_sum < bitbudget) {
+    size_t index = lowestMNRBand();
+    // Once the other bands are full, the last band gets the remaining bits at once
+    if (bitalloc_sum - bitalloc[last] >= spiht::MAXBITS * dwtlevel) {
+      int temp = bitalloc[last];
+      bitalloc[last] = bitbudget - spiht::MAXBITS * dwtlevel;
+      bitalloc_sum += bitalloc[last] - temp;
+      updateMNR(model, bitalloc, last);
+      reposition(last);
+    } else {
+      bitalloc[index]++;
+      bitalloc_sum++;
+    }
+
+    noiseenergy[index] = quantizeBand(block_dwt, qwavmax, bitalloc[index], index, block_dwt_quant);
+    updateMNR(model, bitalloc, index);
+    reposition(index);
+  }
+}
+
+auto BitAllocator::quantizeBand(std::vector<double> &block_dwt, double qwavmax, int bits,
+                                size_t band, std::vector<double> &block_dwt_quant) const
+    -> double {
+
+  // Same quantization as WaveletEncoder::uniformQuant, |x| / delta being computed as the
+  // magnitude relative to qwavmax scaled by 2^bits, which is exact
+  double noise = 0;
+  if (qwavmax == 0) {
+    for (int i = book_cumulative[band]; i < book_cumulative[band + 1]; i++) {
+      block_dwt_quant[i] = 0;
+      noise += block_dwt[i] * block_dwt[i];
+    }
+    return noise;
+  }
+  const double levels = (double)(1 << bits);
+  const double delta = qwavmax / (1 << bits);
+  const double max_q = delta * ((1 << bits) - 1);
+  for (int i = book_cumulative[band]; i < book_cumulative[band + 1]; i++) {
+    const double sign = (double)(0 < block_dwt[i]) - (double)(block_dwt[i] < 0);
+    const double level = relativeMagnitude[i] * levels + QUANT_ADD;
+    // The level is positive, so that a truncation rounds it down as floor does
+    const double rounded = level < TRUNCATION_LIMIT ? (double)(int64_t)level : floor(level);
+    double q = sign * delta * rounded;
+    if (fabs(q) > max_q) {
+      q = sign * max_q;
+    }
+    block_dwt_quant[i] = q;
+    const double difference = block_dwt[i] - q;
+    noise += difference * difference;
+  }
+  return noise;
+}
+
+void BitAllocator::updateMNR(tools::modelResult &model, std::vector<int> &bitalloc, size_t band) {
+
+  if (bitalloc[band] >= spiht::MAXBITS) {
+    MNR[band] = INFINITY;
+  } else {
+    const double SNR = LOGFACTOR * log10(model.bandenergy[band] / noiseenergy[band]);
+    MNR[band] = SNR - model.SMR[band];
+  }
+}
+
+void BitAllocator::reposition(size_t band) {
+  siftUp(heapPosition[band]);
+  siftDown(heapPosition[band]);
+}
+
+auto BitAllocator::lowestMNRBand() const -> size_t {
+  // A NaN first value is kept by the linear search, whatever the other values
+  if (std::isnan(MNR[0])) {
+    return 0;
+  }
+  return heap[0];
+}
+
+auto BitAllocator::precedes(size_t band1, size_t band2) const -> bool {
+  if (MNR[band1] < MNR[band2]) {
+    return true;
+  }
+  if (MNR[band2] < MNR[band1]) {
+    return false;
+  }
+  if (std::isnan(MNR[band1]) != std::isnan(MNR[band2])) {
+    return std::isnan(MNR[band2]);
+  }
+  return band1 < band2;
+}
+
+void BitAllocator::siftUp(size_t position) {
+  while (position > 0) {
+    const size_t parent = (position - 1) / 2;
+    if (!precedes(heap[position], heap[parent])) {
+      break;
+    }
+    swapHeapEntries(position, parent);
+    position = parent;
+  }
+}
+
+void BitAllocator::siftDown(size_t position) {
+  while (true) {
+    const size_t left = 2 * position + 1;
+    const size_t right = left + 1;
+    size_t first = position;
+    if (left < heap.size() && precedes(heap[left], heap[first])) {
+      first = left;
+    }
+    if (right < heap.size() && precedes(heap[right], heap[first])) {
+      first = right;
+    }
+    if (first == position) {
+      break;
+    }
+    swapHeapEntries(position, first);
+    position = first;
+  }
+}
+
+void BitAllocator::swapHeapEntries(size_t position1, size_t position2) {
+  std::swap(heap[position1], heap[position2]);
+  heapPosition[heap[position1]] = position1;
+  heapPosition[heap[position2]] = position2;
+}
+
+} // namespace haptics::encoder
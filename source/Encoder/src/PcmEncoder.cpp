@@ -128,7 +128,8 @@ auto PcmEncoder::encode(std::string &filename, EncodingConfig &config, const uns
       }
       waveletBand = Band();
       if (waveletEnc.encodeSignal(signal_wavelet, config.wavelet_bitbudget,
-                                  config.curveFrequencyLimit, waveletBand, timescale)) {
+                                  config.curveFrequencyLimit, waveletBand, timescale,
+                                  config.threadCount)) {
         myChannel.addBand(waveletBand);
       }
       myChannel.setFrequencySampling(wavParser.getSamplerate());
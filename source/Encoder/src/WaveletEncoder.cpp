@@ -32,6 +32,10 @@
  */
 
 #include "../include/WaveletEncoder.h"
+#include "Tools/include/ThreadPool.h"
+
+#include <algorithm>
+#include <memory>
 
 namespace haptics::encoder {
 
@@ -50,35 +54,54 @@ WaveletEncoder::WaveletEncoder(int bl_new, int fs_new)
     book[i] = book[i - 1] << 1;
     book_cumulative[i + 1] = book_cumulative[i] << 1;
   }
+  bitAllocator = BitAllocator(book, book_cumulative);
 }
 
 auto WaveletEncoder::encodeSignal(std::vector<double> &sig_time, int bitbudget, double f_cutoff,
-                                  Band &band, const unsigned int timescale) -> bool {
-  int numBlocks = (int)ceil((double)sig_time.size() / (double)bl);
+                                  Band &band, const unsigned int timescale, size_t threadCount)
+    -> bool {
+  size_t numBlocks = (sig_time.size() + bl - 1) / bl;
   band.setBandType(BandType::WaveletWave);
   band.setLowerFrequencyLimit((int)f_cutoff);
   band.setUpperFrequencyLimit((int)fs);
   band.setBlockLength(bl * static_cast<int>(timescale) / fs);
-  int pos_effect = 0;
-  long add_start = 0;
-  unsigned int add_end = bl;
-  for (int b = 0; b < numBlocks; b++) {
-    Effect effect;
+  const int blockLength = (int)band.getBlockLength().value();
+
+  std::vector<Effect> effects(numBlocks);
+  auto encodeBlocks = [&](WaveletEncoder &encoder, size_t first, size_t last) {
     std::vector<double> block_time(bl, 0);
-    if (add_end > sig_time.size()) {
-      add_end = (long)sig_time.size();
+    for (size_t b = first; b < last; b++) {
+      const size_t add_start = b * bl;
+      const size_t add_end = std::min(add_start + bl, sig_time.size());
+      std::fill(std::copy(sig_time.begin() + static_cast<long>(add_start),
+                          sig_time.begin() + static_cast<long>(add_end), block_time.begin()),
+                block_time.end(), 0);
+
+      double scalar = 0;
+      int maxbits = 0;
+      encoder.encodeBlock(block_time, bitbudget, scalar, maxbits,
+                          effects[b].getWaveletBitstream());
+      effects[b].setPosition(static_cast<int>(b) * blockLength);
     }
-    std::copy(sig_time.begin() + add_start, sig_time.begin() + add_end, block_time.begin());
-
-    double scalar = 0;
-    int maxbits = 0;
-    encodeBlock(block_time, bitbudget, scalar, maxbits, effect.getWaveletBitstream());
+  };
+
+  threadCount = std::max<size_t>(std::min(threadCount, numBlocks), 1);
+  if (threadCount == 1) {
+    encodeBlocks(*this, 0, numBlocks);
+  } else {
+    std::vector<std::unique_ptr<WaveletEncoder>> encoders;
+    encoders.reserve(threadCount);
+    for (size_t t = 0; t < threadCount; t++) {
+      encoders.push_back(std::make_unique<WaveletEncoder>(bl, fs));
+    }
+    tools::ThreadPool pool(threadCount);
+    pool.parallelFor(threadCount, [&](size_t t) {
+      encodeBlocks(*encoders[t], numBlocks * t / threadCount, numBlocks * (t + 1) / threadCount);
+    });
+  }
 
-    effect.setPosition(pos_effect);
+  for (auto &effect : effects) {
     band.addEffect(effect);
-    pos_effect += (int)band.getBlockLength().value();
-    add_start += bl;
-    add_end += bl;
   }
   return true;
 }
@@ -86,18 +109,13 @@ auto WaveletEncoder::encodeSignal(std::vector<double> &sig_time, int bitbudget,
 void WaveletEncoder::encodeBlock(std::vector<double> &block_time, int bitbudget, double &scalar,
                                  int &maxbits, std::vector<unsigned char> &bitstream) {
 
-  std::vector<double> block_dwt(bl, 0);
-  Wavelet wavelet;
-  wavelet.DWT(block_time, dwtlevel, block_dwt);
+  std::vector<double> block_dwt(block_time.begin(), block_time.end());
+  wavelet.DWT(block_dwt, dwtlevel);
   modelResult pm_result = pm.getSMR(block_time);
 
   std::vector<double> block_dwt_quant(bl, 0);
   std::vector<int> block_intquant(bl, 0);
-  std::vector<double> SNR(book.size(), 0);
-  std::vector<double> MNR(book.size(), 0);
-  std::vector<double> noiseenergy(book.size(), 0);
   std::vector<int> bitalloc(book.size(), 0);
-  int bitalloc_sum = 0;
 
   double qwavmax = 0;
   std::vector<unsigned char> bitwavmax;
@@ -105,46 +123,7 @@ void WaveletEncoder::encodeBlock(std::vector<double> &block_time, int bitbudget,
   maximumWaveletCoefficient(block_dwt, qwavmax, bitwavmax);
 
   // Quantization
-  int i = 0;
-  for (uint32_t block = 0; block < book.size(); block++) {
-    bitalloc[block] = 0;
-    noiseenergy[block] = 0;
-    for (; i < book_cumulative[block + 1]; i++) {
-      noiseenergy[block] += pow(block_dwt[i] - block_dwt_quant[i], 2);
-    }
-  }
-
-  if (bitbudget > ((int)book.size() * spiht::MAXBITS)) {
-    bitbudget = ((int)book.size() * spiht::MAXBITS);
-  }
-
-  while (bitalloc_sum < bitbudget) {
-
-    updateNoise(pm_result.bandenergy, noiseenergy, SNR, MNR, pm_result.SMR);
-    for (uint32_t i = 0; i < book.size(); i++) {
-      if (bitalloc[i] >= spiht::MAXBITS) {
-        MNR[i] = INFINITY;
-      }
-    }
-    size_t index = findMinInd(MNR);
-    if (bitalloc_sum - bitalloc[book.size() - 1] >= spiht::MAXBITS * dwtlevel) {
-      int temp = bitalloc[book.size() - 1];
-      bitalloc[book.size() - 1] = bitbudget - spiht::MAXBITS * dwtlevel;
-      bitalloc_sum += bitalloc[book.size() - 1] - temp;
-    } else {
-      bitalloc[index]++;
-      bitalloc_sum++;
-    }
-
-    uniformQuant(block_dwt, book_cumulative[index], qwavmax, bitalloc[index], book[index],
-                 block_dwt_quant);
-
-    noiseenergy[index] = 0;
-    int i = book_cumulative[index];
-    for (; i < book_cumulative[index + 1]; i++) {
-      noiseenergy[index] += pow(block_dwt[i] - block_dwt_quant[i], 2);
-    }
-  }
+  bitAllocator.allocate(block_dwt, qwavmax, pm_result, bitbudget, block_dwt_quant, bitalloc);
 
   // scale signal to int values
   int bitmax = findMax(bitalloc);
@@ -189,16 +168,6 @@ void WaveletEncoder::maximumWaveletCoefficient(double qwavmax,
   Spiht_Enc::setBitwavmax(qwavmax, integerpart, m, bitwavmax);
 }
 
-void WaveletEncoder::updateNoise(std::vector<double> &bandenergy, std::vector<double> &noiseenergy,
-                                 std::vector<double> &SNR, std::vector<double> &MNR,
-                                 std::vector<double> &SMR) {
-
-  for (uint32_t i = 0; i < book.size(); i++) {
-    SNR[i] = LOGFACTOR * log10(bandenergy[i] / noiseenergy[i]);
-    MNR[i] = SNR[i] - SMR[i];
-  }
-}
-
 void WaveletEncoder::uniformQuant(std::vector<double> &in, size_t start, double max, int bits,
                                   size_t length, std::vector<double> &out) {
   double delta = max / (1 << bits);
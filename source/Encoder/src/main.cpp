@@ -97,6 +97,9 @@ auto help() -> void {
          "band for the whole frequency spectrum. This argument will only affect PCM input content."
       << std::endl
       << "\t-ts, \t\t\tspecify the timescale" << std::endl
+      << "\t--threads <THREADS>\t\tnumber of threads used to encode the wavelet bands (default "
+         "1). If the value is set to zero, all the hardware threads are used."
+      << std::endl
       << std::endl;
 }
 
@@ -156,6 +159,15 @@ auto main(int argc, char *argv[]) -> int {
   bool enable_wavelet = !inputParser.cmdOptionExists("--disable-wavelet");
   bool enable_vectorial = !inputParser.cmdOptionExists("--disable-vectorial");
 
+  const std::optional<size_t> threadCount = inputParser.getThreadCount("--threads");
+  if (!threadCount.has_value()) {
+    help();
+    return EXIT_FAILURE;
+  }
+  if (inputParser.cmdOptionExists("--threads")) {
+    std::cout << "The number of threads used will be : " << *threadCount << "\n";
+  }
+
   Haptics hapticFile;
   if (inputParser.cmdOptionExists("-ts")) {
     hapticFile.setTimescale(std::stoi(inputParser.getCmdOption("-ts")));
@@ -227,6 +239,7 @@ auto main(int argc, char *argv[]) -> int {
           config = haptics::encoder::EncodingConfig::generateDefaultConfig(enable_wavelet,
                                                                            enable_vectorial);
         }
+        config.threadCount = *threadCount;
         codeExit =
             PcmEncoder::encode(filename, config, hapticFile.getTimescaleOrDefault(), myPerception);
       }
@@ -267,6 +280,7 @@ auto main(int argc, char *argv[]) -> int {
       config =
           haptics::encoder::EncodingConfig::generateDefaultConfig(enable_wavelet, enable_vectorial);
     }
+    config.threadCount = *threadCount;
     codeExit =
         PcmEncoder::encode(filename, config, hapticFile.getTimescaleOrDefault(), myPerception);
     hapticFile.addPerception(myPerception);
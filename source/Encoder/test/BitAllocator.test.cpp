@@ -0,0 +1,161 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Encoder/include/BitAllocator.h>
+#include <Encoder/include/WaveletEncoder.h>
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using haptics::encoder::BitAllocator;
+using haptics::encoder::WaveletEncoder;
+
+namespace {
+constexpr int BL = 512;
+constexpr int FS = 8000;
+constexpr int DWT_LEVEL = 7;
+
+// Former allocation loop of WaveletEncoder::encodeBlock, updating the MNR of every band and
+// searching for the lowest one for each bit
+void referenceAllocation(std::vector<double> &block_dwt, double qwavmax, modelResult &model,
+                         int bitbudget, std::vector<double> &block_dwt_quant,
+                         std::vector<int> &bitalloc) {
+  const std::vector<int> book = {4, 4, 8, 16, 32, 64, 128, 256};
+  const std::vector<int> book_cumulative = {0, 4, 8, 16, 32, 64, 128, 256, 512};
+  std::vector<double> noiseenergy(book.size(), 0);
+  std::vector<double> MNR(book.size(), 0);
+  block_dwt_quant.assign(BL, 0);
+  bitalloc.assign(book.size(), 0);
+  int bitalloc_sum = 0;
+  auto noise = [&](size_t band) {
+    noiseenergy[band] = 0;
+    for (int i = book_cumulative[band]; i < book_cumulative[band + 1]; i++) {
+      const double difference = block_dwt[i] - block_dwt_quant[i];
+      noiseenergy[band] += difference * difference;
+    }
+  };
+  for (size_t band = 0; band < book.size(); band++) {
+    noise(band);
+  }
+  bitbudget = std::min(bitbudget, (int)book.size() * haptics::spiht::MAXBITS);
+  while (bitalloc_sum < bitbudget) {
+    for (size_t band = 0; band < book.size(); band++) {
+      MNR[band] = LOGFACTOR * log10(model.bandenergy[band] / noiseenergy[band]) - model.SMR[band];
+      if (bitalloc[band] >= haptics::spiht::MAXBITS) {
+        MNR[band] = INFINITY;
+      }
+    }
+    size_t index = WaveletEncoder::findMinInd(MNR);
+    if (bitalloc_sum - bitalloc.back() >= haptics::spiht::MAXBITS * DWT_LEVEL) {
+      bitalloc_sum += bitbudget - haptics::spiht::MAXBITS * DWT_LEVEL - bitalloc.back();
+      bitalloc.back() = bitbudget - haptics::spiht::MAXBITS * DWT_LEVEL;
+    } else {
+      bitalloc[index]++;
+      bitalloc_sum++;
+    }
+    WaveletEncoder::uniformQuant(block_dwt, book_cumulative[index], qwavmax, bitalloc[index],
+                                 book[index], block_dwt_quant);
+    noise(index);
+  }
+}
+} // namespace
+
+TEST_CASE("BitAllocator::allocate", "[BitAllocator]") {
+  const std::vector<int> book = {4, 4, 8, 16, 32, 64, 128, 256};
+  const std::vector<int> book_cumulative = {0, 4, 8, 16, 32, 64, 128, 256, 512};
+  BitAllocator allocator(book, book_cumulative);
+  PsychohapticModel model(BL, FS);
+  Wavelet wavelet;
+  std::mt19937 generator(23); // NOLINT
+  std::normal_distribution<double> noise(0, .05);
+
+  // Tonal and noisy block, silent block, and block of few coefficients exactly quantized
+  std::vector<std::vector<double>> blocks(3, std::vector<double>(BL, 0));
+  for (int i = 0; i < BL; i++) {
+    blocks[0][i] = .5 * sin(.07 * i) + noise(generator); // NOLINT
+    blocks[2][i] = i % 7 == 0 ? .25 : 0;                 // NOLINT
+  }
+  for (std::vector<double> &block : blocks) {
+    std::vector<double> block_dwt = block;
+    wavelet.DWT(block_dwt, DWT_LEVEL);
+    modelResult result = model.getSMR(block);
+    double qwavmax = 0;
+    std::vector<unsigned char> bitwavmax;
+    WaveletEncoder::maximumWaveletCoefficient(block_dwt, qwavmax, bitwavmax);
+    for (int bitbudget : {0, 1, 17, 60, 119, 120, 200}) { // NOLINT
+      std::vector<double> quant;
+      std::vector<int> bitalloc;
+      allocator.allocate(block_dwt, qwavmax, result, bitbudget, quant, bitalloc);
+      std::vector<double> expectedQuant;
+      std::vector<int> expectedBitalloc;
+      referenceAllocation(block_dwt, qwavmax, result, bitbudget, expectedQuant, expectedBitalloc);
+      CHECK(bitalloc == expectedBitalloc);
+      CHECK(quant == expectedQuant);
+    }
+  }
+
+  // Silent bands without energy, the first and fifth ones, whose MNR is undefined, and silent
+  // bands with energy, the fourth and sixth ones, whose MNR is infinite
+  std::vector<double> coefficients(BL);
+  for (int i = 0; i < BL; i++) {
+    coefficients[i] = i < 4 || (i >= 16 && i < 128) ? 0 : noise(generator); // NOLINT
+  }
+  modelResult synthetic;
+  synthetic.bandenergy = {0, 1, 2, 1e-3, 0, 4, 1, 3}; // NOLINT
+  synthetic.SMR = {0, 10, 12, 40, 30, 0, 20, 20};     // NOLINT
+  for (int bitbudget : {1, 17, 60, 106, 119, 120, 200}) { // NOLINT
+    std::vector<double> quant;
+    std::vector<int> bitalloc;
+    allocator.allocate(coefficients, 1, synthetic, bitbudget, quant, bitalloc);
+    std::vector<double> expectedQuant;
+    std::vector<int> expectedBitalloc;
+    referenceAllocation(coefficients, 1, synthetic, bitbudget, expectedQuant, expectedBitalloc);
+    CHECK(bitalloc == expectedBitalloc);
+    CHECK(quant == expectedQuant);
+  }
+
+  std::vector<double> block_dwt = blocks[0];
+  wavelet.DWT(block_dwt, DWT_LEVEL);
+  modelResult result = model.getSMR(blocks[0]);
+  std::vector<double> quant;
+  std::vector<int> bitalloc;
+  allocator.allocate(block_dwt, 1, result, 60, quant, bitalloc); // NOLINT
+  int sum = 0;
+  for (int bits : bitalloc) {
+    CHECK(bits <= haptics::spiht::MAXBITS);
+    sum += bits;
+  }
+  CHECK(sum == 60); // NOLINT
+}
@@ -0,0 +1,74 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Encoder/include/WaveletEncoder.h>
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <vector>
+
+using haptics::encoder::WaveletEncoder;
+using haptics::types::Band;
+
+namespace {
+constexpr int FS = 8000;
+constexpr int BL = 128;
+constexpr int BITS = 90;
+constexpr double F_CUTOFF = 72;
+constexpr unsigned int TIMESCALE = 1000;
+} // namespace
+
+TEST_CASE("WaveletEncoder::encodeSignal with several threads", "[encodeSignal]") {
+  constexpr size_t SIGNAL_LENGTH = 20 * BL + BL / 3;
+  constexpr double FREQUENCY = 150;
+  std::vector<double> sig_time(SIGNAL_LENGTH, 0);
+  for (size_t i = 0; i < SIGNAL_LENGTH; i++) {
+    sig_time[i] = sin(2 * M_PI * FREQUENCY * (double)i / FS) * (double)(i % BL) / BL;
+  }
+
+  WaveletEncoder enc(BL, FS);
+  Band serial;
+  REQUIRE(enc.encodeSignal(sig_time, BITS, F_CUTOFF, serial, TIMESCALE));
+  REQUIRE(serial.getEffectsSize() > 1);
+
+  for (size_t threadCount : {2, 3, 8, 64}) {
+    Band parallel;
+    REQUIRE(enc.encodeSignal(sig_time, BITS, F_CUTOFF, parallel, TIMESCALE, threadCount));
+    REQUIRE(parallel.getEffectsSize() == serial.getEffectsSize());
+    for (int e = 0; e < (int)serial.getEffectsSize(); e++) {
+      CHECK(parallel.getEffectAt(e).getPosition() == serial.getEffectAt(e).getPosition());
+      CHECK(parallel.getEffectAt(e).getWaveletBitstream() ==
+            serial.getEffectAt(e).getWaveletBitstream());
+    }
+  }
+}
@@ -54,11 +54,24 @@ constexpr double HP_2 = 0.040689417609559;
 constexpr double HP_3 = -0.064538882628938;
 constexpr size_t HP_SIZE = 7;
 
+// 9/7 wavelet transform of the filter pair above, coefficients of each level being stored low-pass
+// first. The transforms are computed with the lifting scheme on the even and odd samples, which
+// only computes the decimated outputs of the filters and gives the same results up to rounding.
+// The boundaries are extended symmetrically as by symconv1D.
 class Wavelet {
 public:
   void DWT(std::vector<double> &in, int levels, std::vector<double> &out);
   void inv_DWT(std::vector<double> &in, int levels, std::vector<double> &out);
+  // Single precision version of inv_DWT. The reconstruction error is of the order of 1e-7
+  // relative to the signal amplitude.
+  void inv_DWT(std::vector<float> &in, int levels, std::vector<float> &out);
+  // In place versions, data holding the input and receiving the output. No memory is allocated
+  // once the object has transformed a block of the same length.
+  void DWT(std::vector<double> &data, int levels);
+  void inv_DWT(std::vector<double> &data, int levels);
+  void inv_DWT(std::vector<float> &data, int levels);
 
+  // Reference convolutions with symmetric extension, the output having the length of the input
   template <size_t hSize>
   static void symconv1D(std::vector<double> &in, std::array<double, hSize> &h,
                         std::vector<double> &out);
@@ -70,10 +83,12 @@ public:
                      std::vector<double> &out);
 
 private:
-  std::array<double, LP_SIZE> lp = {LP_4, LP_3, LP_2, LP_1, LP_0, LP_1, LP_2, LP_3, LP_4};
-  std::array<double, HP_SIZE> hp = {HP_3, HP_2, HP_1, HP_0, HP_1, HP_2, HP_3};
-  std::array<double, HP_SIZE> lpr = {HP_3, -HP_2, HP_1, -HP_0, HP_1, -HP_2, HP_3};
-  std::array<double, LP_SIZE> hpr = {-LP_4, LP_3, -LP_2, LP_1, -LP_0, LP_1, -LP_2, LP_3, -LP_4};
+  template <typename T> static void forwardLevel(T *data, size_t length, T *odd);
+  template <typename T> static void inverseLevel(T *data, size_t length, T *low);
+
+  // Odd samples of the level being transformed
+  std::vector<double> scratch;
+  std::vector<float> scratchFloat;
 };
 } // namespace haptics::filterbank
 #endif // WAVELET_H
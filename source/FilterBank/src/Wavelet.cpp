@@ -33,48 +33,110 @@
 
 #include <FilterBank/include/Wavelet.h>
 #include <algorithm>
+#include <cmath>
 
 namespace haptics::filterbank {
 
-void Wavelet::DWT(std::vector<double> &in, int levels, std::vector<double> &out) {
+namespace {
+
+// Lifting factorization of the filter pair: the odd samples are predicted from the even ones and
+// the even samples updated from the odd ones, twice, the two phases being then scaled
+constexpr double PREDICT_1 = -1.586134342059924;
+constexpr double UPDATE_1 = -0.052980118572961;
+constexpr double PREDICT_2 = 0.882911075530934;
+constexpr double UPDATE_2 = 0.443506852043971;
+constexpr double LIFTING_SCALE = 1.230174104914001;
+constexpr double LOW_GAIN = M_SQRT2 / LIFTING_SCALE;
+constexpr double HIGH_GAIN = -LIFTING_SCALE / M_SQRT2;
+
+// odd[n] += c * (even[n] + even[n + 1]), even[half] being mirrored to even[half - 1]
+template <typename T> void predict(const T *even, T *odd, size_t half, T c) {
+  for (size_t n = 0; n + 1 < half; n++) {
+    odd[n] += c * (even[n] + even[n + 1]);
+  }
+  odd[half - 1] += c * (even[half - 1] + even[half - 1]);
+}
 
-  out.resize(in.size());
-  std::vector<double> x(in.begin(), in.end());
-  for (int i = 0; i < levels; i++) {
-    auto len = in.size() >> i;
-    std::vector<double> l(len, 0);
-    std::vector<double> h(len, 0);
-
-    std::vector<double> x_temp(len, 0);
-    std::copy(x.begin(), x.begin() + (long long)len, x_temp.begin());
-    symconv1D(x_temp, hp, h);
-    symconv1D(x_temp, lp, l);
-
-    auto out_ind = 0;
-    auto out_add = len >> 1;
-    for (uint32_t j = 0; j < len; j += 2) {
-      out[out_ind] = l[j];
-      out[out_ind + out_add] = h[j + 1];
-      x[out_ind] = l[j];
-      out_ind++;
-    }
+// even[n] += c * (odd[n - 1] + odd[n]), odd[-1] being mirrored to odd[0]
+template <typename T> void update(T *even, const T *odd, size_t half, T c) {
+  even[0] += c * (odd[0] + odd[0]);
+  for (size_t n = 1; n < half; n++) {
+    even[n] += c * (odd[n - 1] + odd[n]);
   }
 }
 
+} // namespace
+
+void Wavelet::DWT(std::vector<double> &in, int levels, std::vector<double> &out) {
+  out.assign(in.begin(), in.end());
+  DWT(out, levels);
+}
+
 void Wavelet::inv_DWT(std::vector<double> &in, int levels, std::vector<double> &out) {
+  out.assign(in.begin(), in.end());
+  inv_DWT(out, levels);
+}
+
+void Wavelet::inv_DWT(std::vector<float> &in, int levels, std::vector<float> &out) {
+  out.assign(in.begin(), in.end());
+  inv_DWT(out, levels);
+}
 
-  std::copy(in.begin(), in.end(), out.begin());
+void Wavelet::DWT(std::vector<double> &data, int levels) {
+  scratch.resize(data.size() / 2);
+  for (int i = 0; i < levels; i++) {
+    forwardLevel(data.data(), data.size() >> i, scratch.data());
+  }
+}
 
+void Wavelet::inv_DWT(std::vector<double> &data, int levels) {
+  scratch.resize(data.size() / 2);
   for (int i = levels - 1; i >= 0; i--) {
-    auto len = in.size() >> i;
-    std::vector<double> l(len, 0);
-    std::vector<double> h(len, 0);
-    for (uint32_t j = 0; j < len; j += 2) {
-      l[j] = out[j / 2];
-      h[j + 1] = out[j / 2 + (len / 2)];
-    }
-    symconv1D(h, hpr, out);
-    symconv1DAdd(l, lpr, out);
+    inverseLevel(data.data(), data.size() >> i, scratch.data());
+  }
+}
+
+void Wavelet::inv_DWT(std::vector<float> &data, int levels) {
+  scratchFloat.resize(data.size() / 2);
+  for (int i = levels - 1; i >= 0; i--) {
+    inverseLevel(data.data(), data.size() >> i, scratchFloat.data());
+  }
+}
+
+template <typename T> void Wavelet::forwardLevel(T *data, size_t length, T *odd) {
+  const size_t half = length / 2;
+  // Even samples are gathered at the beginning of data, odd ones in odd
+  for (size_t n = 0; n < half; n++) {
+    odd[n] = data[2 * n + 1];
+    data[n] = data[2 * n];
+  }
+  predict(data, odd, half, static_cast<T>(PREDICT_1));
+  update(data, odd, half, static_cast<T>(UPDATE_1));
+  predict(data, odd, half, static_cast<T>(PREDICT_2));
+  update(data, odd, half, static_cast<T>(UPDATE_2));
+  for (size_t n = 0; n < half; n++) {
+    data[n] *= static_cast<T>(LOW_GAIN);
+    data[half + n] = odd[n] * static_cast<T>(HIGH_GAIN);
+  }
+}
+
+template <typename T> void Wavelet::inverseLevel(T *data, size_t length, T *low) {
+  const size_t half = length / 2;
+  T *high = data + half;
+  for (size_t n = 0; n < half; n++) {
+    low[n] = data[n] * static_cast<T>(1 / LOW_GAIN);
+    high[n] *= static_cast<T>(1 / HIGH_GAIN);
+  }
+  update(low, high, half, static_cast<T>(-UPDATE_2));
+  predict(low, high, half, static_cast<T>(-PREDICT_2));
+  update(low, high, half, static_cast<T>(-UPDATE_1));
+  predict(low, high, half, static_cast<T>(-PREDICT_1));
+  // Samples are interleaved in place: high[n] is read before data[2 * n + 1] is written, and
+  // the samples overwritten before have already been read
+  for (size_t n = 0; n < half; n++) {
+    const T odd = high[n];
+    data[2 * n] = low[n];
+    data[2 * n + 1] = odd;
   }
 }
 
@@ -145,4 +207,12 @@ void Wavelet::conv1D(std::vector<double> &in, std::array<double, hSize> &h,
   }
 }
 
+// Reference convolutions used by the tests
+template void Wavelet::symconv1D(std::vector<double> &in, std::array<double, LP_SIZE> &h,
+                                 std::vector<double> &out);
+template void Wavelet::symconv1D(std::vector<double> &in, std::array<double, HP_SIZE> &h,
+                                 std::vector<double> &out);
+template void Wavelet::symconv1DAdd(std::vector<double> &in, std::array<double, HP_SIZE> &h,
+                                    std::vector<double> &out);
+
 } // namespace haptics::filterbank
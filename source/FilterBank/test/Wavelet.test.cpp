@@ -42,6 +42,50 @@ constexpr size_t bl = 128;
 constexpr int levels = 1;
 constexpr double prec_comparison = 0.00001;
 
+namespace {
+using haptics::filterbank::Wavelet;
+
+// Filter bank implementation of the transforms, filtering at full rate and decimating
+auto referenceDWT(const std::vector<double> &in, int dwtLevels) -> std::vector<double> {
+  using namespace haptics::filterbank; // NOLINT(google-build-using-namespace)
+  std::array<double, LP_SIZE> lp = {LP_4, LP_3, LP_2, LP_1, LP_0, LP_1, LP_2, LP_3, LP_4};
+  std::array<double, HP_SIZE> hp = {HP_3, HP_2, HP_1, HP_0, HP_1, HP_2, HP_3};
+  std::vector<double> out = in;
+  for (int i = 0; i < dwtLevels; i++) {
+    const size_t len = in.size() >> i;
+    std::vector<double> x(out.begin(), out.begin() + static_cast<long>(len));
+    std::vector<double> l(len);
+    std::vector<double> h(len);
+    Wavelet::symconv1D(x, lp, l);
+    Wavelet::symconv1D(x, hp, h);
+    for (size_t j = 0; j < len / 2; j++) {
+      out[j] = l[2 * j];
+      out[len / 2 + j] = h[2 * j + 1];
+    }
+  }
+  return out;
+}
+
+auto referenceInverseDWT(const std::vector<double> &in, int dwtLevels) -> std::vector<double> {
+  using namespace haptics::filterbank; // NOLINT(google-build-using-namespace)
+  std::array<double, HP_SIZE> lpr = {HP_3, -HP_2, HP_1, -HP_0, HP_1, -HP_2, HP_3};
+  std::array<double, LP_SIZE> hpr = {-LP_4, LP_3, -LP_2, LP_1, -LP_0, LP_1, -LP_2, LP_3, -LP_4};
+  std::vector<double> out = in;
+  for (int i = dwtLevels - 1; i >= 0; i--) {
+    const size_t len = in.size() >> i;
+    std::vector<double> l(len, 0);
+    std::vector<double> h(len, 0);
+    for (size_t j = 0; j < len; j += 2) {
+      l[j] = out[j / 2];
+      h[j + 1] = out[j / 2 + len / 2];
+    }
+    Wavelet::symconv1D(h, hpr, out);
+    Wavelet::symconv1DAdd(l, lpr, out);
+  }
+  return out;
+}
+} // namespace
+
 TEST_CASE("haptics::filterbank::Wavelet") {
 
   using haptics::filterbank::Wavelet;
@@ -69,4 +113,58 @@ TEST_CASE("haptics::filterbank::Wavelet") {
 
     CHECK(equal);
   }
+
+  SECTION("inverse DWT in single precision") {
+
+    Wavelet wavelet;
+    std::vector<double> in(bl, 0);
+    std::vector<double> out(bl, 0);
+    for (size_t i = 0; i < bl; i++) {
+      in[i] = sin((double)i * .3) * .8;
+    }
+    const int dwtLevels = 5;
+    wavelet.DWT(in, dwtLevels, out);
+
+    std::vector<double> in_rec(bl, 0);
+    wavelet.inv_DWT(out, dwtLevels, in_rec);
+    std::vector<float> outFloat(out.begin(), out.end());
+    std::vector<float> in_recFloat(bl, 0);
+    wavelet.inv_DWT(outFloat, dwtLevels, in_recFloat);
+
+    for (size_t i = 0; i < bl; i++) {
+      CHECK(std::abs(in_recFloat[i] - in_rec[i]) < prec_comparison);
+    }
+  }
+
+  SECTION("lifting scheme against the filter bank") {
+    const size_t length = 512;
+    const double tolerance = 1e-12;
+    std::vector<double> in(length);
+    for (size_t i = 0; i < length; i++) {
+      in[i] = sin((double)i * .21) * .6 + cos((double)i * 1.7) * .3 + (i % 7 == 0 ? .1 : 0);
+    }
+    Wavelet wavelet;
+    for (int dwtLevels : {1, 3, 6}) {
+      const std::vector<double> expected = referenceDWT(in, dwtLevels);
+      std::vector<double> out;
+      wavelet.DWT(in, dwtLevels, out);
+      std::vector<double> inPlace = in;
+      wavelet.DWT(inPlace, dwtLevels);
+      REQUIRE(out.size() == length);
+      for (size_t i = 0; i < length; i++) {
+        REQUIRE(out[i] == Approx(expected[i]).margin(tolerance));
+        REQUIRE(inPlace[i] == out[i]);
+      }
+
+      const std::vector<double> expectedInverse = referenceInverseDWT(out, dwtLevels);
+      std::vector<double> rec;
+      wavelet.inv_DWT(out, dwtLevels, rec);
+      wavelet.inv_DWT(inPlace, dwtLevels);
+      for (size_t i = 0; i < length; i++) {
+        REQUIRE(rec[i] == Approx(expectedInverse[i]).margin(tolerance));
+        REQUIRE(rec[i] == Approx(in[i]).margin(tolerance));
+        REQUIRE(inPlace[i] == rec[i]);
+      }
+    }
+  }
 }
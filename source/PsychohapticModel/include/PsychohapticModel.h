@@ -35,6 +35,8 @@
 #define PSYCHOHAPTICMODEL_H
 
 #include <algorithm>
+#include <complex>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
@@ -72,6 +74,9 @@ class PsychohapticModel {
 public:
   PsychohapticModel(size_t bl_new, int fs_new);
 
+  // Signal to mask ratios and energies of the bands of the block. The levels in dB are converted
+  // to powers with decibelsToPower, so that the band energies are within DECIBEL_CONVERSION_ERROR
+  // relative error of a conversion with pow, and the ratios within 1e-12 dB.
   auto getSMR(std::vector<double> &block) -> modelResult;
 
   static auto findPeaks(std::vector<double> &spectrum, double min_peak_prominence,
@@ -82,6 +87,11 @@ public:
 private:
   auto globalMaskingThreshold(std::vector<double> &spect) -> std::vector<double>;
   void perceptualThreshold();
+  // Computes the first bl bins of the spectrum of the block zero-padded to 2 * bl samples into
+  // spect_mag, in dB. The real signal is transformed as a complex signal of bl samples, its even
+  // samples as real parts and its odd samples as imaginary parts, whose spectrum is then split.
+  void magnitudeSpectrum(std::vector<double> &block);
+  void fft(std::vector<std::complex<double>> &data);
 
   static auto findAllPeakLocations(std::vector<double> &x) -> peaks;
   static auto peakProminence(std::vector<double> &spectrum, peaks input) -> peaks;
@@ -96,6 +106,21 @@ private:
   std::vector<double> percthres;
   std::vector<int> book;
   std::vector<int> book_cumulative;
+
+  // FFT of bl points: bit-reversed index of each point and twiddle factors exp(-2i.pi.k / bl)
+  std::vector<uint32_t> bitReversal;
+  std::vector<std::complex<double>> twiddles;
+  // Twiddle factors exp(-2i.pi.k / (2 * bl)) combining the spectra of the even and odd samples
+  std::vector<std::complex<double>> splitTwiddles;
+  // Offset of the spectrum in dB, for the scaling of the bins
+  double spectrumOffset = 0;
+  std::vector<std::complex<double>> fftBuffer;
+  std::vector<double> spect_mag;
+  std::vector<double> spectPower;
+  // Parabolas of the masks of the peaks, see peakMask
+  std::vector<double> peakCenters;
+  std::vector<double> peakCurvatures;
+  std::vector<double> peakOffsets;
 };
 } // namespace haptics::tools
 #endif // PSYCHOHAPTICMODEL_H
@@ -32,8 +32,9 @@
  */
 
 #include <PsychohapticModel/include/PsychohapticModel.h>
+#include <Tools/include/SignalKernels.h>
 
-#include <dj_fft.h>
+#include <cmath>
 
 namespace haptics::tools {
 
@@ -64,31 +65,40 @@ PsychohapticModel::PsychohapticModel(size_t bl_new, int fs_new) : bl(bl_new), fs
     book[i] = book[i - 1] << 1;
     book_cumulative[i + 1] = book_cumulative[i] << 1;
   }
-}
-
-auto PsychohapticModel::getSMR(std::vector<double> &block) -> modelResult {
-
-  std::vector<std::complex<double>> block_complex(bl * 2, 0);
-  std::transform(block.begin(), block.end(), block_complex.begin(),
-                 [](double a) { return std::complex<double>(a, 0); });
 
-  std::vector<std::complex<double>> spect_complex = dj::fft1d(block_complex, dj::fft_dir::DIR_FWD);
-
-  std::vector<double> spect_mag;
+  int fftBits = 0;
+  while (((size_t)1 << fftBits) < bl) {
+    fftBits++;
+  }
+  bitReversal.resize(bl);
+  for (uint32_t i = 0; i < bl; i++) {
+    uint32_t reversed = 0;
+    for (int bit = 0; bit < fftBits; bit++) {
+      reversed |= ((i >> bit) & 1U) << (fftBits - 1 - bit);
+    }
+    bitReversal[i] = reversed;
+  }
+  twiddles.resize(bl / 2);
+  for (size_t k = 0; k < twiddles.size(); k++) {
+    twiddles[k] = std::polar(1.0, -2 * M_PI * (double)k / (double)bl);
+  }
+  splitTwiddles.resize(bl);
+  for (size_t k = 0; k < bl; k++) {
+    splitTwiddles[k] = std::polar(1.0, -M_PI * (double)k / (double)bl);
+  }
+  // The bins are computed twice too large, and scaled by 1 / sqrt(bl)
+  spectrumOffset = -(LOGFACTOR_SPECT / 2) * log10(4 * (double)bl);
+  fftBuffer.resize(bl);
   spect_mag.resize(bl);
+  spectPower.resize(bl);
+}
 
-  for (auto &i : spect_complex) {
-    i = i * sqrt(2 * (double)bl);
-  }
+auto PsychohapticModel::getSMR(std::vector<double> &block) -> modelResult {
 
-  static double correction = 1 / sqrt((double)bl);
-  std::transform(spect_complex.begin(), spect_complex.end() - (long long)bl, spect_mag.begin(),
-                 [](std::complex<double> a) {
-                   return LOGFACTOR_SPECT *
-                          log10(correction * sqrt(a.real() * a.real() + a.imag() * a.imag()));
-                 });
+  magnitudeSpectrum(block);
 
   std::vector<double> globalmask = globalMaskingThreshold(spect_mag);
+  decibelsToPower(spect_mag.data(), spectPower.data(), bl);
   modelResult result;
   result.SMR.resize(book.size());
   result.bandenergy.resize(book.size());
@@ -98,7 +108,7 @@ auto PsychohapticModel::getSMR(std::vector<double> &block) -> modelResult {
     result.bandenergy[b] = 0;
     maskenergy[b] = 0;
     for (; i < book_cumulative[b + 1]; i++) {
-      result.bandenergy[b] += pow(base, spect_mag[i] / factor);
+      result.bandenergy[b] += spectPower[i];
       maskenergy[b] += globalmask[i];
     }
     result.SMR[b] = factor * log10(result.bandenergy[b] / maskenergy[b]);
@@ -106,6 +116,53 @@ auto PsychohapticModel::getSMR(std::vector<double> &block) -> modelResult {
   return result;
 }
 
+void PsychohapticModel::magnitudeSpectrum(std::vector<double> &block) {
+
+  // The block is zero-padded to 2 * bl samples: x[2n] + i.x[2n + 1] is 0 from n = bl / 2 on
+  const size_t length = std::min(block.size(), 2 * bl);
+  for (size_t n = 0; n < bl; n++) {
+    const double even = 2 * n < length ? block[2 * n] : 0;
+    const double odd = 2 * n + 1 < length ? block[2 * n + 1] : 0;
+    fftBuffer[bitReversal[n]] = std::complex<double>(even, odd);
+  }
+  fft(fftBuffer);
+
+  // With Z the spectrum of the complex signal, the spectra of the even and odd samples are
+  // (Z[k] + conj(Z[bl - k])) / 2 and (Z[k] - conj(Z[bl - k])) / 2i. Twice the bin k of the padded
+  // block combines them. The magnitude, scaling and conversion to dB are done on the power.
+  for (size_t k = 0; k < bl; k++) {
+    const std::complex<double> z = fftBuffer[k];
+    const std::complex<double> mirror = fftBuffer[(bl - k) & (bl - 1)];
+    const double evenRe = z.real() + mirror.real();
+    const double evenIm = z.imag() - mirror.imag();
+    const double oddRe = z.imag() + mirror.imag();
+    const double oddIm = mirror.real() - z.real();
+    const std::complex<double> w = splitTwiddles[k];
+    const double binRe = evenRe + w.real() * oddRe - w.imag() * oddIm;
+    const double binIm = evenIm + w.real() * oddIm + w.imag() * oddRe;
+    spect_mag[k] = (LOGFACTOR_SPECT / 2) * log10(binRe * binRe + binIm * binIm) + spectrumOffset;
+  }
+}
+
+void PsychohapticModel::fft(std::vector<std::complex<double>> &data) {
+  // Iterative radix-2 FFT of data, whose points are in bit-reversed order
+  const size_t size = data.size();
+  for (size_t half = 1; half < size; half <<= 1) {
+    const size_t step = size / (2 * half);
+    for (size_t start = 0; start < size; start += 2 * half) {
+      for (size_t k = 0; k < half; k++) {
+        // Written out, as the complex product of the standard library also handles infinities
+        const std::complex<double> w = twiddles[k * step];
+        const std::complex<double> x = data[start + k + half];
+        const std::complex<double> product(w.real() * x.real() - w.imag() * x.imag(),
+                                           w.real() * x.imag() + w.imag() * x.real());
+        data[start + k + half] = data[start + k] - product;
+        data[start + k] += product;
+      }
+    }
+  }
+}
+
 auto PsychohapticModel::globalMaskingThreshold(std::vector<double> &spect) -> std::vector<double> {
 
   std::vector<double> globalmask(bl, 0);
@@ -118,9 +175,9 @@ auto PsychohapticModel::globalMaskingThreshold(std::vector<double> &spect) -> st
       globalmask[i] = percthres[i]; // percthres is in linear domain
     }
   } else {
+    decibelsToPower(mask.data(), globalmask.data(), bl);
     for (uint32_t i = 0; i < bl; i++) {
-      globalmask[i] = pow(base, mask.at(i) / factor) + percthres[i]; // percthres is in linear
-                                                                     // domain
+      globalmask[i] += percthres[i]; // percthres is in linear domain
     }
   }
 
@@ -336,42 +393,25 @@ auto PsychohapticModel::findPeaks(std::vector<double> &spectrum, double min_peak
 void PsychohapticModel::peakMask(std::vector<double> &peaks_height, std::vector<size_t> &peaks_loc,
                                  std::vector<double> &mask) {
 
+  mask.clear();
   if (peaks_loc.empty()) {
-    mask.clear();
-  } else {
-
-    mask.clear();
-    mask.reserve(bl);
-    double f = freqs[peaks_loc[0]];
-    double sum1 = peaks_height[0] - mask_a + (mask_a / mask_b) * f;
-    double factor1 = -mask_c / (f * f);
-
-    for (size_t i = 0; i < bl; ++i) {
-      double val = freqs[i];
-      val -= f;
-      val *= val;
-
-      val *= factor1;
-      val += sum1;
-      mask.push_back(val);
-    }
-    for (size_t j = 1; j < peaks_loc.size(); j++) {
-      f = freqs[peaks_loc[j]];
-      sum1 = peaks_height[j] - mask_a + (mask_a / mask_b) * f;
-      factor1 = -mask_c / (f * f);
-      for (size_t i = 0; i < bl; ++i) {
-        double val = freqs[i];
-        val -= f;
-        val *= val;
-
-        val *= factor1;
-        val += sum1;
-        if (val > mask[i]) {
-          mask[i] = val;
-        }
-      }
-    }
+    return;
+  }
+  // Each peak masks the bins around it with a parabola in dB, the mask being their upper envelope
+  peakCenters.resize(peaks_loc.size());
+  peakCurvatures.resize(peaks_loc.size());
+  peakOffsets.resize(peaks_loc.size());
+  for (size_t j = 0; j < peaks_loc.size(); j++) {
+    const double f = freqs[peaks_loc[j]];
+    peakCenters[j] = f;
+    peakCurvatures[j] = -mask_c / (f * f);
+    peakOffsets[j] = peaks_height[j] - mask_a + (mask_a / mask_b) * f;
   }
+  mask.resize(bl);
+  computeParabolaEnvelope(freqs.data(),
+                          {peakCenters.data(), peakCurvatures.data(), peakOffsets.data(),
+                           peaks_loc.size()},
+                          mask.data(), bl);
 }
 
 auto PsychohapticModel::max(double v1, double v2) -> double {
@@ -33,6 +33,8 @@
 
 #include <catch2/catch.hpp>
 
+#include <cmath>
+#include <complex>
 #include <iostream>
 #include <vector>
 
@@ -60,3 +62,38 @@ TEST_CASE("haptics::tools::PsychohapticModel") {
     CHECK(p.locations[0] == pos);
   }
 }
+
+TEST_CASE("haptics::tools::PsychohapticModel::getSMR spectrum") {
+
+  using haptics::tools::PsychohapticModel;
+
+  // The energy of band b is the sum over its bins of |X[k]|^2 / bl, X being the spectrum of the
+  // block zero-padded to 2 * bl samples, computed here by a direct DFT.
+  const int blockLength = 64;
+  PsychohapticModel pm(blockLength, fs);
+  std::vector<double> block(blockLength);
+  for (int i = 0; i < blockLength; i++) {
+    block[i] = 0.4 * sin(0.3 * i) + 0.2 * cos(1.7 * i + 0.5) + (double)((i * 7) % 5) / 50;
+  }
+  haptics::tools::modelResult result = pm.getSMR(block);
+
+  const int levels = (int)log2(blockLength / 4);
+  REQUIRE(result.bandenergy.size() == (size_t)levels + 1);
+  std::vector<int> bandEnd(levels + 1, blockLength >> levels);
+  for (int b = 1; b <= levels; b++) {
+    bandEnd[b] = (blockLength >> levels) << b;
+  }
+  int k = 0;
+  for (int b = 0; b <= levels; b++) {
+    double energy = 0;
+    for (; k < bandEnd[b]; k++) {
+      std::complex<double> bin = 0;
+      for (int n = 0; n < blockLength; n++) {
+        bin += block[n] * std::polar(1.0, -M_PI * k * n / blockLength);
+      }
+      energy += std::norm(bin) / blockLength;
+    }
+    CHECK(result.bandenergy[b] == Approx(energy).epsilon(1e-9));
+    CHECK(std::isfinite(result.SMR[b]));
+  }
+}
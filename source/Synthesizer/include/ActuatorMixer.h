@@ -0,0 +1,85 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ACTUATORMIXER_H
+#define ACTUATORMIXER_H
+
+#include <Types/include/Haptics.h>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace haptics::synthesizer {
+
+// Physical actuator driven by an ActuatorMixer
+struct Actuator {
+  // Body parts the actuator lies on, with the bits of Channel::getBodyPartMask
+  uint32_t bodyPartMask = 0;
+  // Position of the actuator in the actuator grid of the device, matched against the actuator
+  // targets of the channels
+  std::optional<types::Vector> position;
+};
+
+// Distributes the signals of the channels of a file to physical actuators, so that each channel
+// is rendered once whatever the number of actuators it drives. The gains form a sparse matrix
+// stored in compressed sparse row format: the gains of actuator a are gains[rowOffsets[a]] to
+// gains[rowOffsets[a + 1] - 1], applied to the channels columns[rowOffsets[a]] and following.
+class ActuatorMixer {
+public:
+  explicit ActuatorMixer() = default;
+  // Builds the matrix from the body parts and actuator targets of the channels, numbered in the
+  // order of the perceptions. A channel drives the actuators lying on one of its body parts, a
+  // channel without body part driving every actuator. When the channel has actuator targets, only
+  // the actuators at these positions are driven. The gain is the mixing weight of the channel.
+  explicit ActuatorMixer(types::Haptics &haptic, const std::vector<Actuator> &actuators);
+
+  // Adds the signal of channel to actuator with the given gain, or changes its gain
+  auto setGain(size_t actuator, size_t channel, double gain) -> void;
+  [[nodiscard]] auto getGain(size_t actuator, size_t channel) const -> double;
+  [[nodiscard]] auto getActuatorCount() const -> size_t;
+  [[nodiscard]] auto getChannelCount() const -> size_t;
+  [[nodiscard]] auto getNonZeroCount() const -> size_t;
+  // Writes the first length samples of every actuator into actuatorAmp, from the signals of the
+  // channels. Each actuator is clamped to [-1, 1]. actuatorAmp must hold getActuatorCount() buffers
+  // of at least length samples, no memory is allocated.
+  auto mix(const std::vector<std::vector<double>> &channelAmp, size_t length,
+           std::vector<std::vector<double>> &actuatorAmp) const -> void;
+
+private:
+  size_t channelCount = 0;
+  std::vector<size_t> rowOffsets = {0};
+  std::vector<size_t> columns;
+  std::vector<double> gains;
+};
+} // namespace haptics::synthesizer
+#endif // ACTUATORMIXER_H
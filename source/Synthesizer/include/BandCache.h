@@ -0,0 +1,165 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BANDCACHE_H
+#define BANDCACHE_H
+
+#include <Types/include/Band.h>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <vector>
+
+namespace haptics::synthesizer {
+
+// Rendered samples of a band read from the cache. Only the samples between the first and the last
+// non-zero ones are stored, the other ones being zero. The file is mapped in memory when the
+// platform allows it, and read otherwise.
+class CachedBand {
+public:
+  CachedBand(const CachedBand &) = delete;
+  CachedBand(CachedBand &&other) noexcept;
+  auto operator=(const CachedBand &) -> CachedBand & = delete;
+  auto operator=(CachedBand &&) -> CachedBand & = delete;
+  ~CachedBand();
+
+  [[nodiscard]] auto data() const -> const float *;
+  [[nodiscard]] auto size() const -> size_t;
+  // Index of the first stored sample, from the origin of the timeline
+  [[nodiscard]] auto getFirstSample() const -> int64_t;
+  // Copies the samples [first, first + count) to out, zero-filling the ones that are not stored
+  template <typename T>
+  auto read(int64_t first, size_t count, T *out) const -> void;
+
+private:
+  friend class BandCache;
+  CachedBand() = default;
+
+  void *mapping = nullptr;
+  size_t mappingLength = 0;
+  std::vector<float> buffer;
+  const float *samples = nullptr;
+  size_t sampleCount = 0;
+  int64_t firstSample = 0;
+};
+
+// Cache file of a band written chunk by chunk, as returned by BandCache::beginStore. Leading and
+// trailing zero samples are not written. The samples are written under a temporary name, commit
+// filling in the header and renaming the file, so that several processes can share the same
+// directory. The temporary file is removed when the writer is destroyed without being committed.
+class CachedBandWriter {
+public:
+  CachedBandWriter(const CachedBandWriter &) = delete;
+  CachedBandWriter(CachedBandWriter &&other) noexcept;
+  auto operator=(const CachedBandWriter &) -> CachedBandWriter & = delete;
+  auto operator=(CachedBandWriter &&) -> CachedBandWriter & = delete;
+  ~CachedBandWriter();
+
+  // Appends the samples to the band
+  auto write(const float *samples, size_t count) -> bool;
+  // Fills in the header with the range of the samples written and renames the file, which can then
+  // be loaded
+  auto commit() -> bool;
+
+private:
+  friend class BandCache;
+  CachedBandWriter() = default;
+
+  std::ofstream file;
+  std::filesystem::path path;
+  std::filesystem::path temporaryPath;
+  uint64_t key = 0;
+  int64_t renderedFirst = 0;
+  int64_t renderedEnd = 0;
+  int64_t firstSample = 0;
+  uint32_t sampleCount = 0;
+  // Zero samples written after the last stored one, stored once a non-zero sample follows them
+  uint64_t pendingZeros = 0;
+};
+
+// Directory of rendered bands, so that synthesizing the same bands again only reads them back.
+// Each band is stored in its own file, named after a hash of everything its samples depend on:
+// the content of the band, including the decoded wavelet samples and the rendered library effects
+// it references, and the sampling frequency and timescale of the synthesis. Samples are indexed
+// from the origin of the timeline, so that the files do not depend on the padding nor on the length
+// of the synthesis, and stored in single precision, in the byte order of the machine.
+class BandCache {
+public:
+  explicit BandCache(std::filesystem::path newDirectory);
+
+  // The padding only contributes through the offset of the samples from the origin of the timeline
+  // that is less than a sample, the files being otherwise shared by every padding
+  [[nodiscard]] auto static getBandKey(types::Band &band, int fs, int pad, unsigned int timescale)
+      -> uint64_t;
+  // Index of the first sample of a synthesis with this padding, from the origin of the timeline
+  [[nodiscard]] auto static getFirstSample(int fs, int pad) -> int64_t;
+  // Samples stored for the key, if there is a valid cache file for it whose samples were rendered
+  // over the range [first, end)
+  [[nodiscard]] auto load(uint64_t key, int64_t first, int64_t end) -> std::optional<CachedBand>;
+  // Starts writing the samples for the key, the first one having the given index, if the
+  // temporary file can be created
+  [[nodiscard]] auto beginStore(uint64_t key, int64_t first) -> std::optional<CachedBandWriter>;
+  // Stores the samples for the key at once, through a CachedBandWriter
+  auto store(uint64_t key, int64_t first, const std::vector<float> &samples) -> bool;
+
+  [[nodiscard]] auto getDirectory() const -> const std::filesystem::path &;
+  [[nodiscard]] auto getHitCount() const -> size_t;
+  [[nodiscard]] auto getMissCount() const -> size_t;
+
+private:
+  friend class CachedBandWriter;
+
+  // Changed whenever the content of the files or the synthesis of the bands changes
+  static constexpr uint32_t FORMAT_VERSION = 2;
+  static constexpr uint32_t MAGIC = 0x43424D48; // "HMBC"
+
+  // The stored samples lie within the rendered ones, the other rendered samples being zero
+  struct FileHeader {
+    uint32_t magic = MAGIC;
+    uint32_t sampleCount = 0;
+    int64_t firstSample = 0;
+    int64_t renderedFirst = 0;
+    int64_t renderedEnd = 0;
+    uint64_t key = 0;
+  };
+
+  [[nodiscard]] auto getPath(uint64_t key) const -> std::filesystem::path;
+
+  std::filesystem::path directory;
+  std::atomic<size_t> hitCount = 0;
+  std::atomic<size_t> missCount = 0;
+};
+} // namespace haptics::synthesizer
+#endif // BANDCACHE_H
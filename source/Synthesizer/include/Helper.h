@@ -34,20 +34,56 @@
 #ifndef HELPER_H
 #define HELPER_H
 
+#include <Synthesizer/include/BandCache.h>
 #include <Types/include/Haptics.h>
+#include <WaveletDecoder/include/WaveletDecoder.h>
 #include <vector>
 
 namespace haptics::synthesizer {
 
+// Number of frames synthesized at once for all the channels before being written
+static constexpr uint32_t SYNTHESIS_CHUNK_LENGTH = 4096;
+
+// Summary of the adaptation of a file to its reference devices by Helper::cullForDevices
+struct DeviceCullingReport {
+  int culledBands = 0;
+  int culledEffects = 0;
+  int lowPassedBands = 0;
+  // Estimated synthesis work, as the sum of the durations of the effects in ticks, before culling
+  // and for the culled bands and effects only
+  double totalWork = 0;
+  double culledWork = 0;
+};
+
 class Helper {
 public:
   [[nodiscard]] auto static getTimeLength(types::Haptics &haptic) -> double;
-  [[nodiscard]] auto static playFile(types::Haptics &haptic, double timeLength, int fs, int pad,
-                                     std::string &filename) -> bool;
+  // Synthesizes the file into a WAV file, chunk by chunk. Bands and channels are rendered on
+  // threadCount threads, the output being identical whatever the number of threads. With a cache,
+  // the bands already rendered with the same content and settings are read from it and the other
+  // ones are stored into it, every band being then rendered in single precision. In single
+  // precision, the blocks of the wavelet bands left encoded are decoded in single precision, and
+  // bands are evaluated and mixed in single precision, each channel being scaled and quantized in
+  // double precision.
+  [[nodiscard]] auto static playFile(
+      types::Haptics &haptic, double timeLength, int fs, int pad, std::string &filename,
+      size_t threadCount = 1, BandCache *cache = nullptr,
+      waveletdecoder::DecodingPrecision precision = waveletdecoder::DecodingPrecision::Double)
+      -> bool;
+  // Adapts the file to the reference device of each channel, as given by its minimum and maximum
+  // frequencies. Bands whose frequency range lies outside of the device range are removed, as well
+  // as vectorial effects whose frequencies all lie outside of it. Wavelet bands whose content goes
+  // beyond the maximum frequency get it as low-pass frequency: their decoded blocks are low-passed
+  // at once, the other ones as they are decoded. Channels without reference device, or whose device
+  // has no frequency range, are left as they are.
+  auto static cullForDevices(types::Haptics &haptic) -> DeviceCullingReport;
 
 private:
   [[nodiscard]] auto static getEffectTimeLength(types::Effect &effect, types::BandType bandType,
                                                 int windowLength) -> double;
+  [[nodiscard]] auto static getEffectWork(types::Effect &effect, types::Band &band,
+                                          unsigned int timescale) -> double;
+  auto static lowPassDecodedBlocks(types::Band &band) -> void;
 };
 } // namespace haptics::synthesizer
 #endif // HELPER_H
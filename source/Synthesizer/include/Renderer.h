@@ -0,0 +1,220 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <Synthesizer/include/ActuatorMixer.h>
+#include <Synthesizer/include/VoicePool.h>
+#include <Types/include/Haptics.h>
+#include <WaveletDecoder/include/WaveletBlockCache.h>
+#include <WaveletDecoder/include/WaveletDecoder.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace haptics::synthesizer {
+
+// Band left out of a render call to stay within the CPU budget. channel follows the numbering of
+// Renderer::render and band is the index of the band in its channel.
+struct DroppedBand {
+  size_t channel = 0;
+  int band = 0;
+};
+
+// Pull-based renderer of a haptic file, meant to be called from a real-time audio or haptic
+// callback. Every buffer is allocated beforehand: render does not allocate memory nor take locks.
+// start, stop and seek may be called from any thread, they are applied at the beginning of the
+// next render call.
+//
+// The rendered file may be replaced during playback with publish or updateChannel, from a single
+// producer thread. The new file is prepared by the producer, render only swapping a pointer at the
+// beginning of its next call. The file it replaces is deleted by the producer on its next update,
+// or by the destructor, so that render never frees memory.
+//
+// The library effects of the file given to the constructor can also be triggered with trigger, as
+// a game would do on events. They are mixed into the output channels by render, the file playing
+// or not.
+class Renderer {
+public:
+  // maxFrames is the largest number of frames requested by a single call to render. Wavelet bands
+  // are decoded with the given precision, beforehand. With a non-zero lazyDecodingBytes, their
+  // blocks are instead decoded by render the first time they are rendered, at most
+  // lazyDecodingBytes of decoded samples being kept. render then allocates memory when it decodes
+  // a block, in exchange for a start-up time which does not depend on the length of the file.
+  // In single precision, the bands of the file are also evaluated and mixed in single precision,
+  // each channel being widened to double precision to be mixed with the triggered effects.
+  explicit Renderer(
+      types::Haptics newHaptic, int newFs, size_t newMaxFrames,
+      waveletdecoder::DecodingPrecision newPrecision = waveletdecoder::DecodingPrecision::Double,
+      size_t newLazyDecodingBytes = 0);
+  Renderer(const Renderer &) = delete;
+  Renderer(Renderer &&) = delete;
+  auto operator=(const Renderer &) -> Renderer & = delete;
+  auto operator=(Renderer &&) -> Renderer & = delete;
+  ~Renderer();
+
+  // Writes frames interleaved frames of the given number of channels into out. The channels of
+  // the file are numbered in the order of the perceptions, output channels without file channel
+  // nor triggered effect are set to zero. Returns the number of frames actually rendered from the
+  // file, the remaining frames of out only holding the triggered effects when the renderer is
+  // stopped or the end of the file is reached.
+  auto render(float *out, size_t frames, size_t channels) -> size_t;
+  // Same as render, the samples being quantized to 16 bits PCM as in the WAV files written by the
+  // synthesizer
+  auto render(int16_t *out, size_t frames, size_t channels) -> size_t;
+  // Outputs the actuators of the mixer instead of the channels of the file, each channel being
+  // rendered once and distributed to its actuators. To be called before rendering starts.
+  auto setActuatorMixer(ActuatorMixer newMixer) -> void;
+  auto start() -> void;
+  auto stop() -> void;
+  // Moves the playback position to the given position, in ticks
+  auto seek(double position) -> void;
+  // Limits the CPU time spent by render to the given number of microseconds every blockFrames
+  // frames. The cost of each band is measured while it is rendered. When the bands would exceed
+  // the budget, the bands of lowest priority are left out, priorities being compared by
+  // perception, then by channel, then by band, a higher value being more important. A zero budget
+  // disables the limit, which is the default.
+  auto setCpuBudget(double microseconds, size_t blockFrames) -> void;
+  // Bands left out by the last call to render. To be called from the thread calling render.
+  [[nodiscard]] auto getDroppedBands() const -> const std::vector<DroppedBand> &;
+  // Renders newHaptic instead of the current file from the next render call on, the playback
+  // position being kept. A file published but not rendered yet is replaced.
+  auto publish(types::Haptics newHaptic) -> void;
+  // Publishes the last published file with the given channel, numbered as in render, replaced by
+  // newChannel. Returns false if there is no such channel.
+  auto updateChannel(size_t channel, const types::Channel &newChannel) -> bool;
+
+  // Plays a library effect of the file given to the constructor from the next render call on, on
+  // the output channels set in channelMask. See VoicePool::trigger. May be called from any thread.
+  auto trigger(int perceptionId, int effectId, uint64_t channelMask, double gain,
+               std::optional<int> priority = std::nullopt) -> bool;
+  [[nodiscard]] auto getActiveVoiceCount() const -> size_t;
+
+  [[nodiscard]] auto isPlaying() const -> bool;
+  // Playback position, in samples
+  [[nodiscard]] auto getSamplePosition() const -> uint32_t;
+  [[nodiscard]] auto getSampleCount() const -> uint32_t;
+  [[nodiscard]] auto getChannelCount() const -> size_t;
+  [[nodiscard]] auto getMaxFrames() const -> size_t;
+
+private:
+  static constexpr uint32_t NO_SEEK = UINT32_MAX;
+  // Number of library effects played at the same time
+  static constexpr size_t DEFAULT_VOICE_COUNT = 256;
+  // Weight of the last measure in the running estimate of the cost of a band
+  static constexpr double COST_SMOOTHING = 0.2;
+
+  struct BandState {
+    size_t channel = 0;
+    int band = 0;
+    // Estimated cost of the band, in microseconds per frame
+    double cost = 0;
+    bool active = true;
+    bool dropped = false;
+  };
+
+  // File prepared for rendering. Once published, it is only accessed by the thread calling render.
+  struct Scene {
+    types::Haptics haptic;
+    unsigned int timescale = 0;
+    uint32_t sampleCount = 0;
+    std::vector<types::Channel *> hapticChannels;
+    std::vector<double> perceptionUnitFactors;
+    // Bands of channel c are bandStates[channelBands[c]] to bandStates[channelBands[c + 1] - 1]
+    std::vector<BandState> bandStates;
+    std::vector<size_t> channelBands;
+    // Indices of bandStates, from the most important band to the least important one
+    std::vector<size_t> bandPriorityOrder;
+    std::vector<DroppedBand> droppedBands;
+    // Scaled channel signals of the current block, when an actuator mixer is set
+    std::vector<std::vector<double>> channelBlocks;
+    // Decoded blocks of the wavelet bands, when they are decoded lazily
+    std::unique_ptr<waveletdecoder::WaveletBlockCache> waveletBlocks;
+    // Next scene in the list of the scenes replaced by render and waiting to be deleted
+    Scene *nextRetired = nullptr;
+  };
+
+  [[nodiscard]] auto makeScene(types::Haptics newHaptic) -> Scene *;
+  // Allocates the channel blocks of the scene for the actuator mixer, if one is set
+  auto sizeChannelBlocks(Scene &prepared) const -> void;
+  auto swapScene() -> void;
+  auto reclaimScenes() -> void;
+  template <typename Sample>
+  auto renderSamples(Sample *out, size_t frames, size_t channels) -> size_t;
+  // Renders the bands of a channel of the current block into channelSamples, scaled by the channel
+  // gain, for the length of bandSamples
+  template <typename T>
+  auto renderChannelBands(Scene &current, size_t channel, uint32_t position, bool budgeted,
+                          std::vector<T> &bandSamples, std::vector<T> &channelSamples) -> void;
+  // Evaluates a band into bandSamples, decoding the wavelet blocks it needs first in lazy mode
+  template <typename T>
+  auto evaluateBand(Scene &current, types::Band &band, uint32_t position,
+                    std::vector<T> &bandSamples) -> void;
+  auto selectBands(size_t renderedChannels) -> void;
+  auto static storeSample(double value, float &sample) -> void;
+  auto static storeSample(double value, int16_t &sample) -> void;
+
+  int fs = 0;
+  size_t maxFrames = 0;
+  waveletdecoder::DecodingPrecision precision = waveletdecoder::DecodingPrecision::Double;
+  size_t lazyDecodingBytes = 0;
+  // Last published file, as given by the producer, to which channel updates are applied
+  types::Haptics publishedHaptic;
+  // Scene being rendered, owned by the renderer
+  Scene *scene = nullptr;
+  std::atomic<Scene *> pendingScene = nullptr;
+  std::atomic<Scene *> retiredScenes = nullptr;
+  // Properties of the scene being rendered, readable from any thread
+  std::atomic<unsigned int> timescale = 0;
+  std::atomic<uint32_t> sampleCount = 0;
+  std::atomic<size_t> channelCount = 0;
+
+  std::vector<double> channelAmp;
+  std::vector<double> bandAmp;
+  // Bands of the file and their mix in a channel, in single precision
+  std::vector<float> singleChannelAmp;
+  std::vector<float> singleBandAmp;
+  std::unique_ptr<VoicePool> voicePool;
+  std::optional<ActuatorMixer> actuatorMixer;
+  std::vector<std::vector<double>> actuatorBlocks;
+  std::atomic<double> budgetPerFrame = 0;
+
+  std::atomic<bool> playing = false;
+  std::atomic<uint32_t> samplePosition = 0;
+  std::atomic<uint32_t> requestedSeek = NO_SEEK;
+};
+} // namespace haptics::synthesizer
+#endif // RENDERER_H
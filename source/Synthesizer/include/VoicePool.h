@@ -0,0 +1,134 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef VOICEPOOL_H
+#define VOICEPOOL_H
+
+#include <Types/include/Haptics.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace haptics::synthesizer {
+
+// Plays the library effects of a file on request, as a game would do. Effects are triggered from
+// any thread with trigger and played by the rendering thread with renderBlock, from a pool of
+// voices allocated by the constructor: neither allocates memory nor takes locks.
+class VoicePool {
+public:
+  // Channels that can be addressed by the channel mask of trigger
+  static constexpr size_t MAX_CHANNELS = 64;
+
+  // Renders every library effect of the file at fs, once. The effects are rendered in a band of
+  // the kind of the first band referencing them, or in a vectorial band covering the whole
+  // spectrum. voiceCount is the number of effects played at the same time, maxFrames the largest
+  // block given to renderBlock.
+  explicit VoicePool(types::Haptics &haptic, int fs, size_t voiceCount, size_t maxFrames);
+
+  // Plays the library effect effectId of perception perceptionId on the channels set in
+  // channelMask, channel c being bit c, scaled by gain. The effect starts with the next block
+  // rendered. When every voice is busy, the voice of lowest priority is stolen, the oldest one
+  // among voices of equal priority, unless its priority is higher than the priority of the new
+  // effect. The priority is the one of the perception unless given. Returns false if there is no
+  // such effect or too many triggers are waiting for the next block.
+  auto trigger(int perceptionId, int effectId, uint64_t channelMask, double gain,
+               std::optional<int> priority = std::nullopt) -> bool;
+
+  // To be called from the rendering thread only. Starts the effects triggered since the last call.
+  auto startTriggeredVoices() -> void;
+  // To be called from the rendering thread only. Mixes the next length samples of the playing
+  // voices, length being at most maxFrames.
+  auto renderBlock(size_t length) -> void;
+  // Mask of the channels written by the last call to renderBlock
+  [[nodiscard]] auto getChannelMask() const -> uint64_t;
+  // Signal of a channel for the last call to renderBlock, if its bit is set in getChannelMask
+  [[nodiscard]] auto getChannelBlock(size_t channel) const -> const std::vector<double> &;
+  [[nodiscard]] auto getActiveVoiceCount() const -> size_t;
+  [[nodiscard]] auto getVoiceCount() const -> size_t;
+  // Triggers discarded because every voice was busy with effects of higher priority
+  [[nodiscard]] auto getRejectedCount() const -> size_t;
+
+private:
+  static constexpr size_t TRIGGER_QUEUE_LENGTH = 1024;
+
+  struct LibraryEntry {
+    int perceptionId = 0;
+    int effectId = 0;
+    int priority = 0;
+    std::shared_ptr<const std::vector<double>> samples;
+  };
+
+  struct Voice {
+    const std::vector<double> *samples = nullptr;
+    size_t position = 0;
+    uint64_t channelMask = 0;
+    double gain = 0;
+    int priority = 0;
+    // Trigger order, used to steal the oldest voice
+    uint64_t age = 0;
+  };
+
+  struct Trigger {
+    const LibraryEntry *entry = nullptr;
+    uint64_t channelMask = 0;
+    double gain = 0;
+    int priority = 0;
+  };
+
+  // Slot of the trigger queue, a bounded multi-producer queue in which the sequence number of a
+  // slot tells whether it is free for the producers or ready for the rendering thread
+  struct TriggerSlot {
+    std::atomic<size_t> sequence = 0;
+    Trigger trigger;
+  };
+
+  [[nodiscard]] auto findEntry(int perceptionId, int effectId) const -> const LibraryEntry *;
+  auto startVoice(const Trigger &newTrigger) -> void;
+
+  // Sorted by perception and effect
+  std::vector<LibraryEntry> library;
+  std::vector<Voice> voices;
+  // Number of playing voices, which are voices[0] to voices[activeVoices - 1]
+  std::atomic<size_t> activeVoices = 0;
+  uint64_t triggerCount = 0;
+  std::atomic<size_t> rejectedTriggers = 0;
+  std::vector<TriggerSlot> triggerSlots;
+  std::atomic<size_t> triggerWrite = 0;
+  size_t triggerRead = 0;
+  std::vector<std::vector<double>> channelBlocks;
+  uint64_t channelMask = 0;
+};
+} // namespace haptics::synthesizer
+#endif // VOICEPOOL_H
@@ -0,0 +1,126 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Synthesizer/include/ActuatorMixer.h>
+#include <Tools/include/SignalKernels.h>
+#include <algorithm>
+
+namespace haptics::synthesizer {
+
+ActuatorMixer::ActuatorMixer(types::Haptics &haptic, const std::vector<Actuator> &actuators) {
+  std::vector<types::Channel *> channels;
+  for (uint32_t i = 0; i < haptic.getPerceptionsSize(); i++) {
+    types::Perception &perception = haptic.getPerceptionAt((int)i);
+    for (uint32_t j = 0; j < perception.getChannelsSize(); j++) {
+      channels.push_back(&perception.getChannelAt((int)j));
+    }
+  }
+  channelCount = channels.size();
+
+  for (const Actuator &actuator : actuators) {
+    for (size_t c = 0; c < channels.size(); c++) {
+      const types::Channel &channel = *channels[c];
+      if (channel.getBodyPartMask() != 0 &&
+          (channel.getBodyPartMask() & actuator.bodyPartMask) == 0) {
+        continue;
+      }
+      const std::optional<std::vector<types::Vector>> targets = channel.getActuatorTarget();
+      if (targets.has_value() &&
+          (!actuator.position.has_value() ||
+           std::find(targets->begin(), targets->end(), actuator.position.value()) ==
+               targets->end())) {
+        continue;
+      }
+      if (channel.getMixingWeight() != 0) {
+        columns.push_back(c);
+        gains.push_back(channel.getMixingWeight());
+      }
+    }
+    rowOffsets.push_back(columns.size());
+  }
+}
+
+auto ActuatorMixer::setGain(size_t actuator, size_t channel, double gain) -> void {
+  while (rowOffsets.size() < actuator + 2) {
+    rowOffsets.push_back(columns.size());
+  }
+  channelCount = std::max(channelCount, channel + 1);
+  const auto rowBegin = columns.begin() + static_cast<long>(rowOffsets[actuator]);
+  const auto rowEnd = columns.begin() + static_cast<long>(rowOffsets[actuator + 1]);
+  // Columns are kept sorted within a row, so that channels are read in increasing order
+  const auto column = std::lower_bound(rowBegin, rowEnd, channel);
+  const auto index = static_cast<size_t>(column - columns.begin());
+  if (column != rowEnd && *column == channel) {
+    gains[index] = gain;
+    return;
+  }
+  columns.insert(column, channel);
+  gains.insert(gains.begin() + static_cast<long>(index), gain);
+  for (size_t a = actuator + 1; a < rowOffsets.size(); a++) {
+    rowOffsets[a]++;
+  }
+}
+
+[[nodiscard]] auto ActuatorMixer::getGain(size_t actuator, size_t channel) const -> double {
+  if (actuator >= getActuatorCount()) {
+    return 0;
+  }
+  for (size_t k = rowOffsets[actuator]; k < rowOffsets[actuator + 1]; k++) {
+    if (columns[k] == channel) {
+      return gains[k];
+    }
+  }
+  return 0;
+}
+
+[[nodiscard]] auto ActuatorMixer::getActuatorCount() const -> size_t {
+  return rowOffsets.size() - 1;
+}
+
+[[nodiscard]] auto ActuatorMixer::getChannelCount() const -> size_t { return channelCount; }
+
+[[nodiscard]] auto ActuatorMixer::getNonZeroCount() const -> size_t { return gains.size(); }
+
+auto ActuatorMixer::mix(const std::vector<std::vector<double>> &channelAmp, size_t length,
+                        std::vector<std::vector<double>> &actuatorAmp) const -> void {
+  for (size_t a = 0; a < getActuatorCount(); a++) {
+    double *out = actuatorAmp[a].data();
+    std::fill(out, out + length, 0.0);
+    for (size_t k = rowOffsets[a]; k < rowOffsets[a + 1]; k++) {
+      tools::multiplyAccumulate(channelAmp[columns[k]].data(), gains[k], out, length);
+    }
+    std::transform(out, out + length, out, [](double v) { return std::clamp(v, -1.0, 1.0); });
+  }
+}
+
+} // namespace haptics::synthesizer
@@ -0,0 +1,357 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Synthesizer/include/BandCache.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <type_traits>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace haptics::synthesizer {
+
+namespace {
+// 64 bits FNV-1a hash of the bytes of the values it is given
+class Hasher {
+public:
+  template <typename T> auto add(const T &value) -> void {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const auto *bytes = reinterpret_cast<const unsigned char *>(&value);
+    addBytes(bytes, sizeof(T));
+  }
+
+  template <typename T> auto add(const std::optional<T> &value) -> void {
+    add(value.has_value());
+    if (value.has_value()) {
+      add(value.value());
+    }
+  }
+
+  template <typename T> auto add(const std::vector<T> &values) -> void {
+    static_assert(std::is_trivially_copyable_v<T>);
+    add(values.size());
+    addBytes(reinterpret_cast<const unsigned char *>(values.data()), values.size() * sizeof(T));
+  }
+
+  [[nodiscard]] auto getHash() const -> uint64_t { return hash; }
+
+private:
+  static constexpr uint64_t OFFSET_BASIS = 0xcbf29ce484222325;
+  static constexpr uint64_t PRIME = 0x100000001b3;
+
+  auto addBytes(const unsigned char *bytes, size_t length) -> void {
+    for (size_t i = 0; i < length; i++) {
+      hash = (hash ^ bytes[i]) * PRIME;
+    }
+  }
+
+  uint64_t hash = OFFSET_BASIS;
+};
+
+constexpr int64_t MS_PER_S = 1000;
+
+auto addEffect(Hasher &hasher, types::Effect &effect, const types::Band &band) -> void {
+  hasher.add(effect.getId());
+  hasher.add(effect.getPosition());
+  hasher.add(effect.getPhase());
+  hasher.add(effect.getBaseSignal());
+  hasher.add(effect.getEffectType());
+  hasher.add(effect.getKeyframesSize());
+  for (size_t k = 0; k < effect.getKeyframesSize(); k++) {
+    const types::Keyframe &keyframe = effect.getKeyframeAt(static_cast<int>(k));
+    hasher.add(keyframe.getRelativePosition());
+    hasher.add(keyframe.getAmplitudeModulation());
+    hasher.add(keyframe.getFrequencyModulation());
+  }
+  hasher.add(effect.getWaveletBitstream());
+  hasher.add(effect.getWaveletSamples());
+  if (effect.getEffectType() == types::EffectType::Reference) {
+    const std::vector<double> *render = band.getReferenceRender(effect.getId());
+    hasher.add(render != nullptr);
+    if (render != nullptr) {
+      hasher.add(*render);
+    }
+  }
+  hasher.add(effect.getTimelineSize());
+  for (size_t t = 0; t < effect.getTimelineSize(); t++) {
+    addEffect(hasher, effect.getTimelineEffectAt(static_cast<int>(t)), band);
+  }
+}
+} // namespace
+
+CachedBand::CachedBand(CachedBand &&other) noexcept
+    : mapping(other.mapping)
+    , mappingLength(other.mappingLength)
+    , buffer(std::move(other.buffer))
+    , samples(other.mapping != nullptr ? other.samples : buffer.data())
+    , sampleCount(other.sampleCount)
+    , firstSample(other.firstSample) {
+  other.mapping = nullptr;
+  other.mappingLength = 0;
+  other.samples = nullptr;
+  other.sampleCount = 0;
+}
+
+CachedBand::~CachedBand() {
+#ifndef _WIN32
+  if (mapping != nullptr) {
+    munmap(mapping, mappingLength);
+  }
+#endif
+}
+
+[[nodiscard]] auto CachedBand::data() const -> const float * { return samples; }
+
+[[nodiscard]] auto CachedBand::size() const -> size_t { return sampleCount; }
+
+[[nodiscard]] auto CachedBand::getFirstSample() const -> int64_t { return firstSample; }
+
+template <typename T>
+auto CachedBand::read(int64_t first, size_t count, T *out) const -> void {
+  std::fill_n(out, count, static_cast<T>(0));
+  const int64_t begin = std::max(first, firstSample);
+  const int64_t end = std::min(first + static_cast<int64_t>(count),
+                               firstSample + static_cast<int64_t>(sampleCount));
+  for (int64_t i = begin; i < end; i++) {
+    out[i - first] = samples[i - firstSample];
+  }
+}
+
+template auto CachedBand::read<double>(int64_t first, size_t count, double *out) const -> void;
+template auto CachedBand::read<float>(int64_t first, size_t count, float *out) const -> void;
+
+CachedBandWriter::CachedBandWriter(CachedBandWriter &&other) noexcept
+    : file(std::move(other.file))
+    , path(std::move(other.path))
+    , temporaryPath(std::move(other.temporaryPath))
+    , key(other.key)
+    , renderedFirst(other.renderedFirst)
+    , renderedEnd(other.renderedEnd)
+    , firstSample(other.firstSample)
+    , sampleCount(other.sampleCount)
+    , pendingZeros(other.pendingZeros) {
+  other.temporaryPath.clear();
+}
+
+CachedBandWriter::~CachedBandWriter() {
+  if (!temporaryPath.empty()) {
+    file.close();
+    std::error_code error;
+    std::filesystem::remove(temporaryPath, error);
+  }
+}
+
+auto CachedBandWriter::write(const float *samples, size_t count) -> bool {
+  const float *end = samples + count;
+  const float *first = std::find_if(samples, end, [](float sample) { return sample != 0; });
+  if (first == end) {
+    pendingZeros += sampleCount > 0 ? count : 0;
+    renderedEnd += static_cast<int64_t>(count);
+    return true;
+  }
+  const float *last =
+      std::find_if(std::make_reverse_iterator(end), std::make_reverse_iterator(first),
+                   [](float sample) { return sample != 0; })
+          .base();
+  if (sampleCount == 0) {
+    firstSample = renderedEnd + (first - samples);
+  } else {
+    // The zero samples between the last stored one and this one are stored
+    pendingZeros += first - samples;
+    const std::vector<float> zeros(std::min<uint64_t>(pendingZeros, count));
+    while (pendingZeros > 0) {
+      const uint64_t length = std::min<uint64_t>(pendingZeros, zeros.size());
+      file.write(reinterpret_cast<const char *>(zeros.data()),
+                 static_cast<std::streamsize>(length * sizeof(float)));
+      sampleCount += static_cast<uint32_t>(length);
+      pendingZeros -= length;
+    }
+  }
+  file.write(reinterpret_cast<const char *>(first),
+             static_cast<std::streamsize>((last - first) * sizeof(float)));
+  sampleCount += static_cast<uint32_t>(last - first);
+  pendingZeros = end - last;
+  renderedEnd += static_cast<int64_t>(count);
+  return static_cast<bool>(file);
+}
+
+auto CachedBandWriter::commit() -> bool {
+  BandCache::FileHeader header;
+  header.sampleCount = sampleCount;
+  header.firstSample = firstSample;
+  header.renderedFirst = renderedFirst;
+  header.renderedEnd = renderedEnd;
+  header.key = key;
+  file.seekp(0);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(BandCache::FileHeader));
+  file.close();
+  if (!file) {
+    return false;
+  }
+  std::error_code error;
+  std::filesystem::rename(temporaryPath, path, error);
+  if (error) {
+    return false;
+  }
+  temporaryPath.clear();
+  return true;
+}
+
+BandCache::BandCache(std::filesystem::path newDirectory) : directory(std::move(newDirectory)) {
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+}
+
+[[nodiscard]] auto BandCache::getBandKey(types::Band &band, int fs, int pad,
+                                         unsigned int timescale) -> uint64_t {
+  Hasher hasher;
+  hasher.add(FORMAT_VERSION);
+  hasher.add(fs);
+  hasher.add(static_cast<int64_t>(pad) * fs % MS_PER_S);
+  hasher.add(timescale);
+  hasher.add(band.getBandType());
+  hasher.add(band.getCurveType());
+  hasher.add(band.getBlockLength());
+  hasher.add(band.getLowerFrequencyLimit());
+  hasher.add(band.getUpperFrequencyLimit());
+  hasher.add(band.getWaveletLowPassFrequency());
+  hasher.add(band.getEffectsSize());
+  for (size_t e = 0; e < band.getEffectsSize(); e++) {
+    addEffect(hasher, band.getEffectAt(static_cast<int>(e)), band);
+  }
+  return hasher.getHash();
+}
+
+[[nodiscard]] auto BandCache::load(uint64_t key, int64_t first, int64_t end)
+    -> std::optional<CachedBand> {
+  const std::string path = getPath(key).string();
+  CachedBand cached;
+  FileHeader header;
+  bool complete = false;
+#ifndef _WIN32
+  const int descriptor = open(path.c_str(), O_RDONLY);
+  if (descriptor >= 0) {
+    struct stat status = {};
+    if (fstat(descriptor, &status) == 0 &&
+        static_cast<size_t>(status.st_size) >= sizeof(FileHeader)) {
+      const auto length = static_cast<size_t>(status.st_size);
+      void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+      if (mapping != MAP_FAILED) {
+        cached.mapping = mapping;
+        cached.mappingLength = length;
+        std::memcpy(&header, mapping, sizeof(FileHeader));
+        complete = length == sizeof(FileHeader) + header.sampleCount * sizeof(float);
+        cached.samples = reinterpret_cast<const float *>(static_cast<char *>(mapping) +
+                                                         sizeof(FileHeader));
+      }
+    }
+    close(descriptor);
+  }
+#else
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  const auto length = static_cast<size_t>(file ? static_cast<std::streamoff>(file.tellg()) : 0);
+  file.seekg(0);
+  if (file.read(reinterpret_cast<char *>(&header), sizeof(FileHeader)) &&
+      length == sizeof(FileHeader) + header.sampleCount * sizeof(float)) {
+    cached.buffer.resize(header.sampleCount);
+    file.read(reinterpret_cast<char *>(cached.buffer.data()),
+              static_cast<std::streamsize>(header.sampleCount * sizeof(float)));
+    complete = static_cast<bool>(file);
+    cached.samples = cached.buffer.data();
+  }
+#endif
+  if (!complete || header.magic != MAGIC || header.key != key ||
+      header.renderedFirst > first || header.renderedEnd < end) {
+    missCount++;
+    return std::nullopt;
+  }
+  cached.sampleCount = header.sampleCount;
+  cached.firstSample = header.firstSample;
+  hitCount++;
+  return cached;
+}
+
+[[nodiscard]] auto BandCache::beginStore(uint64_t key, int64_t first)
+    -> std::optional<CachedBandWriter> {
+  CachedBandWriter writer;
+  writer.renderedFirst = first;
+  writer.renderedEnd = first;
+  writer.path = getPath(key);
+  writer.temporaryPath = writer.path;
+  writer.temporaryPath += "." + std::to_string(std::random_device()()) + ".tmp";
+  writer.key = key;
+  writer.file.open(writer.temporaryPath, std::ios::binary | std::ios::trunc);
+  // The header is filled in by commit, its magic number being invalid until then
+  FileHeader header;
+  header.magic = 0;
+  header.key = key;
+  writer.file.write(reinterpret_cast<const char *>(&header), sizeof(FileHeader));
+  if (!writer.file) {
+    return std::nullopt;
+  }
+  return writer;
+}
+
+auto BandCache::store(uint64_t key, int64_t first, const std::vector<float> &samples) -> bool {
+  std::optional<CachedBandWriter> writer = beginStore(key, first);
+  return writer.has_value() && writer->write(samples.data(), samples.size()) && writer->commit();
+}
+
+[[nodiscard]] auto BandCache::getFirstSample(int fs, int pad) -> int64_t {
+  return -(static_cast<int64_t>(pad) * fs / MS_PER_S);
+}
+
+[[nodiscard]] auto BandCache::getPath(uint64_t key) const -> std::filesystem::path {
+  std::ostringstream name;
+  name << std::hex << std::setw(16) << std::setfill('0') << key << ".band";
+  return directory / name.str();
+}
+
+[[nodiscard]] auto BandCache::getDirectory() const -> const std::filesystem::path & {
+  return directory;
+}
+
+[[nodiscard]] auto BandCache::getHitCount() const -> size_t { return hitCount; }
+
+[[nodiscard]] auto BandCache::getMissCount() const -> size_t { return missCount; }
+
+} // namespace haptics::synthesizer
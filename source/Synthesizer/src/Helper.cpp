@@ -31,14 +31,24 @@
  * THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <Synthesizer/include/BandCache.h>
 #include <Synthesizer/include/Helper.h>
+#include <Tools/include/SignalKernels.h>
+#include <Tools/include/ThreadPool.h>
 #include <Tools/include/Tools.h>
-#include <Tools/include/WavParser.h>
+#include <Tools/include/WavWriter.h>
+#include <WaveletDecoder/include/WaveletBlockCache.h>
 #include <WaveletDecoder/include/WaveletDecoder.h>
+#include <WaveletDecoder/include/WaveletLowPass.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <type_traits>
 
 using haptics::synthesizer::Helper;
 using haptics::types::Haptics;
-using haptics::waveletdecoder::WaveletDecoder;
 
 namespace haptics::synthesizer {
 
@@ -76,40 +86,277 @@ namespace haptics::synthesizer {
   return maxLength;
 }
 
+// NOLINTNEXTLINE(readability-function-size)
 [[nodiscard]] auto Helper::playFile(types::Haptics &haptic, const double timeLength, const int fs,
-                                    const int pad, std::string &filename) -> bool {
+                                    const int pad, std::string &filename, size_t threadCount,
+                                    BandCache *cache, waveletdecoder::DecodingPrecision precision)
+    -> bool {
+  tools::ThreadPool pool(threadCount);
 
-  // Apply preprocessing on wavelet bands
-  WaveletDecoder waveletDecoder;
+  // Every band is processed independently: bandOffsets[c] is the index of the first band of the
+  // channel c in bands, the bands of the last channel ending at bandOffsets.back()
+  std::vector<types::Channel *> channels;
+  std::vector<double> perceptionUnitFactors;
+  std::vector<types::Band *> bands;
+  std::vector<size_t> bandOffsets = {0};
   for (uint32_t i = 0; i < haptic.getPerceptionsSize(); i++) {
-    for (uint32_t j = 0; j < haptic.getPerceptionAt((int)i).getChannelsSize(); j++) {
-      for (uint32_t k = 0; k < haptic.getPerceptionAt((int)i).getChannelAt((int)j).getBandsSize();
-           k++) {
-        types::Band band = haptic.getPerceptionAt((int)i).getChannelAt((int)j).getBandAt((int)k);
-        if (band.getBandType() == types::BandType::WaveletWave) {
-          waveletDecoder.transformBand(band, haptic.getTimescaleOrDefault());
-          haptic.getPerceptionAt((int)i).getChannelAt((int)j).replaceBandAt((int)k, band);
-        }
+    types::Perception &perception = haptic.getPerceptionAt((int)i);
+    for (uint32_t j = 0; j < perception.getChannelsSize(); j++) {
+      types::Channel &channel = perception.getChannelAt((int)j);
+      channels.push_back(&channel);
+      perceptionUnitFactors.push_back(
+          std::pow(10.0, perception.getPerceptionUnitExponentOrDefault()));
+      for (uint32_t k = 0; k < channel.getBandsSize(); k++) {
+        bands.push_back(&channel.getBandAt((int)k));
       }
+      bandOffsets.push_back(bands.size());
     }
   }
-  std::vector<std::vector<double>> amplitudes;
 
   unsigned int timescale = haptic.getTimescale().value();
+  auto sampleCount = static_cast<uint32_t>(std::round(fs * (timeLength + 2 * pad) / timescale));
+
+  // Bands found in the cache are read back instead of being synthesized, the other ones being
+  // written to the cache chunk by chunk as they are synthesized, and committed once the file is
+  // written. Their samples are rounded to single precision as the cached ones, if they are not
+  // synthesized in single precision already, so that the output does not depend on the cache
+  // content. Cached samples are indexed from the origin of the
+  // timeline rather than from the start of the padded file.
+  const int64_t cacheOffset = BandCache::getFirstSample(fs, pad);
+  std::vector<uint64_t> keys(cache != nullptr ? bands.size() : 0);
+  std::vector<std::optional<CachedBand>> cachedBands(keys.size());
+  std::vector<std::optional<CachedBandWriter>> writers(keys.size());
+  std::vector<std::vector<float>> chunkSamples(keys.size());
+  if (cache != nullptr) {
+    pool.parallelFor(bands.size(), [&](size_t b) {
+      keys[b] = BandCache::getBandKey(*bands[b], fs, pad, timescale);
+      std::optional<CachedBand> cached =
+          cache->load(keys[b], cacheOffset, cacheOffset + static_cast<int64_t>(sampleCount));
+      if (cached.has_value()) {
+        cachedBands[b].emplace(std::move(cached.value()));
+        return;
+      }
+      if (precision == waveletdecoder::DecodingPrecision::Double) {
+        chunkSamples[b].resize(SYNTHESIS_CHUNK_LENGTH);
+      }
+      std::optional<CachedBandWriter> writer = cache->beginStore(keys[b], cacheOffset);
+      if (writer.has_value()) {
+        writers[b].emplace(std::move(writer.value()));
+      }
+    });
+  }
+  const auto isCached = [&](size_t b) { return cache != nullptr && cachedBands[b].has_value(); };
+
+  // Wavelet blocks are decoded along with the chunks that need them, only the blocks of the current
+  // chunk being kept. Each band gets its own block cache, bands being synthesized in parallel.
+  std::vector<std::unique_ptr<waveletdecoder::WaveletBlockCache>> waveletBlocks(bands.size());
+  for (size_t b = 0; b < bands.size(); b++) {
+    if (bands[b]->getBandType() == types::BandType::WaveletWave && !isCached(b)) {
+      waveletBlocks[b] = std::make_unique<waveletdecoder::WaveletBlockCache>(0, precision);
+    }
+  }
+
+  tools::WavWriter wavWriter;
+  if (!wavWriter.open(filename, channels.size(), fs)) {
+    return false;
+  }
+
+  // The file is synthesized and written chunk by chunk, memory usage does not depend on its
+  // duration. Bands are synthesized and mixed in the precision of the amplitudes given.
+  std::vector<int16_t> frames(SYNTHESIS_CHUNK_LENGTH * channels.size());
+  const auto synthesize = [&](auto &bandAmplitudes) -> bool {
+    using Sample = typename std::decay_t<decltype(bandAmplitudes)>::value_type::value_type;
+    std::vector<const Sample *> bandData(bands.size());
+    for (uint32_t firstSample = 0; firstSample < sampleCount;
+         firstSample += SYNTHESIS_CHUNK_LENGTH) {
+      const uint32_t chunkLength = std::min(SYNTHESIS_CHUNK_LENGTH, sampleCount - firstSample);
+      pool.parallelFor(bands.size(), [&](size_t b) {
+        std::vector<Sample> &amplitudes = bandAmplitudes[b];
+        amplitudes.resize(chunkLength);
+        if (isCached(b)) {
+          cachedBands[b]->read(cacheOffset + firstSample, chunkLength, amplitudes.data());
+          return;
+        }
+        if (waveletBlocks[b] != nullptr) {
+          // Resampled blocks also contribute to the samples around them
+          const double margin = bands[b]->getWaveletWindowMargin(fs, timescale);
+          const double ticksPerSample = static_cast<double>(timescale) / fs;
+          const double startTick = firstSample * ticksPerSample - pad * MS_2_S * timescale;
+          waveletBlocks[b]->decodeWindow(*bands[b], timescale, startTick - margin,
+                                         startTick + chunkLength * ticksPerSample + margin);
+        }
+        bands[b]->EvaluationBand(firstSample, fs, pad, timescale, amplitudes);
+        if (cache == nullptr) {
+          return;
+        }
+        const float *stored = nullptr;
+        if constexpr (std::is_same_v<Sample, float>) {
+          stored = amplitudes.data();
+        } else {
+          for (uint32_t k = 0; k < chunkLength; k++) {
+            chunkSamples[b][k] = static_cast<float>(amplitudes[k]);
+            amplitudes[k] = chunkSamples[b][k];
+          }
+          stored = chunkSamples[b].data();
+        }
+        if (writers[b].has_value() && !writers[b]->write(stored, chunkLength)) {
+          writers[b].reset(); // the band is not stored, its temporary file being removed
+        }
+      });
+
+      // Bands are mixed in the order of the file, the result does not depend on the thread
+      // count. Each channel is mixed, scaled and quantized in a single pass, straight into the
+      // frames.
+      for (size_t b = 0; b < bands.size(); b++) {
+        bandData[b] = bandAmplitudes[b].data();
+      }
+      pool.parallelFor(channels.size(), [&](size_t c) {
+        const double gain = channels[c]->getGain() * perceptionUnitFactors[c];
+        const size_t bandCount = bandOffsets[c + 1] - bandOffsets[c];
+        tools::mixClampedQuantized(bandData.data() + bandOffsets[c], bandCount, gain,
+                                   frames.data() + c, channels.size(), chunkLength);
+      });
+      if (!wavWriter.writeFrames(frames.data(), chunkLength)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  bool synthesized = false;
+  if (precision == waveletdecoder::DecodingPrecision::Single) {
+    std::vector<std::vector<float>> bandAmplitudes(bands.size(),
+                                                   std::vector<float>(SYNTHESIS_CHUNK_LENGTH));
+    synthesized = synthesize(bandAmplitudes);
+  } else {
+    std::vector<std::vector<double>> bandAmplitudes(bands.size(),
+                                                    std::vector<double>(SYNTHESIS_CHUNK_LENGTH));
+    synthesized = synthesize(bandAmplitudes);
+  }
+  if (!synthesized) {
+    return false;
+  }
+  for (std::unique_ptr<waveletdecoder::WaveletBlockCache> &blocks : waveletBlocks) {
+    if (blocks != nullptr) {
+      blocks->clear();
+    }
+  }
+  if (!wavWriter.close()) {
+    return false;
+  }
+  if (cache != nullptr) {
+    pool.parallelFor(bands.size(), [&](size_t b) {
+      if (writers[b].has_value()) {
+        writers[b]->commit();
+      }
+    });
+  }
+  return true;
+}
+auto Helper::cullForDevices(types::Haptics &haptic) -> DeviceCullingReport {
+  DeviceCullingReport report;
+  const unsigned int timescale = haptic.getTimescaleOrDefault();
   for (uint32_t i = 0; i < haptic.getPerceptionsSize(); i++) {
-    for (uint32_t j = 0; j < haptic.getPerceptionAt((int)i).getChannelsSize(); j++) {
-      types::Channel myChannel;
-      auto sampleCount = static_cast<uint32_t>(std::round(fs * (timeLength + 2 * pad) / timescale));
-      myChannel = haptic.getPerceptionAt((int)i).getChannelAt((int)j);
-      std::vector<double> channelAmp = myChannel.EvaluateChannel(sampleCount, fs, pad, timescale);
-      const double perceptionUnitFactor =
-          std::pow(10.0, haptic.getPerceptionAt((int)i).getPerceptionUnitExponentOrDefault());
-      for (uint32_t k = 0; k < sampleCount; k++) {
-        channelAmp[k] = channelAmp[k] * myChannel.getGain() * perceptionUnitFactor;
+    types::Perception &perception = haptic.getPerceptionAt((int)i);
+    for (uint32_t j = 0; j < perception.getChannelsSize(); j++) {
+      types::Channel &channel = perception.getChannelAt((int)j);
+      std::optional<float> minimumFrequency;
+      std::optional<float> maximumFrequency;
+      for (uint32_t d = 0; d < perception.getReferenceDevicesSize(); d++) {
+        types::ReferenceDevice &device = perception.getReferenceDeviceAt((int)d);
+        if (channel.getReferenceDeviceId().has_value() &&
+            device.getId() == channel.getReferenceDeviceId().value()) {
+          minimumFrequency = device.getMinimumFrequency();
+          maximumFrequency = device.getMaximumFrequency();
+        }
+      }
+      const double low = minimumFrequency.value_or(0);
+      const double high = maximumFrequency.value_or(std::numeric_limits<float>::infinity());
+
+      for (int k = static_cast<int>(channel.getBandsSize()) - 1; k >= 0; k--) {
+        types::Band &band = channel.getBandAt(k);
+        double bandWork = 0;
+        for (int e = 0; e < static_cast<int>(band.getEffectsSize()); e++) {
+          bandWork += getEffectWork(band.getEffectAt(e), band, timescale);
+        }
+        report.totalWork += bandWork;
+        if (!minimumFrequency.has_value() && !maximumFrequency.has_value()) {
+          continue;
+        }
+
+        // Wavelet bands are sampled at their upper frequency limit
+        const double bandHigh = band.getBandType() == types::BandType::WaveletWave
+                                    ? band.getUpperFrequencyLimit() / 2.0
+                                    : band.getUpperFrequencyLimit();
+        if (bandHigh < low || band.getLowerFrequencyLimit() > high) {
+          channel.removeBandAt(k);
+          report.culledBands++;
+          report.culledWork += bandWork;
+          continue;
+        }
+
+        switch (band.getBandType()) {
+        case types::BandType::VectorialWave:
+          for (int e = static_cast<int>(band.getEffectsSize()) - 1; e >= 0; e--) {
+            types::Effect &effect = band.getEffectAt(e);
+            // Frequencies are clamped to the band limits when the effect is evaluated
+            double effectLow = std::numeric_limits<double>::infinity();
+            double effectHigh = -std::numeric_limits<double>::infinity();
+            for (int f = 0; f < static_cast<int>(effect.getKeyframesSize()); f++) {
+              std::optional<int> frequency = effect.getKeyframeAt(f).getFrequencyModulation();
+              if (frequency.has_value()) {
+                const double clamped = std::clamp(
+                    static_cast<double>(frequency.value()),
+                    static_cast<double>(band.getLowerFrequencyLimit()),
+                    static_cast<double>(band.getUpperFrequencyLimit()));
+                effectLow = std::min(effectLow, clamped);
+                effectHigh = std::max(effectHigh, clamped);
+              }
+            }
+            if (effectLow <= effectHigh && (effectHigh < low || effectLow > high)) {
+              report.culledWork += getEffectWork(effect, band, timescale);
+              band.removeEffectAt(e);
+              report.culledEffects++;
+            }
+          }
+          break;
+        case types::BandType::WaveletWave:
+          if (high < bandHigh) {
+            band.setWaveletLowPassFrequency(high);
+            lowPassDecodedBlocks(band);
+            report.lowPassedBands++;
+          }
+          break;
+        default:
+          break;
+        }
       }
-      amplitudes.push_back(channelAmp);
     }
   }
-  return haptics::tools::WavParser::saveFile(filename, amplitudes, fs);
+  return report;
+}
+
+[[nodiscard]] auto Helper::getEffectWork(types::Effect &effect, types::Band &band,
+                                         unsigned int timescale) -> double {
+  switch (band.getBandType()) {
+  case types::BandType::WaveletWave:
+    // block length in milliseconds
+    return band.getBlockLengthOrDefault() * MS_2_S * timescale;
+  case types::BandType::Transient:
+    return effect.getEffectTimeLength(types::BandType::Transient,
+                                      types::Band::TRANSIENT_DURATION_MS * MS_2_S * timescale);
+  default:
+    return effect.getEffectTimeLength(band.getBandType(), 0);
+  }
+}
+
+auto Helper::lowPassDecodedBlocks(types::Band &band) -> void {
+  // The blocks still encoded are low-passed as they are decoded for the synthesis
+  waveletdecoder::WaveletLowPass lowPass(band, waveletdecoder::DecodingPrecision::Double);
+  for (int e = 0; e < static_cast<int>(band.getEffectsSize()); e++) {
+    if (band.getWaveletBitstreamAt(e).empty()) {
+      lowPass.filterBlock(e, band.getWaveletSamplesAt(e));
+    }
+  }
 }
+
 } // namespace haptics::synthesizer
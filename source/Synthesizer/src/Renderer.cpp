@@ -0,0 +1,424 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Synthesizer/include/Helper.h>
+#include <Synthesizer/include/Renderer.h>
+#include <Tools/include/WavParser.h>
+#include <WaveletDecoder/include/WaveletDecoder.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <tuple>
+
+using haptics::waveletdecoder::WaveletDecoder;
+
+namespace haptics::synthesizer {
+
+Renderer::Renderer(types::Haptics newHaptic, int newFs, size_t newMaxFrames,
+                   waveletdecoder::DecodingPrecision newPrecision, size_t newLazyDecodingBytes)
+    : fs(newFs)
+    , maxFrames(std::max<size_t>(newMaxFrames, 1))
+    , precision(newPrecision)
+    , lazyDecodingBytes(newLazyDecodingBytes)
+    , publishedHaptic(newHaptic)
+    , voicePool(std::make_unique<VoicePool>(publishedHaptic, fs, DEFAULT_VOICE_COUNT, maxFrames)) {
+  channelAmp.resize(maxFrames);
+  bandAmp.resize(maxFrames);
+  if (precision == waveletdecoder::DecodingPrecision::Single) {
+    singleChannelAmp.resize(maxFrames);
+    singleBandAmp.resize(maxFrames);
+  }
+  pendingScene = makeScene(std::move(newHaptic));
+  swapScene();
+}
+
+Renderer::~Renderer() {
+  reclaimScenes();
+  delete pendingScene.exchange(nullptr);
+  delete scene;
+}
+
+auto Renderer::makeScene(types::Haptics newHaptic) -> Scene * {
+  auto newScene = std::make_unique<Scene>();
+  Scene &prepared = *newScene;
+  prepared.haptic = std::move(newHaptic);
+  prepared.timescale = prepared.haptic.getTimescaleOrDefault();
+  prepared.haptic.renderLibrary(fs);
+  prepared.sampleCount = static_cast<uint32_t>(std::round(
+      fs * Helper::getTimeLength(prepared.haptic) / static_cast<double>(prepared.timescale)));
+
+  WaveletDecoder waveletDecoder(precision);
+  if (lazyDecodingBytes > 0) {
+    prepared.waveletBlocks =
+        std::make_unique<waveletdecoder::WaveletBlockCache>(lazyDecodingBytes, precision);
+  }
+  std::vector<double> warmUp(maxFrames);
+  std::vector<float> singleWarmUp(precision == waveletdecoder::DecodingPrecision::Single ? maxFrames
+                                                                                        : 0);
+  std::vector<std::tuple<int, int, int>> priorities;
+  for (uint32_t i = 0; i < prepared.haptic.getPerceptionsSize(); i++) {
+    types::Perception &perception = prepared.haptic.getPerceptionAt((int)i);
+    for (uint32_t j = 0; j < perception.getChannelsSize(); j++) {
+      types::Channel &channel = perception.getChannelAt((int)j);
+      prepared.channelBands.push_back(prepared.bandStates.size());
+      for (uint32_t k = 0; k < channel.getBandsSize(); k++) {
+        types::Band &band = channel.getBandAt((int)k);
+        if (band.getBandType() == types::BandType::WaveletWave &&
+            prepared.waveletBlocks == nullptr) {
+          waveletDecoder.transformBand(band, prepared.timescale);
+        }
+        // A first evaluation builds the effect index and sizes the buffers of the band
+        if (singleWarmUp.empty()) {
+          band.EvaluationBand(0, fs, 0, prepared.timescale, warmUp);
+        } else {
+          band.EvaluationBand(0, fs, 0, prepared.timescale, singleWarmUp);
+        }
+        prepared.bandStates.push_back({prepared.hapticChannels.size(), (int)k});
+        priorities.emplace_back(perception.getPriorityOrDefault(), channel.getPriorityOrDefault(),
+                                band.getPriorityOrDefault());
+      }
+      prepared.hapticChannels.push_back(&channel);
+      prepared.perceptionUnitFactors.push_back(
+          std::pow(10.0, perception.getPerceptionUnitExponentOrDefault()));
+    }
+  }
+  prepared.channelBands.push_back(prepared.bandStates.size());
+  prepared.bandPriorityOrder.resize(prepared.bandStates.size());
+  for (size_t b = 0; b < prepared.bandStates.size(); b++) {
+    prepared.bandPriorityOrder[b] = b;
+  }
+  std::stable_sort(prepared.bandPriorityOrder.begin(), prepared.bandPriorityOrder.end(),
+                   [&priorities](size_t a, size_t b) { return priorities[a] > priorities[b]; });
+  prepared.droppedBands.reserve(prepared.bandStates.size());
+  sizeChannelBlocks(prepared);
+  return newScene.release();
+}
+
+auto Renderer::sizeChannelBlocks(Scene &prepared) const -> void {
+  if (actuatorMixer.has_value()) {
+    prepared.channelBlocks.assign(
+        std::max(prepared.hapticChannels.size(), actuatorMixer->getChannelCount()),
+        std::vector<double>(maxFrames));
+  }
+}
+
+auto Renderer::swapScene() -> void {
+  Scene *newScene = pendingScene.exchange(nullptr);
+  if (newScene == nullptr) {
+    return;
+  }
+  Scene *oldScene = scene;
+  scene = newScene;
+  timescale = scene->timescale;
+  sampleCount = scene->sampleCount;
+  channelCount = scene->hapticChannels.size();
+  if (oldScene != nullptr) {
+    // The old scene is handed over to the producer, which deletes it
+    oldScene->nextRetired = retiredScenes.load();
+    while (!retiredScenes.compare_exchange_weak(oldScene->nextRetired, oldScene)) {
+    }
+  }
+}
+
+auto Renderer::reclaimScenes() -> void {
+  Scene *retired = retiredScenes.exchange(nullptr);
+  while (retired != nullptr) {
+    Scene *next = retired->nextRetired;
+    delete retired;
+    retired = next;
+  }
+}
+
+auto Renderer::publish(types::Haptics newHaptic) -> void {
+  reclaimScenes();
+  publishedHaptic = newHaptic;
+  // A scene published earlier and not picked up by render yet is never rendered
+  delete pendingScene.exchange(makeScene(std::move(newHaptic)));
+}
+
+auto Renderer::updateChannel(size_t channel, const types::Channel &newChannel) -> bool {
+  size_t first = 0;
+  for (uint32_t i = 0; i < publishedHaptic.getPerceptionsSize(); i++) {
+    types::Perception &perception = publishedHaptic.getPerceptionAt((int)i);
+    if (channel < first + perception.getChannelsSize()) {
+      types::Haptics newHaptic = publishedHaptic;
+      types::Channel updatedChannel = newChannel;
+      newHaptic.getPerceptionAt((int)i).replaceChannelAt((int)(channel - first), updatedChannel);
+      publish(std::move(newHaptic));
+      return true;
+    }
+    first += perception.getChannelsSize();
+  }
+  return false;
+}
+
+auto Renderer::render(float *out, size_t frames, size_t channels) -> size_t {
+  return renderSamples(out, frames, channels);
+}
+
+auto Renderer::render(int16_t *out, size_t frames, size_t channels) -> size_t {
+  return renderSamples(out, frames, channels);
+}
+
+template <typename Sample>
+auto Renderer::renderSamples(Sample *out, size_t frames, size_t channels) -> size_t {
+  swapScene();
+  Scene &current = *scene;
+  const uint32_t seekPosition = requestedSeek.exchange(NO_SEEK);
+  if (seekPosition != NO_SEEK) {
+    samplePosition = std::min(seekPosition, current.sampleCount);
+  }
+  std::fill(out, out + frames * channels, Sample(0));
+  current.droppedBands.clear();
+  for (BandState &state : current.bandStates) {
+    state.dropped = false;
+  }
+  voicePool->startTriggeredVoices();
+  const bool filePlaying = playing;
+  if (!filePlaying && voicePool->getActiveVoiceCount() == 0) {
+    return 0;
+  }
+
+  const bool mixed = actuatorMixer.has_value();
+  const size_t renderedChannels = mixed ? current.hapticChannels.size()
+                                        : std::min(channels, current.hapticChannels.size());
+  const size_t outputChannels = mixed ? current.channelBlocks.size() : channels;
+  uint32_t position = samplePosition;
+  size_t renderedFrames = 0;
+  size_t doneFrames = 0;
+  while (doneFrames < frames) {
+    const bool fileBlock = filePlaying && position < current.sampleCount;
+    if (!fileBlock && voicePool->getActiveVoiceCount() == 0) {
+      break;
+    }
+    size_t blockLength = std::min(frames - doneFrames, maxFrames);
+    if (fileBlock) {
+      blockLength = std::min(blockLength, static_cast<size_t>(current.sampleCount - position));
+    }
+    voicePool->renderBlock(blockLength);
+    const uint64_t voiceMask = voicePool->getChannelMask();
+    // The buffers were allocated for maxFrames samples: resizing them does not allocate
+    const bool single = precision == waveletdecoder::DecodingPrecision::Single;
+    if (single) {
+      singleBandAmp.resize(blockLength);
+    } else {
+      bandAmp.resize(blockLength);
+    }
+    const bool budgeted = fileBlock && budgetPerFrame > 0;
+    if (budgeted) {
+      selectBands(renderedChannels);
+    }
+    for (size_t c = 0; c < outputChannels; c++) {
+      const bool fileChannel = fileBlock && c < renderedChannels;
+      const bool voiceChannel = c < VoicePool::MAX_CHANNELS && ((voiceMask >> c) & 1U) != 0;
+      if (!fileChannel && !voiceChannel) {
+        if (mixed) {
+          std::fill_n(current.channelBlocks[c].begin(), blockLength, 0);
+        }
+        continue;
+      }
+      channelAmp.assign(blockLength, 0);
+      if (fileChannel && single) {
+        // Bands are mixed in single precision, the channel being widened to be mixed with the
+        // triggered effects
+        singleChannelAmp.assign(blockLength, 0);
+        renderChannelBands(current, c, position, budgeted, singleBandAmp, singleChannelAmp);
+        std::copy_n(singleChannelAmp.begin(), blockLength, channelAmp.begin());
+      } else if (fileChannel) {
+        renderChannelBands(current, c, position, budgeted, bandAmp, channelAmp);
+      }
+      if (voiceChannel) {
+        types::Channel::mixBand(channelAmp, voicePool->getChannelBlock(c));
+      }
+      if (mixed) {
+        std::copy_n(channelAmp.begin(), blockLength, current.channelBlocks[c].begin());
+        continue;
+      }
+      Sample *frame = out + doneFrames * channels + c;
+      for (size_t i = 0; i < blockLength; i++) {
+        storeSample(channelAmp[i], frame[i * channels]);
+      }
+    }
+    if (mixed) {
+      actuatorMixer->mix(current.channelBlocks, blockLength, actuatorBlocks);
+      for (size_t a = 0; a < std::min(channels, actuatorBlocks.size()); a++) {
+        Sample *frame = out + doneFrames * channels + a;
+        for (size_t i = 0; i < blockLength; i++) {
+          storeSample(actuatorBlocks[a][i], frame[i * channels]);
+        }
+      }
+    }
+    doneFrames += blockLength;
+    if (fileBlock) {
+      renderedFrames += blockLength;
+      position += static_cast<uint32_t>(blockLength);
+    }
+  }
+
+  if (filePlaying) {
+    samplePosition = position;
+    if (position >= current.sampleCount) {
+      playing = false;
+    }
+  }
+  return renderedFrames;
+}
+
+template <typename T>
+auto Renderer::renderChannelBands(Scene &current, size_t channel, uint32_t position, bool budgeted,
+                                  std::vector<T> &bandSamples, std::vector<T> &channelSamples)
+    -> void {
+  types::Channel &hapticChannel = *current.hapticChannels[channel];
+  const size_t blockLength = bandSamples.size();
+  for (size_t b = current.channelBands[channel]; b < current.channelBands[channel + 1]; b++) {
+    BandState &state = current.bandStates[b];
+    if (budgeted && !state.active) {
+      continue;
+    }
+    types::Band &band = hapticChannel.getBandAt(state.band);
+    if (budgeted) {
+      const auto begin = std::chrono::steady_clock::now();
+      evaluateBand(current, band, position, bandSamples);
+      const std::chrono::duration<double, std::micro> duration =
+          std::chrono::steady_clock::now() - begin;
+      state.cost +=
+          COST_SMOOTHING * (duration.count() / static_cast<double>(blockLength) - state.cost);
+    } else {
+      evaluateBand(current, band, position, bandSamples);
+    }
+    types::Channel::mixBand(channelSamples, bandSamples);
+  }
+  const double channelFactor = hapticChannel.getGain() * current.perceptionUnitFactors[channel];
+  for (T &amplitude : channelSamples) {
+    amplitude = static_cast<T>(amplitude * channelFactor);
+  }
+}
+
+template <typename T>
+auto Renderer::evaluateBand(Scene &current, types::Band &band, uint32_t position,
+                            std::vector<T> &bandSamples) -> void {
+  if (current.waveletBlocks != nullptr && band.getBandType() == types::BandType::WaveletWave) {
+    // Resampled blocks also contribute to the frames around them
+    const double ticksPerFrame = static_cast<double>(current.timescale) / fs;
+    const double margin = band.getWaveletWindowMargin(fs, current.timescale);
+    current.waveletBlocks->decodeWindow(
+        band, current.timescale, position * ticksPerFrame - margin,
+        static_cast<double>(position + bandSamples.size()) * ticksPerFrame + margin);
+  }
+  band.EvaluationBand(position, fs, 0, current.timescale, bandSamples);
+}
+
+auto Renderer::setActuatorMixer(ActuatorMixer newMixer) -> void {
+  actuatorMixer = std::move(newMixer);
+  sizeChannelBlocks(*scene);
+  // A scene published before the mixer was set and not picked up by render yet is sized too
+  Scene *pending = pendingScene.exchange(nullptr);
+  if (pending != nullptr) {
+    sizeChannelBlocks(*pending);
+    Scene *expected = nullptr;
+    if (!pendingScene.compare_exchange_strong(expected, pending)) {
+      delete pending;
+    }
+  }
+  actuatorBlocks.assign(actuatorMixer->getActuatorCount(), std::vector<double>(maxFrames));
+}
+
+auto Renderer::storeSample(double value, float &sample) -> void {
+  sample = static_cast<float>(value);
+}
+
+auto Renderer::storeSample(double value, int16_t &sample) -> void {
+  sample = static_cast<int16_t>(tools::WavParser::quantize(value));
+}
+
+auto Renderer::selectBands(size_t renderedChannels) -> void {
+  // Bands are kept by decreasing priority as long as their estimated cost fits in the budget. The
+  // estimate of a band left out decays, so that it is tried again once the load has decreased.
+  double remainingBudget = budgetPerFrame;
+  for (size_t b : scene->bandPriorityOrder) {
+    BandState &state = scene->bandStates[b];
+    if (state.channel >= renderedChannels) {
+      continue;
+    }
+    state.active = state.cost <= remainingBudget;
+    if (state.active) {
+      remainingBudget -= state.cost;
+    } else {
+      state.cost *= 1 - COST_SMOOTHING;
+      if (!state.dropped) {
+        state.dropped = true;
+        scene->droppedBands.push_back({state.channel, state.band});
+      }
+    }
+  }
+}
+
+auto Renderer::setCpuBudget(double microseconds, size_t blockFrames) -> void {
+  budgetPerFrame = blockFrames > 0 ? std::max(microseconds, 0.0) / static_cast<double>(blockFrames)
+                                   : 0;
+}
+
+[[nodiscard]] auto Renderer::getDroppedBands() const -> const std::vector<DroppedBand> & {
+  return scene->droppedBands;
+}
+
+auto Renderer::trigger(int perceptionId, int effectId, uint64_t channelMask, double gain,
+                       std::optional<int> priority) -> bool {
+  return voicePool->trigger(perceptionId, effectId, channelMask, gain, priority);
+}
+
+[[nodiscard]] auto Renderer::getActiveVoiceCount() const -> size_t {
+  return voicePool->getActiveVoiceCount();
+}
+
+auto Renderer::start() -> void { playing = true; }
+
+auto Renderer::stop() -> void { playing = false; }
+
+auto Renderer::seek(double position) -> void {
+  const double sample = std::round(std::max(position, 0.0) * fs / static_cast<double>(timescale));
+  requestedSeek = static_cast<uint32_t>(std::min(sample, static_cast<double>(sampleCount)));
+}
+
+[[nodiscard]] auto Renderer::isPlaying() const -> bool { return playing; }
+
+[[nodiscard]] auto Renderer::getSamplePosition() const -> uint32_t { return samplePosition; }
+
+[[nodiscard]] auto Renderer::getSampleCount() const -> uint32_t { return sampleCount; }
+
+[[nodiscard]] auto Renderer::getChannelCount() const -> size_t { return channelCount; }
+
+[[nodiscard]] auto Renderer::getMaxFrames() const -> size_t { return maxFrames; }
+
+} // namespace haptics::synthesizer
@@ -0,0 +1,211 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Synthesizer/include/VoicePool.h>
+#include <Tools/include/SignalKernels.h>
+#include <algorithm>
+
+namespace haptics::synthesizer {
+
+namespace {
+// First band of the perception with a Reference effect to the library effect id
+auto findReferencingBand(types::Perception &perception, int id) -> const types::Band * {
+  for (uint32_t j = 0; j < perception.getChannelsSize(); j++) {
+    types::Channel &channel = perception.getChannelAt((int)j);
+    for (uint32_t k = 0; k < channel.getBandsSize(); k++) {
+      types::Band &band = channel.getBandAt((int)k);
+      for (uint32_t e = 0; e < band.getEffectsSize(); e++) {
+        types::Effect &effect = band.getEffectAt((int)e);
+        if (effect.getEffectType() == types::EffectType::Reference && effect.getId() == id) {
+          return &band;
+        }
+      }
+    }
+  }
+  return nullptr;
+}
+} // namespace
+
+VoicePool::VoicePool(types::Haptics &haptic, int fs, size_t voiceCount, size_t maxFrames)
+    : voices(voiceCount)
+    , triggerSlots(TRIGGER_QUEUE_LENGTH)
+    , channelBlocks(MAX_CHANNELS, std::vector<double>(maxFrames)) {
+  for (size_t i = 0; i < TRIGGER_QUEUE_LENGTH; i++) {
+    triggerSlots[i].sequence = i;
+  }
+  const unsigned int timescale = haptic.getTimescaleOrDefault();
+  const types::Band defaultBand(types::BandType::VectorialWave, 0, fs / 2);
+  for (uint32_t i = 0; i < haptic.getPerceptionsSize(); i++) {
+    types::Perception &perception = haptic.getPerceptionAt((int)i);
+    for (uint32_t e = 0; e < perception.getEffectLibrarySize(); e++) {
+      const int id = perception.getBasisEffectAt((int)e).getId();
+      const types::Band *band = findReferencingBand(perception, id);
+      std::optional<std::vector<double>> samples =
+          perception.renderLibraryEffect(id, band != nullptr ? *band : defaultBand, fs, timescale);
+      if (samples.has_value()) {
+        library.push_back({perception.getId(), id, perception.getPriorityOrDefault(),
+                           std::make_shared<const std::vector<double>>(std::move(*samples))});
+      }
+    }
+  }
+  std::sort(library.begin(), library.end(), [](const LibraryEntry &a, const LibraryEntry &b) {
+    return std::make_pair(a.perceptionId, a.effectId) < std::make_pair(b.perceptionId, b.effectId);
+  });
+}
+
+auto VoicePool::trigger(int perceptionId, int effectId, uint64_t newChannelMask, double gain,
+                        std::optional<int> priority) -> bool {
+  const LibraryEntry *entry = findEntry(perceptionId, effectId);
+  if (entry == nullptr) {
+    return false;
+  }
+  size_t position = triggerWrite.load(std::memory_order_relaxed);
+  while (true) {
+    TriggerSlot &slot = triggerSlots[position % TRIGGER_QUEUE_LENGTH];
+    const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence == position) {
+      if (triggerWrite.compare_exchange_weak(position, position + 1,
+                                             std::memory_order_relaxed)) {
+        slot.trigger = {entry, newChannelMask, gain, priority.value_or(entry->priority)};
+        slot.sequence.store(position + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (sequence < position) {
+      // The slot still holds a trigger from the previous round: the queue is full
+      return false;
+    } else {
+      position = triggerWrite.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+auto VoicePool::startTriggeredVoices() -> void {
+  while (true) {
+    TriggerSlot &slot = triggerSlots[triggerRead % TRIGGER_QUEUE_LENGTH];
+    if (slot.sequence.load(std::memory_order_acquire) != triggerRead + 1) {
+      return;
+    }
+    startVoice(slot.trigger);
+    slot.sequence.store(triggerRead + TRIGGER_QUEUE_LENGTH, std::memory_order_release);
+    triggerRead++;
+  }
+}
+
+auto VoicePool::startVoice(const Trigger &newTrigger) -> void {
+  const Voice voice = {newTrigger.entry->samples.get(), 0, newTrigger.channelMask,
+                       newTrigger.gain, newTrigger.priority, triggerCount++};
+  const size_t active = activeVoices;
+  if (active < voices.size()) {
+    voices[active] = voice;
+    activeVoices = active + 1;
+    return;
+  }
+  if (voices.empty()) {
+    rejectedTriggers++;
+    return;
+  }
+  const auto stolen = std::min_element(
+      voices.begin(), voices.end(), [](const Voice &a, const Voice &b) {
+        return std::make_pair(a.priority, a.age) < std::make_pair(b.priority, b.age);
+      });
+  if (stolen->priority > voice.priority) {
+    rejectedTriggers++;
+    return;
+  }
+  *stolen = voice;
+}
+
+auto VoicePool::renderBlock(size_t length) -> void {
+  size_t active = activeVoices;
+  uint64_t newChannelMask = 0;
+  for (size_t v = 0; v < active; v++) {
+    newChannelMask |= voices[v].channelMask;
+  }
+  for (size_t c = 0; c < MAX_CHANNELS; c++) {
+    if (((newChannelMask >> c) & 1U) != 0) {
+      // Blocks were allocated for maxFrames samples: resizing them does not allocate
+      channelBlocks[c].assign(length, 0);
+    }
+  }
+  size_t v = 0;
+  while (v < active) {
+    Voice &voice = voices[v];
+    const size_t count = std::min(length, voice.samples->size() - voice.position);
+    const double *samples = voice.samples->data() + voice.position;
+    uint64_t bits = voice.channelMask;
+    for (size_t c = 0; bits != 0; c++, bits >>= 1U) {
+      if ((bits & 1U) != 0) {
+        tools::multiplyAccumulate(samples, voice.gain, channelBlocks[c].data(), count);
+      }
+    }
+    voice.position += count;
+    if (voice.position >= voice.samples->size()) {
+      // Finished voices are replaced by the last playing voice
+      voice = voices[active - 1];
+      active--;
+    } else {
+      v++;
+    }
+  }
+  activeVoices = active;
+  channelMask = newChannelMask;
+}
+
+[[nodiscard]] auto VoicePool::findEntry(int perceptionId, int effectId) const
+    -> const LibraryEntry * {
+  const auto entry = std::lower_bound(
+      library.begin(), library.end(), std::make_pair(perceptionId, effectId),
+      [](const LibraryEntry &a, const std::pair<int, int> &key) {
+        return std::make_pair(a.perceptionId, a.effectId) < key;
+      });
+  if (entry == library.end() || entry->perceptionId != perceptionId ||
+      entry->effectId != effectId) {
+    return nullptr;
+  }
+  return &*entry;
+}
+
+[[nodiscard]] auto VoicePool::getChannelMask() const -> uint64_t { return channelMask; }
+
+[[nodiscard]] auto VoicePool::getChannelBlock(size_t channel) const
+    -> const std::vector<double> & {
+  return channelBlocks[channel];
+}
+
+[[nodiscard]] auto VoicePool::getActiveVoiceCount() const -> size_t { return activeVoices; }
+
+[[nodiscard]] auto VoicePool::getVoiceCount() const -> size_t { return voices.size(); }
+
+[[nodiscard]] auto VoicePool::getRejectedCount() const -> size_t { return rejectedTriggers; }
+
+} // namespace haptics::synthesizer
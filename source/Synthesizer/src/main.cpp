@@ -38,6 +38,7 @@
 #include <Tools/include/OHMData.h>
 #include <Types/include/Haptics.h>
 #include <filesystem>
+#include <optional>
 
 using haptics::io::IOJson;
 using haptics::io::IOStream;
@@ -46,11 +47,13 @@ using haptics::tools::InputParser;
 using haptics::types::Haptics;
 
 const int DEFAULT_FS = 8000;
+const double PERCENT = 100;
 
 void help() {
   std::cout
       << "usages: Synthesizer [-h] -f <FILE> -o <OUTPUT_FILE> [-b] [-fs <FREQUENCY_SAMPLING>] "
-         "[--pad <PADDING>] [--generate_ohm]"
+         "[--pad <PADDING>] [--threads <THREADS>] [--cache <DIRECTORY>] [--device] "
+         "[--single_precision] [--generate_ohm]"
       << std::endl
       << std::endl
       << "This piece of software ingest an MPEG Haptics binary encoded RM1 files (into its "
@@ -71,6 +74,18 @@ void help() {
       << "\t--pad <PADDING>\t\t\t\t\tadd a padding on the resulting file. The padding provided "
          "should be in milliseconds"
       << std::endl
+      << "\t--threads <THREADS>\t\t\t\tnumber of threads used to synthesize the file (default "
+         "value is 1, 0 uses every available core)"
+      << std::endl
+      << "\t--cache <DIRECTORY>\t\t\t\treuse the bands rendered by previous runs with the same "
+         "settings, storing the new ones into the directory"
+      << std::endl
+      << "\t--device\t\t\t\t\tadapt the synthesis to the reference device of each channel, "
+         "skipping or low-passing what it cannot reproduce"
+      << std::endl
+      << "\t--single_precision\t\t\t\treconstruct and mix the bands in single precision "
+         "(faster, the difference being below the 16 bits resolution of the output)"
+      << std::endl
       << "\t--generate_ohm\t\t\t\t\tgenerate an output ohm files corresponding to the file metadata"
       << std::endl;
 }
@@ -126,6 +141,22 @@ auto main(int argc, char *argv[]) -> int {
     std::cout << "The padding used will be : " << pad << "ms\n";
   }
 
+  const std::optional<size_t> threadCount = inputParser.getThreadCount("--threads");
+  if (!threadCount.has_value()) {
+    help();
+    return EXIT_FAILURE;
+  }
+  if (inputParser.cmdOptionExists("--threads")) {
+    std::cout << "The number of threads used will be : " << *threadCount << "\n";
+  }
+
+  std::optional<haptics::synthesizer::BandCache> cache;
+  const std::string cacheDirectory = inputParser.getCmdOption("--cache");
+  if (!cacheDirectory.empty()) {
+    cache.emplace(cacheDirectory);
+    std::cout << "The band cache used will be : " << cacheDirectory << "\n";
+  }
+
   Haptics hapticFile;
   if (inputParser.cmdOptionExists("-b") || inputParser.cmdOptionExists("--binary")) {
 
@@ -136,12 +167,31 @@ auto main(int argc, char *argv[]) -> int {
     IOJson::loadFile(filename, hapticFile);
   }
 
-  hapticFile.linearize();
+  if (inputParser.cmdOptionExists("--device")) {
+    const haptics::synthesizer::DeviceCullingReport report = Helper::cullForDevices(hapticFile);
+    const double savedWork =
+        report.totalWork > 0 ? PERCENT * report.culledWork / report.totalWork : 0;
+    std::cout << "Bands skipped for the reference devices : " << report.culledBands
+              << ", effects skipped : " << report.culledEffects
+              << ", bands low-passed : " << report.lowPassedBands
+              << " (about " << savedWork << "% of the synthesis work saved)\n";
+  }
+  // Library effects are rendered for the bands left by the culling only
+  hapticFile.renderLibrary(fs);
   const double timeLength = Helper::getTimeLength(hapticFile);
 
-  if (!Helper::playFile(hapticFile, timeLength, fs, pad, output)) {
+  const haptics::waveletdecoder::DecodingPrecision precision =
+      inputParser.cmdOptionExists("--single_precision")
+          ? haptics::waveletdecoder::DecodingPrecision::Single
+          : haptics::waveletdecoder::DecodingPrecision::Double;
+  if (!Helper::playFile(hapticFile, timeLength, fs, pad, output, *threadCount,
+                        cache.has_value() ? &cache.value() : nullptr, precision)) {
     return EXIT_FAILURE;
   }
+  if (cache.has_value()) {
+    std::cout << "Bands read from the cache : " << cache->getHitCount()
+              << ", bands rendered : " << cache->getMissCount() << "\n";
+  }
 
   if (inputParser.cmdOptionExists("--generate_ohm")) {
     std::filesystem::path outputPath(output);
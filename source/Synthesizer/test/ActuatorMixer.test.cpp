@@ -0,0 +1,114 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Synthesizer/include/ActuatorMixer.h>
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <vector>
+
+using haptics::synthesizer::Actuator;
+using haptics::synthesizer::ActuatorMixer;
+using haptics::types::Channel;
+using haptics::types::Haptics;
+using haptics::types::Perception;
+using haptics::types::Vector;
+
+namespace {
+constexpr uint32_t LEFT_FOREARM = 0x00002000;
+constexpr uint32_t RIGHT_FOREARM = 0x00001000;
+constexpr uint32_t ABDOMEN = 0x00000040;
+} // namespace
+
+TEST_CASE("ActuatorMixer from body parts", "[ActuatorMixer]") {
+  Haptics haptic;
+  Perception perception(0, 0, "", haptics::types::PerceptionModality::Vibrotactile);
+  Channel forearms(0, "", 1, .5F, LEFT_FOREARM | RIGHT_FOREARM);
+  Channel abdomen(1, "", 1, 1, ABDOMEN);
+  abdomen.setActuatorTarget(std::vector<Vector>{Vector(0, 1, 0), Vector(1, 1, 0)});
+  Channel everywhere(2, "", 1, .25F, 0);
+  perception.addChannel(forearms);
+  perception.addChannel(abdomen);
+  perception.addChannel(everywhere);
+  haptic.addPerception(perception);
+
+  std::vector<Actuator> actuators = {
+      {LEFT_FOREARM, std::nullopt},     {RIGHT_FOREARM, std::nullopt},
+      {ABDOMEN, Vector(0, 0, 0)},       {ABDOMEN, Vector(0, 1, 0)},
+      {ABDOMEN, Vector(1, 1, 0)},       {ABDOMEN, std::nullopt},
+  };
+  ActuatorMixer mixer(haptic, actuators);
+  REQUIRE(mixer.getActuatorCount() == actuators.size());
+  CHECK(mixer.getChannelCount() == 3);
+  CHECK(mixer.getNonZeroCount() == 10);
+  const std::vector<std::vector<double>> expected = {
+      {.5, 0, .25}, {.5, 0, .25}, {0, 0, .25}, {0, 1, .25}, {0, 1, .25}, {0, 0, .25}};
+  for (size_t a = 0; a < actuators.size(); a++) {
+    for (size_t c = 0; c < 3; c++) {
+      CHECK(mixer.getGain(a, c) == expected[a][c]);
+    }
+  }
+
+  SECTION("setGain") {
+    mixer.setGain(2, 0, 2);
+    mixer.setGain(3, 1, .5);
+    mixer.setGain(7, 1, 1);
+    CHECK(mixer.getActuatorCount() == 8);
+    CHECK(mixer.getNonZeroCount() == 12);
+    CHECK(mixer.getGain(2, 0) == 2);
+    CHECK(mixer.getGain(2, 2) == .25);
+    CHECK(mixer.getGain(3, 1) == .5);
+    CHECK(mixer.getGain(6, 1) == 0);
+    CHECK(mixer.getGain(7, 1) == 1);
+  }
+
+  SECTION("mix") {
+    const size_t length = 37;
+    std::vector<std::vector<double>> channelAmp(3, std::vector<double>(length));
+    for (size_t i = 0; i < length; i++) {
+      channelAmp[0][i] = static_cast<double>(i) / length;
+      channelAmp[1][i] = -static_cast<double>(i) / length;
+      channelAmp[2][i] = i % 2 == 0 ? 1 : -1;
+    }
+    std::vector<std::vector<double>> actuatorAmp(actuators.size(), std::vector<double>(length, 9));
+    mixer.mix(channelAmp, length, actuatorAmp);
+    for (size_t a = 0; a < actuators.size(); a++) {
+      for (size_t i = 0; i < length; i++) {
+        double value = 0;
+        for (size_t c = 0; c < 3; c++) {
+          value += expected[a][c] * channelAmp[c][i];
+        }
+        REQUIRE(actuatorAmp[a][i] == Approx(std::clamp(value, -1.0, 1.0)));
+      }
+    }
+  }
+}
@@ -0,0 +1,209 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Synthesizer/include/BandCache.h>
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+using haptics::synthesizer::BandCache;
+using haptics::synthesizer::CachedBand;
+using haptics::synthesizer::CachedBandWriter;
+using haptics::types::Band;
+using haptics::types::BandType;
+using haptics::types::BaseSignal;
+using haptics::types::CurveType;
+using haptics::types::Effect;
+using haptics::types::EffectType;
+
+namespace {
+constexpr int FS = 8000;
+constexpr unsigned int TIMESCALE = 1000;
+
+auto makeBand() -> Band {
+  Band band(BandType::VectorialWave, CurveType::Unknown, 0, 1000);
+  Effect effect(10, 0, BaseSignal::Sine, EffectType::Basis);
+  effect.addKeyframe(0, .5, 90);
+  effect.addKeyframe(60, .8, 250);
+  band.addEffect(effect);
+  Effect reference(100, EffectType::Reference);
+  reference.setId(4);
+  band.addEffect(reference);
+  return band;
+}
+} // namespace
+
+TEST_CASE("BandCache::getBandKey", "[BandCache]") {
+  Band band = makeBand();
+  Band same = makeBand();
+  const uint64_t key = BandCache::getBandKey(band, FS, 0, TIMESCALE);
+  CHECK(BandCache::getBandKey(same, FS, 0, TIMESCALE) == key);
+  CHECK(BandCache::getBandKey(band, FS * 2, 0, TIMESCALE) != key);
+  CHECK(BandCache::getBandKey(band, FS, 0, TIMESCALE * 2) != key);
+
+  SECTION("padding") {
+    CHECK(BandCache::getBandKey(band, FS, 10, TIMESCALE) == key);
+    CHECK(BandCache::getFirstSample(FS, 10) == -80);
+    const int fs = 44100;
+    const uint64_t paddedKey = BandCache::getBandKey(band, fs, 10, TIMESCALE);
+    CHECK(BandCache::getBandKey(band, fs, 0, TIMESCALE) == paddedKey);
+    CHECK(BandCache::getBandKey(band, fs, 1, TIMESCALE) != paddedKey);
+    CHECK(BandCache::getFirstSample(fs, 1) == -44);
+  }
+
+  SECTION("effects") {
+    same.getEffectAt(0).getKeyframeAt(1).setAmplitudeModulation(.7F);
+    CHECK(BandCache::getBandKey(same, FS, 0, TIMESCALE) != key);
+  }
+
+  SECTION("band") {
+    same.setUpperFrequencyLimit(500);
+    CHECK(BandCache::getBandKey(same, FS, 0, TIMESCALE) != key);
+  }
+
+  SECTION("referenced library effects") {
+    same.setReferenceRender(4, FS, std::make_shared<const std::vector<double>>(10, .5));
+    const uint64_t renderedKey = BandCache::getBandKey(same, FS, 0, TIMESCALE);
+    CHECK(renderedKey != key);
+    same.setReferenceRender(4, FS, std::make_shared<const std::vector<double>>(10, .25));
+    CHECK(BandCache::getBandKey(same, FS, 0, TIMESCALE) != renderedKey);
+  }
+}
+
+TEST_CASE("BandCache::load", "[BandCache]") {
+  const auto directory = std::filesystem::temp_directory_path() / "BandCache_test";
+  std::filesystem::remove_all(directory);
+  BandCache cache(directory);
+  REQUIRE(std::filesystem::is_directory(directory));
+  const uint64_t key = 0x0123456789abcdef;
+  // Samples [-50, 250), only [-20, 200) being stored
+  std::vector<float> samples(300);
+  for (size_t i = 30; i < 250; i++) {
+    samples[i] = static_cast<float>(i) / 300.0F - .5F;
+  }
+  samples[100] = 0;
+
+  CHECK_FALSE(cache.load(key, -50, 250).has_value());
+  REQUIRE(cache.store(key, -50, samples));
+  std::optional<CachedBand> cached = cache.load(key, -50, 250);
+  REQUIRE(cached.has_value());
+  CHECK(cached->getFirstSample() == -20);
+  REQUIRE(cached->size() == 220);
+  CHECK(std::vector<float>(cached->data(), cached->data() + cached->size()) ==
+        std::vector<float>(samples.begin() + 30, samples.begin() + 250));
+  std::vector<double> read(400, 1);
+  cached->read(-100, read.size(), read.data());
+  for (int i = 0; i < static_cast<int>(read.size()); i++) {
+    const int index = i - 100 + 50;
+    CHECK(read[i] == (index >= 0 && index < 300 ? samples[index] : 0.0F));
+  }
+  CHECK(cache.load(key, 0, 100).has_value());
+  CHECK_FALSE(cache.load(key, -51, 250).has_value());
+  CHECK_FALSE(cache.load(key, -50, 251).has_value());
+  CHECK_FALSE(cache.load(key + 1, -50, 250).has_value());
+  CHECK(cache.getHitCount() == 2);
+  CHECK(cache.getMissCount() == 4);
+
+  SECTION("silent band") {
+    REQUIRE(cache.store(key + 1, 0, std::vector<float>(300)));
+    std::optional<CachedBand> silent = cache.load(key + 1, 0, 300);
+    REQUIRE(silent.has_value());
+    CHECK(silent->size() == 0);
+    silent->read(0, read.size(), read.data());
+    CHECK(read == std::vector<double>(read.size(), 0));
+  }
+
+  SECTION("truncated file") {
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+      std::filesystem::resize_file(entry.path(), std::filesystem::file_size(entry.path()) - 4);
+    }
+    CHECK_FALSE(cache.load(key, -50, 250).has_value());
+  }
+
+  SECTION("other key") {
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+      std::filesystem::copy_file(entry.path(), directory / "0123456789abcdee.band");
+    }
+    CHECK_FALSE(cache.load(key - 1, -50, 250).has_value());
+  }
+  cached.reset();
+  std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("BandCache::beginStore", "[BandCache]") {
+  const auto directory = std::filesystem::temp_directory_path() / "BandCache_writer_test";
+  std::filesystem::remove_all(directory);
+  BandCache cache(directory);
+  const uint64_t key = 0x0123456789abcdef;
+  std::vector<float> samples(300);
+  for (size_t i = 0; i < samples.size(); i++) {
+    samples[i] = static_cast<float>(i) / 300.0F - .5F;
+  }
+  const auto fileCount = [&]() {
+    return std::distance(std::filesystem::directory_iterator(directory),
+                         std::filesystem::directory_iterator());
+  };
+
+  SECTION("chunks") {
+    // Zero samples within a chunk and over whole chunks are kept between the stored ones
+    std::fill(samples.begin(), samples.begin() + 40, 0.0F);
+    std::fill(samples.begin() + 120, samples.begin() + 200, 0.0F);
+    std::fill(samples.begin() + 280, samples.end(), 0.0F);
+    std::optional<CachedBandWriter> writer = cache.beginStore(key, 10);
+    REQUIRE(writer.has_value());
+    REQUIRE(writer->write(samples.data(), 128));
+    REQUIRE(writer->write(samples.data() + 128, 64));
+    REQUIRE(writer->write(samples.data() + 192, 108));
+    CHECK_FALSE(cache.load(key, 10, 310).has_value());
+    REQUIRE(writer->commit());
+    writer.reset();
+    CHECK(fileCount() == 1);
+    std::optional<CachedBand> cached = cache.load(key, 10, 310);
+    REQUIRE(cached.has_value());
+    CHECK(cached->getFirstSample() == 50);
+    CHECK(std::vector<float>(cached->data(), cached->data() + cached->size()) ==
+          std::vector<float>(samples.begin() + 40, samples.begin() + 280));
+  }
+
+  SECTION("not committed") {
+    std::optional<CachedBandWriter> writer = cache.beginStore(key, 0);
+    REQUIRE(writer.has_value());
+    REQUIRE(writer->write(samples.data(), samples.size()));
+    CHECK(fileCount() == 1);
+    writer.reset();
+    CHECK(fileCount() == 0);
+    CHECK_FALSE(cache.load(key, 0, 300).has_value());
+  }
+  std::filesystem::remove_all(directory);
+}
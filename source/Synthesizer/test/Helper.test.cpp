@@ -32,8 +32,336 @@
  */
 
 #include <Synthesizer/include/Helper.h>
+#include <TestSupport/include/WaveletBandFixture.h>
+#include <Tools/include/WavParser.h>
 #include <catch2/catch.hpp>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
 
 using haptics::synthesizer::Helper;
+using haptics::types::BandType;
+using haptics::types::BaseSignal;
+using haptics::types::Effect;
+using haptics::types::EffectType;
+using haptics::types::Haptics;
+
+namespace {
+auto readBytes(const std::string &filename) -> std::vector<char> {
+  std::ifstream file(filename, std::ios::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+auto makeHaptics() -> Haptics {
+  const int channelCount = 5;
+  const int bandCount = 3;
+  const int effectCount = 6;
+  Haptics haptic;
+  haptic.setTimescale(1000);
+  haptics::types::Perception perception(0, 0, "", haptics::types::PerceptionModality::Other);
+  for (int c = 0; c < channelCount; c++) {
+    haptics::types::Channel channel(c, "", 1.0F / static_cast<float>(c + 1), 1, 0);
+    for (int b = 0; b < bandCount; b++) {
+      haptics::types::Band band(BandType::VectorialWave, 0, 1000);
+      for (int e = 0; e < effectCount; e++) {
+        Effect effect(e * 70 + b * 10, 0, static_cast<BaseSignal>((c + e) % 5), EffectType::Basis);
+        effect.addKeyframe(0, .9, 60 + 20 * c);
+        effect.addKeyframe(50 + 10 * b, .4, 200);
+        effect.addKeyframe(120, .7, std::nullopt);
+        band.addEffect(effect);
+      }
+      channel.addBand(band);
+    }
+    perception.addChannel(channel);
+  }
+  haptic.addPerception(perception);
+  return haptic;
+}
+} // namespace
 
 TEST_CASE("haptics::synthesizer::Helper", "[placeholder]") { CHECK(true); }
+
+TEST_CASE("Helper::playFile with several threads", "[playFile]") {
+  const int fs = 8000;
+  const int pad = 10;
+  const auto directory = std::filesystem::temp_directory_path();
+  std::string serialFilename = (directory / "playFile_serial.wav").string();
+  std::string parallelFilename = (directory / "playFile_parallel.wav").string();
+
+  Haptics serialHaptic = makeHaptics();
+  Haptics parallelHaptic = makeHaptics();
+  const double timeLength = Helper::getTimeLength(serialHaptic);
+  REQUIRE(Helper::playFile(serialHaptic, timeLength, fs, pad, serialFilename, 1));
+  REQUIRE(Helper::playFile(parallelHaptic, timeLength, fs, pad, parallelFilename, 4));
+
+  const std::vector<char> serialBytes = readBytes(serialFilename);
+  CHECK_FALSE(serialBytes.empty());
+  CHECK(serialBytes == readBytes(parallelFilename));
+  std::filesystem::remove(serialFilename);
+  std::filesystem::remove(parallelFilename);
+}
+
+TEST_CASE("Helper::playFile by chunks", "[playFile]") {
+  const int fs = 8000;
+  const int pad = 100;
+  const auto directory = std::filesystem::temp_directory_path();
+  std::string filename = (directory / "playFile_chunks.wav").string();
+  std::string referenceFilename = (directory / "playFile_reference.wav").string();
+
+  Haptics haptic = makeHaptics();
+  const double timeLength = Helper::getTimeLength(haptic);
+  const auto sampleCount = static_cast<uint32_t>(
+      std::round(fs * (timeLength + 2 * pad) / haptic.getTimescale().value()));
+  REQUIRE(sampleCount > haptics::synthesizer::SYNTHESIS_CHUNK_LENGTH);
+  REQUIRE(sampleCount % haptics::synthesizer::SYNTHESIS_CHUNK_LENGTH != 0);
+
+  // Reference: every channel synthesized at once
+  std::vector<std::vector<double>> amplitudes;
+  Haptics referenceHaptic = makeHaptics();
+  haptics::types::Perception &perception = referenceHaptic.getPerceptionAt(0);
+  for (uint32_t c = 0; c < perception.getChannelsSize(); c++) {
+    haptics::types::Channel &channel = perception.getChannelAt(static_cast<int>(c));
+    std::vector<double> channelAmp =
+        channel.EvaluateChannel(sampleCount, fs, pad, referenceHaptic.getTimescale().value());
+    for (double &amplitude : channelAmp) {
+      amplitude = amplitude * channel.getGain() * 1.0;
+    }
+    amplitudes.push_back(channelAmp);
+  }
+  REQUIRE(haptics::tools::WavParser::saveFile(referenceFilename, amplitudes, fs));
+
+  REQUIRE(Helper::playFile(haptic, timeLength, fs, pad, filename));
+  CHECK(readBytes(filename) == readBytes(referenceFilename));
+  std::filesystem::remove(filename);
+  std::filesystem::remove(referenceFilename);
+}
+
+TEST_CASE("Helper::playFile with encoded wavelet bands", "[playFile]") {
+  const int blockCount = 80;
+  const int bandFs = 8000;
+  const int pad = 10;
+  const auto directory = std::filesystem::temp_directory_path();
+  std::string filename = (directory / "playFile_encoded.wav").string();
+  std::string referenceFilename = (directory / "playFile_decoded.wav").string();
+
+  Haptics haptic;
+  haptic.setTimescale(1000);
+  haptics::types::Perception perception(0, 0, "", haptics::types::PerceptionModality::Other);
+  haptics::types::Channel channel(0, "", 1, 1, 0);
+  haptics::types::Band encodedBand =
+      haptics::testsupport::makeWaveletBand(blockCount, bandFs, 128);
+  channel.addBand(encodedBand);
+  perception.addChannel(channel);
+  haptic.addPerception(perception);
+  Haptics decodedHaptic = haptic;
+  haptics::types::Band &decodedBand = decodedHaptic.getPerceptionAt(0).getChannelAt(0).getBandAt(0);
+  haptics::waveletdecoder::WaveletDecoder().transformBand(decodedBand, 1000);
+
+  // The blocks are decoded chunk by chunk, resampled ones with the blocks around the chunks
+  const double timeLength = Helper::getTimeLength(haptic);
+  haptics::types::Band &band = haptic.getPerceptionAt(0).getChannelAt(0).getBandAt(0);
+  for (const int fs : {bandFs, 12000}) {
+    REQUIRE(fs * timeLength / 1000 > 2 * haptics::synthesizer::SYNTHESIS_CHUNK_LENGTH);
+    REQUIRE(Helper::playFile(haptic, timeLength, fs, pad, filename, 2));
+    REQUIRE(Helper::playFile(decodedHaptic, timeLength, fs, pad, referenceFilename, 2));
+    CHECK(readBytes(filename) == readBytes(referenceFilename));
+
+    // The decoded blocks are released once the file is written
+    for (int b = 0; b < blockCount; b++) {
+      CHECK(band.getWaveletSamplesAt(b).empty());
+      CHECK_FALSE(band.getWaveletBitstreamAt(b).empty());
+    }
+  }
+  std::filesystem::remove(filename);
+  std::filesystem::remove(referenceFilename);
+}
+
+TEST_CASE("Helper::playFile in single precision", "[playFile]") {
+  const int fs = 8000;
+  const int pad = 10;
+  const auto directory = std::filesystem::temp_directory_path();
+  std::string filename = (directory / "playFile_single.wav").string();
+  std::string referenceFilename = (directory / "playFile_double.wav").string();
+
+  Haptics haptic = makeHaptics();
+  haptics::types::Band waveletBand = haptics::testsupport::makeWaveletBand(60, fs, 128);
+  haptic.getPerceptionAt(0).getChannelAt(0).addBand(waveletBand);
+  Haptics referenceHaptic = haptic;
+  const double timeLength = Helper::getTimeLength(haptic);
+  REQUIRE(Helper::playFile(haptic, timeLength, fs, pad, filename, 2, nullptr,
+                           haptics::waveletdecoder::DecodingPrecision::Single));
+  REQUIRE(Helper::playFile(referenceHaptic, timeLength, fs, pad, referenceFilename, 2));
+
+  // Samples are at most rounded to the neighbouring 16 bits value
+  haptics::tools::WavParser single;
+  haptics::tools::WavParser reference;
+  REQUIRE(single.loadFile(filename));
+  REQUIRE(reference.loadFile(referenceFilename));
+  REQUIRE(single.getNumSamples() == reference.getNumSamples());
+  const std::vector<std::vector<double>> singleSamples = single.getAllSamples();
+  const std::vector<std::vector<double>> referenceSamples = reference.getAllSamples();
+  REQUIRE(singleSamples.size() == referenceSamples.size());
+  for (size_t c = 0; c < singleSamples.size(); c++) {
+    for (size_t i = 0; i < singleSamples[c].size(); i++) {
+      REQUIRE(singleSamples[c][i] == Approx(referenceSamples[c][i]).margin(1.5 / 32768));
+    }
+  }
+  std::filesystem::remove(filename);
+  std::filesystem::remove(referenceFilename);
+}
+
+TEST_CASE("Helper::playFile with a band cache", "[playFile]") {
+  const int fs = 8000;
+  const int pad = 10;
+  const auto directory = std::filesystem::temp_directory_path();
+  const auto cacheDirectory = directory / "playFile_cache";
+  std::filesystem::remove_all(cacheDirectory);
+  std::string filename = (directory / "playFile_cached.wav").string();
+  std::string referenceFilename = (directory / "playFile_uncached.wav").string();
+  const size_t bandCount = 15;
+
+  Haptics haptic = makeHaptics();
+  const double timeLength = Helper::getTimeLength(haptic);
+  haptics::synthesizer::BandCache cache(cacheDirectory);
+  REQUIRE(Helper::playFile(haptic, timeLength, fs, pad, referenceFilename, 2, &cache));
+  CHECK(cache.getMissCount() == bandCount);
+  CHECK(cache.getHitCount() == 0);
+
+  Haptics cachedHaptic = makeHaptics();
+  REQUIRE(Helper::playFile(cachedHaptic, timeLength, fs, pad, filename, 2, &cache));
+  CHECK(cache.getHitCount() == bandCount);
+  const std::vector<char> referenceBytes = readBytes(referenceFilename);
+  CHECK_FALSE(referenceBytes.empty());
+  CHECK(readBytes(filename) == referenceBytes);
+
+  Haptics modifiedHaptic = makeHaptics();
+  modifiedHaptic.getPerceptionAt(0).getChannelAt(2).getBandAt(1).getEffectAt(0).addKeyframe(
+      200, .1, 300);
+  REQUIRE(Helper::playFile(modifiedHaptic, timeLength, fs, pad, filename, 2, &cache));
+  CHECK(cache.getHitCount() == 2 * bandCount - 1);
+  CHECK(cache.getMissCount() == bandCount + 1);
+  CHECK(readBytes(filename) != referenceBytes);
+
+  // The cached bands are read back with a shorter padding and length, which they cover
+  const size_t hitCount = cache.getHitCount();
+  Haptics shorterHaptic = makeHaptics();
+  REQUIRE(Helper::playFile(shorterHaptic, timeLength - 50, fs, pad / 2, filename, 2, &cache));
+  CHECK(cache.getHitCount() == hitCount + bandCount);
+  const auto otherCacheDirectory = directory / "playFile_other_cache";
+  std::filesystem::remove_all(otherCacheDirectory);
+  haptics::synthesizer::BandCache otherCache(otherCacheDirectory);
+  REQUIRE(Helper::playFile(shorterHaptic, timeLength - 50, fs, pad / 2, referenceFilename, 2,
+                           &otherCache));
+  CHECK(otherCache.getMissCount() == bandCount);
+  CHECK(readBytes(filename) == readBytes(referenceFilename));
+  std::filesystem::remove(filename);
+  std::filesystem::remove(referenceFilename);
+  std::filesystem::remove_all(cacheDirectory);
+  std::filesystem::remove_all(otherCacheDirectory);
+}
+
+TEST_CASE("Helper::cullForDevices", "[cullForDevices]") {
+  using haptics::types::Band;
+  using haptics::types::Channel;
+  using haptics::types::CurveType;
+  const int bandFs = 2000;
+  const int blockSamples = 64;
+  Haptics haptic;
+  haptic.setTimescale(1000);
+  haptics::types::Perception perception(0, 0, "", haptics::types::PerceptionModality::Other);
+  haptics::types::ReferenceDevice device(3, "ERM");
+  device.setMinimumFrequency(60);
+  device.setMaximumFrequency(150);
+  perception.addReferenceDevice(device);
+
+  Channel targeted(0, "", 1, 1, 0);
+  targeted.setReferenceDeviceId(3);
+  Channel untargeted(1, "", 1, 1, 0);
+  Band vectorial(BandType::VectorialWave, CurveType::Unknown, 0, 1000);
+  for (int frequency : {100, 400, 120}) {
+    Effect effect(static_cast<int>(vectorial.getEffectsSize()) * 100, 0, BaseSignal::Sine,
+                  EffectType::Basis);
+    effect.addKeyframe(0, .5, frequency);
+    effect.addKeyframe(80, .5, frequency);
+    vectorial.addEffect(effect);
+  }
+  Band high(BandType::VectorialWave, CurveType::Unknown, 300, 1000);
+  Effect highEffect(0, 0, BaseSignal::Sine, EffectType::Basis);
+  highEffect.addKeyframe(0, .5, 500);
+  highEffect.addKeyframe(40, .5, 500);
+  high.addEffect(highEffect);
+  Band curve(BandType::Curve, CurveType::Linear, 0, 72);
+  Effect curveEffect(0, EffectType::Basis);
+  curveEffect.addKeyframe(0, .5, std::nullopt);
+  curveEffect.addKeyframe(100, .1, std::nullopt);
+  curve.addEffect(curveEffect);
+  // Decoded wavelet band: a constant signal and a 900 Hz sine
+  Band wavelet(BandType::WaveletWave, blockSamples * 1000 / bandFs, 0, bandFs);
+  for (int b = 0; b < 4; b++) {
+    Effect block(b * blockSamples * 1000 / bandFs, EffectType::Basis);
+    std::vector<double> samples(blockSamples);
+    for (int i = 0; i < blockSamples; i++) {
+      samples[i] = .25 + .5 * std::sin(2 * M_PI * 900 * (b * blockSamples + i) / bandFs);
+    }
+    block.setWaveletSamples(samples);
+    wavelet.addEffect(block);
+  }
+  targeted.addBand(vectorial);
+  targeted.addBand(high);
+  targeted.addBand(curve);
+  targeted.addBand(wavelet);
+  untargeted.addBand(high);
+  perception.addChannel(targeted);
+  perception.addChannel(untargeted);
+  haptic.addPerception(perception);
+
+  const haptics::synthesizer::DeviceCullingReport report = Helper::cullForDevices(haptic);
+  CHECK(report.culledBands == 1);
+  CHECK(report.culledEffects == 1);
+  CHECK(report.lowPassedBands == 1);
+  CHECK(report.totalWork == Approx(3 * 80 + 40 + 100 + 4 * 32 + 40));
+  CHECK(report.culledWork == Approx(40 + 80));
+
+  Channel &channel = haptic.getPerceptionAt(0).getChannelAt(0);
+  REQUIRE(channel.getBandsSize() == 3);
+  Band &culledVectorial = channel.getBandAt(0);
+  REQUIRE(culledVectorial.getEffectsSize() == 2);
+  CHECK(culledVectorial.getEffectAt(0).getKeyframeAt(0).getFrequencyModulation() == 100);
+  CHECK(culledVectorial.getEffectAt(1).getKeyframeAt(0).getFrequencyModulation() == 120);
+  CHECK(channel.getBandAt(1).getBandType() == BandType::Curve);
+  Band &lowPassed = channel.getBandAt(2);
+  CHECK(lowPassed.getWaveletLowPassFrequency() == std::optional<double>(150));
+  const std::vector<double> &lastBlock = lowPassed.getEffectAt(3).getWaveletSamples();
+  for (double sample : lastBlock) {
+    CHECK(sample == Approx(.25).margin(.02));
+  }
+  CHECK(haptic.getPerceptionAt(0).getChannelAt(1).getBandsSize() == 1);
+}
+
+TEST_CASE("Helper::cullForDevices with encoded wavelet bands", "[cullForDevices]") {
+  Haptics haptic;
+  haptic.setTimescale(1000);
+  haptics::types::Perception perception(0, 0, "", haptics::types::PerceptionModality::Other);
+  haptics::types::ReferenceDevice device(3, "ERM");
+  device.setMinimumFrequency(60);
+  device.setMaximumFrequency(150);
+  perception.addReferenceDevice(device);
+  haptics::types::Channel channel(0, "", 1, 1, 0);
+  channel.setReferenceDeviceId(3);
+  haptics::types::Band wavelet = haptics::testsupport::makeWaveletBand(4, 2000, 64);
+  channel.addBand(wavelet);
+  perception.addChannel(channel);
+  haptic.addPerception(perception);
+
+  const haptics::synthesizer::DeviceCullingReport report = Helper::cullForDevices(haptic);
+  CHECK(report.lowPassedBands == 1);
+  // The blocks are left encoded, to be low-passed as they are decoded
+  haptics::types::Band &lowPassed = haptic.getPerceptionAt(0).getChannelAt(0).getBandAt(0);
+  CHECK(lowPassed.getWaveletLowPassFrequency() == std::optional<double>(150));
+  for (int b = 0; b < static_cast<int>(lowPassed.getEffectsSize()); b++) {
+    CHECK_FALSE(lowPassed.getEffectAt(b).getWaveletBitstream().empty());
+    CHECK(lowPassed.getEffectAt(b).getWaveletSamples().empty());
+  }
+}
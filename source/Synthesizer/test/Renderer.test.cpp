@@ -0,0 +1,483 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Synthesizer/include/Helper.h>
+#include <Synthesizer/include/Renderer.h>
+#include <TestSupport/include/WaveletBandFixture.h>
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using haptics::synthesizer::Renderer;
+using haptics::testsupport::makeWaveletBand;
+using haptics::types::Band;
+using haptics::types::BandType;
+using haptics::types::BaseSignal;
+using haptics::types::Channel;
+using haptics::types::Effect;
+using haptics::types::EffectType;
+using haptics::types::Haptics;
+using haptics::types::Perception;
+
+namespace {
+constexpr int FS = 8000;
+
+auto makeHaptics(int channelCount, int effectCount) -> Haptics {
+  Haptics haptic;
+  haptic.setTimescale(1000);
+  Perception perception(0, 0, "", haptics::types::PerceptionModality::Vibrotactile);
+  for (int c = 0; c < channelCount; c++) {
+    Channel channel(c, "", 1.0F - static_cast<float>(c) * .1F, 1, 0);
+    Band vectorial(BandType::VectorialWave, 0, 1000);
+    Band transient(BandType::Transient, haptics::types::CurveType::Unknown, 0, 1000);
+    for (int e = 0; e < effectCount; e++) {
+      Effect effect(e * 45 + c * 5, 0, static_cast<BaseSignal>(e % 5), EffectType::Basis);
+      effect.addKeyframe(0, .8, 90 + 10 * c);
+      effect.addKeyframe(30, .3, 250);
+      effect.addKeyframe(70, .6, std::nullopt);
+      vectorial.addEffect(effect);
+      Effect transientEffect(e * 45 + 20, 0, BaseSignal::Sine, EffectType::Basis);
+      transientEffect.addKeyframe(0, .5, 150);
+      transientEffect.addKeyframe(10, .4, 200);
+      transient.addEffect(transientEffect);
+    }
+    channel.addBand(vectorial);
+    channel.addBand(transient);
+    perception.addChannel(channel);
+  }
+  haptic.addPerception(perception);
+  return haptic;
+}
+
+// Channels of the file synthesized at once, as the offline synthesizer does
+auto referenceSignal(Haptics haptic, uint32_t sampleCount) -> std::vector<std::vector<float>> {
+  std::vector<std::vector<float>> res;
+  Perception &perception = haptic.getPerceptionAt(0);
+  for (uint32_t c = 0; c < perception.getChannelsSize(); c++) {
+    Channel &channel = perception.getChannelAt(static_cast<int>(c));
+    std::vector<double> channelAmp = channel.EvaluateChannel(sampleCount, FS, 0, 1000);
+    std::vector<float> channelSignal(sampleCount);
+    for (uint32_t i = 0; i < sampleCount; i++) {
+      channelSignal[i] = static_cast<float>(channelAmp[i] * channel.getGain() * 1.0);
+    }
+    res.push_back(channelSignal);
+  }
+  return res;
+}
+} // namespace
+
+TEST_CASE("Renderer::render", "[Renderer]") {
+  const int channelCount = 3;
+  const size_t maxFrames = 64;
+  Haptics haptic = makeHaptics(channelCount, 8);
+  Renderer renderer(haptic, FS, maxFrames);
+  REQUIRE(renderer.getChannelCount() == channelCount);
+  REQUIRE(renderer.getSampleCount() > 0);
+  const std::vector<std::vector<float>> reference =
+      referenceSignal(haptic, renderer.getSampleCount());
+
+  SECTION("whole file") {
+    const size_t outputChannels = channelCount + 1;
+    std::vector<float> out(maxFrames * outputChannels);
+    renderer.start();
+    uint32_t position = 0;
+    while (renderer.isPlaying()) {
+      const size_t frames = renderer.render(out.data(), maxFrames, outputChannels);
+      for (size_t i = 0; i < frames; i++) {
+        for (size_t c = 0; c < channelCount; c++) {
+          REQUIRE(out[i * outputChannels + c] == reference[c][position + i]);
+        }
+        CHECK(out[i * outputChannels + channelCount] == 0);
+      }
+      position += static_cast<uint32_t>(frames);
+    }
+    CHECK(position == renderer.getSampleCount());
+    CHECK(renderer.render(out.data(), maxFrames, outputChannels) == 0);
+  }
+
+  SECTION("blocks larger than maxFrames") {
+    const size_t frames = 3 * maxFrames + 5;
+    std::vector<float> out(frames * channelCount);
+    renderer.start();
+    REQUIRE(renderer.render(out.data(), frames, channelCount) == frames);
+    for (size_t i = 0; i < frames; i++) {
+      for (size_t c = 0; c < channelCount; c++) {
+        REQUIRE(out[i * channelCount + c] == reference[c][i]);
+      }
+    }
+  }
+
+  SECTION("16 bits output") {
+    Renderer pcmRenderer(haptic, FS, maxFrames);
+    std::vector<float> out(maxFrames * channelCount);
+    std::vector<int16_t> pcm(maxFrames * channelCount);
+    renderer.start();
+    pcmRenderer.start();
+    while (renderer.isPlaying()) {
+      const size_t frames = renderer.render(out.data(), maxFrames, channelCount);
+      REQUIRE(pcmRenderer.render(pcm.data(), maxFrames, channelCount) == frames);
+      for (size_t i = 0; i < frames * channelCount; i++) {
+        REQUIRE(std::abs(pcm[i] / 32768.0 - out[i]) <= 1 / 32768.0);
+      }
+    }
+    CHECK_FALSE(pcmRenderer.isPlaying());
+  }
+
+  SECTION("actuator mixer") {
+    haptics::synthesizer::ActuatorMixer mixer;
+    mixer.setGain(0, 0, 1);
+    mixer.setGain(0, 1, .5);
+    mixer.setGain(1, 2, 1);
+    renderer.setActuatorMixer(mixer);
+    const size_t outputChannels = 3;
+    std::vector<float> out(maxFrames * outputChannels);
+    renderer.start();
+    uint32_t position = 0;
+    while (renderer.isPlaying()) {
+      const size_t frames = renderer.render(out.data(), maxFrames, outputChannels);
+      for (size_t i = 0; i < frames; i++) {
+        const double first = reference[0][position + i] + .5 * reference[1][position + i];
+        REQUIRE(out[i * outputChannels] == Approx(std::clamp(first, -1.0, 1.0)).margin(1e-6));
+        REQUIRE(out[i * outputChannels + 1] == Approx(reference[2][position + i]).margin(1e-6));
+        CHECK(out[i * outputChannels + 2] == 0);
+      }
+      position += static_cast<uint32_t>(frames);
+    }
+  }
+
+  SECTION("start, stop and seek") {
+    std::vector<float> out(maxFrames, 1);
+    CHECK_FALSE(renderer.isPlaying());
+    CHECK(renderer.render(out.data(), maxFrames, 1) == 0);
+    CHECK(std::all_of(out.begin(), out.end(), [](float v) { return v == 0; }));
+
+    renderer.start();
+    CHECK(renderer.render(out.data(), maxFrames, 1) == maxFrames);
+    renderer.stop();
+    CHECK(renderer.render(out.data(), maxFrames, 1) == 0);
+    CHECK(renderer.getSamplePosition() == maxFrames);
+
+    const double seekPosition = 125; // ticks
+    const auto seekSample = static_cast<uint32_t>(seekPosition * FS / 1000);
+    renderer.seek(seekPosition);
+    renderer.start();
+    REQUIRE(renderer.render(out.data(), maxFrames, 1) == maxFrames);
+    for (size_t i = 0; i < maxFrames; i++) {
+      REQUIRE(out[i] == reference[0][seekSample + i]);
+    }
+    CHECK(renderer.getSamplePosition() == seekSample + maxFrames);
+  }
+}
+
+TEST_CASE("Renderer::setCpuBudget", "[Renderer]") {
+  const int channelCount = 3;
+  const size_t maxFrames = 64;
+  // The last channel is the most important one and, within a channel, the vectorial band is more
+  // important than the transient band
+  Haptics haptic = makeHaptics(channelCount, 8);
+  Perception &perception = haptic.getPerceptionAt(0);
+  for (uint32_t c = 0; c < channelCount; c++) {
+    Channel &channel = perception.getChannelAt(static_cast<int>(c));
+    channel.setPriority(static_cast<int>(c));
+    channel.getBandAt(0).setPriority(1);
+  }
+  Renderer renderer(haptic, FS, maxFrames);
+  const std::vector<std::vector<float>> reference =
+      referenceSignal(haptic, renderer.getSampleCount());
+  std::vector<float> out(maxFrames * channelCount);
+  renderer.start();
+
+  SECTION("large budget") {
+    renderer.setCpuBudget(1e9, maxFrames);
+    uint32_t position = 0;
+    while (renderer.isPlaying()) {
+      const size_t frames = renderer.render(out.data(), maxFrames, channelCount);
+      CHECK(renderer.getDroppedBands().empty());
+      for (size_t i = 0; i < frames; i++) {
+        for (size_t c = 0; c < channelCount; c++) {
+          REQUIRE(out[i * channelCount + c] == reference[c][position + i]);
+        }
+      }
+      position += static_cast<uint32_t>(frames);
+    }
+  }
+
+  SECTION("exhausted budget") {
+    renderer.setCpuBudget(1e-9, maxFrames);
+    // The cost of the bands is unknown until they have been rendered once
+    REQUIRE(renderer.render(out.data(), maxFrames, channelCount) == maxFrames);
+    CHECK(renderer.getDroppedBands().empty());
+    REQUIRE(renderer.render(out.data(), maxFrames, channelCount) == maxFrames);
+    const std::vector<haptics::synthesizer::DroppedBand> &dropped = renderer.getDroppedBands();
+    REQUIRE(dropped.size() == 2 * channelCount);
+    for (size_t d = 0; d < dropped.size(); d++) {
+      CHECK(dropped[d].channel == channelCount - 1 - d / 2);
+      CHECK(dropped[d].band == static_cast<int>(d % 2));
+    }
+    CHECK(std::all_of(out.begin(), out.end(), [](float v) { return v == 0; }));
+
+    renderer.setCpuBudget(0, maxFrames);
+    REQUIRE(renderer.render(out.data(), maxFrames, channelCount) == maxFrames);
+    CHECK(renderer.getDroppedBands().empty());
+    for (size_t i = 0; i < maxFrames; i++) {
+      for (size_t c = 0; c < channelCount; c++) {
+        REQUIRE(out[i * channelCount + c] == reference[c][2 * maxFrames + i]);
+      }
+    }
+  }
+}
+
+TEST_CASE("Renderer::publish", "[Renderer]") {
+  const int channelCount = 3;
+  const size_t maxFrames = 64;
+  const Haptics first = makeHaptics(channelCount, 8);
+  Haptics second = makeHaptics(channelCount, 5);
+  second.getPerceptionAt(0).getChannelAt(1).setGain(.5F);
+  Renderer renderer(first, FS, maxFrames);
+  const std::vector<std::vector<float>> firstReference =
+      referenceSignal(first, renderer.getSampleCount());
+  const std::vector<std::vector<float>> secondReference =
+      referenceSignal(second, renderer.getSampleCount());
+  std::vector<float> out(maxFrames * channelCount);
+  renderer.start();
+  REQUIRE(renderer.render(out.data(), maxFrames, channelCount) == maxFrames);
+
+  SECTION("whole file") {
+    renderer.publish(second);
+    // The previous file is still rendered until the next call to render
+    CHECK(renderer.getSampleCount() == Renderer(first, FS, maxFrames).getSampleCount());
+    uint32_t position = maxFrames;
+    while (renderer.isPlaying()) {
+      const size_t frames = renderer.render(out.data(), maxFrames, channelCount);
+      for (size_t i = 0; i < frames; i++) {
+        for (size_t c = 0; c < channelCount; c++) {
+          REQUIRE(out[i * channelCount + c] == secondReference[c][position + i]);
+        }
+      }
+      position += static_cast<uint32_t>(frames);
+    }
+    CHECK(position == renderer.getSampleCount());
+  }
+
+  SECTION("single channel") {
+    CHECK_FALSE(renderer.updateChannel(channelCount, second.getPerceptionAt(0).getChannelAt(1)));
+    REQUIRE(renderer.updateChannel(1, second.getPerceptionAt(0).getChannelAt(1)));
+    REQUIRE(renderer.render(out.data(), maxFrames, channelCount) == maxFrames);
+    for (size_t i = 0; i < maxFrames; i++) {
+      CHECK(out[i * channelCount] == firstReference[0][maxFrames + i]);
+      CHECK(out[i * channelCount + 1] == secondReference[1][maxFrames + i]);
+      CHECK(out[i * channelCount + 2] == firstReference[2][maxFrames + i]);
+    }
+  }
+
+  SECTION("actuator mixer set after publish") {
+    renderer.publish(second);
+    haptics::synthesizer::ActuatorMixer mixer;
+    mixer.setGain(0, 0, 1);
+    mixer.setGain(0, 1, .5);
+    mixer.setGain(1, 2, 1);
+    renderer.setActuatorMixer(mixer);
+    const size_t outputChannels = 2;
+    REQUIRE(renderer.render(out.data(), maxFrames, outputChannels) == maxFrames);
+    for (size_t i = 0; i < maxFrames; i++) {
+      const double firstActuator =
+          secondReference[0][maxFrames + i] + .5 * secondReference[1][maxFrames + i];
+      REQUIRE(out[i * outputChannels] ==
+              Approx(std::clamp(firstActuator, -1.0, 1.0)).margin(1e-6));
+      REQUIRE(out[i * outputChannels + 1] ==
+              Approx(secondReference[2][maxFrames + i]).margin(1e-6));
+    }
+  }
+
+  SECTION("concurrent updates") {
+    std::atomic<bool> rendering = true;
+    std::thread producer([&]() {
+      for (int update = 0; rendering; update++) {
+        renderer.publish(update % 2 == 0 ? second : first);
+      }
+      renderer.publish(second);
+    });
+    for (int block = 0; block < 20; block++) {
+      renderer.render(out.data(), maxFrames, channelCount);
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    rendering = false;
+    producer.join();
+    const uint32_t position = renderer.getSamplePosition();
+    REQUIRE(renderer.render(out.data(), maxFrames, channelCount) == maxFrames);
+    for (size_t i = 0; i < maxFrames; i++) {
+      for (size_t c = 0; c < channelCount; c++) {
+        REQUIRE(out[i * channelCount + c] == secondReference[c][position + i]);
+      }
+    }
+  }
+}
+
+TEST_CASE("Renderer::trigger", "[Renderer]") {
+  const int channelCount = 3;
+  const size_t maxFrames = 64;
+  Haptics haptic = makeHaptics(channelCount, 4);
+  Effect libraryEffect(0, 0, BaseSignal::Sine, EffectType::Basis);
+  libraryEffect.setId(7);
+  libraryEffect.addKeyframe(0, .6, 120);
+  libraryEffect.addKeyframe(40, .2, 180);
+  haptic.getPerceptionAt(0).addBasisEffect(libraryEffect);
+  Renderer renderer(haptic, FS, maxFrames);
+  const std::optional<std::vector<double>> effectSignal =
+      haptic.getPerceptionAt(0).renderLibraryEffect(7, Band(BandType::VectorialWave, 0, FS / 2),
+                                                    FS, 1000);
+  REQUIRE(effectSignal.has_value());
+  std::vector<float> out(maxFrames * channelCount);
+  CHECK_FALSE(renderer.trigger(0, 8, 1, 1));
+
+  SECTION("stopped renderer") {
+    REQUIRE(renderer.trigger(0, 7, 0b10, .5));
+    size_t position = 0;
+    while (position == 0 || renderer.getActiveVoiceCount() > 0) {
+      CHECK(renderer.render(out.data(), maxFrames, channelCount) == 0);
+      for (size_t i = 0; i < maxFrames && position + i < effectSignal->size(); i++) {
+        REQUIRE(out[i * channelCount] == 0);
+        REQUIRE(out[i * channelCount + 1] ==
+                static_cast<float>(effectSignal->at(position + i) * .5));
+        REQUIRE(out[i * channelCount + 2] == 0);
+      }
+      position += maxFrames;
+    }
+    CHECK(position >= effectSignal->size());
+    renderer.render(out.data(), maxFrames, channelCount);
+    CHECK(std::all_of(out.begin(), out.end(), [](float v) { return v == 0; }));
+  }
+
+  SECTION("playing file") {
+    const std::vector<std::vector<float>> reference =
+        referenceSignal(haptic, renderer.getSampleCount());
+    renderer.start();
+    REQUIRE(renderer.render(out.data(), maxFrames, channelCount) == maxFrames);
+    REQUIRE(renderer.trigger(0, 7, 0b1, .25));
+    REQUIRE(renderer.render(out.data(), maxFrames, channelCount) == maxFrames);
+    for (size_t i = 0; i < maxFrames; i++) {
+      const double expected = reference[0][maxFrames + i] + effectSignal->at(i) * .25;
+      REQUIRE(out[i * channelCount] == Approx(std::clamp(expected, -1.0, 1.0)).margin(1e-6));
+      REQUIRE(out[i * channelCount + 1] == reference[1][maxFrames + i]);
+    }
+  }
+}
+
+TEST_CASE("Renderer with lazy wavelet decoding", "[Renderer]") {
+  const int channelCount = 2;
+  const size_t maxFrames = 48;
+  Haptics haptic = makeHaptics(channelCount, 4);
+  Band longBand = makeWaveletBand(40, FS, 128);
+  Band shortBand = makeWaveletBand(25, FS, 128);
+  haptic.getPerceptionAt(0).getChannelAt(0).addBand(longBand);
+  haptic.getPerceptionAt(0).getChannelAt(1).addBand(shortBand);
+  Renderer eager(haptic, FS, maxFrames);
+  std::vector<float> expected(maxFrames * channelCount);
+  std::vector<float> out(maxFrames * channelCount);
+
+  // The cap of 1 byte only keeps the blocks of the current render call
+  for (size_t cap : {SIZE_MAX, size_t{1}}) {
+    Renderer lazy(haptic, FS, maxFrames, haptics::waveletdecoder::DecodingPrecision::Double, cap);
+    REQUIRE(lazy.getSampleCount() == eager.getSampleCount());
+    eager.seek(0);
+    eager.start();
+    lazy.start();
+    while (eager.isPlaying()) {
+      const size_t frames = eager.render(expected.data(), maxFrames, channelCount);
+      REQUIRE(lazy.render(out.data(), maxFrames, channelCount) == frames);
+      REQUIRE(out == expected);
+      if (lazy.getSamplePosition() == maxFrames * 20) {
+        eager.seek(10);
+        lazy.seek(10);
+      }
+    }
+  }
+}
+
+TEST_CASE("Renderer in single precision", "[Renderer]") {
+  const int channelCount = 2;
+  const size_t maxFrames = 64;
+  Haptics haptic = makeHaptics(channelCount, 6);
+  Band band = makeWaveletBand(30, FS, 128);
+  haptic.getPerceptionAt(0).getChannelAt(0).addBand(band);
+  Renderer doubleRenderer(haptic, FS, maxFrames);
+  Renderer singleRenderer(haptic, FS, maxFrames,
+                          haptics::waveletdecoder::DecodingPrecision::Single);
+  std::vector<float> expected(maxFrames * channelCount);
+  std::vector<float> out(maxFrames * channelCount);
+
+  // Only the rounding of the samples differs, the phases being computed in double precision
+  doubleRenderer.start();
+  singleRenderer.start();
+  while (doubleRenderer.isPlaying()) {
+    const size_t frames = doubleRenderer.render(expected.data(), maxFrames, channelCount);
+    REQUIRE(singleRenderer.render(out.data(), maxFrames, channelCount) == frames);
+    for (size_t i = 0; i < frames * channelCount; i++) {
+      REQUIRE(out[i] == Approx(expected[i]).margin(1e-5));
+    }
+  }
+  CHECK_FALSE(singleRenderer.isPlaying());
+}
+
+// Run with the [benchmark] tag. Callbacks must be rendered well within their duration: the check
+// is done on the 99th percentile, the worst case depending mostly on the scheduling of the system.
+TEST_CASE("Renderer latency budget", "[.][benchmark]") {
+  const int channelCount = 32;
+  const size_t frames = 64;
+  const double callbackDuration = static_cast<double>(frames) / FS;
+  const double budget = .5 * callbackDuration;
+
+  Renderer renderer(makeHaptics(channelCount, 400), FS, frames);
+  std::vector<float> out(frames * channelCount);
+  std::vector<double> durations;
+  durations.reserve(renderer.getSampleCount() / frames + 1);
+  renderer.start();
+  while (renderer.isPlaying()) {
+    const auto begin = std::chrono::steady_clock::now();
+    renderer.render(out.data(), frames, channelCount);
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+    durations.push_back(duration.count());
+  }
+  std::sort(durations.begin(), durations.end());
+  const double percentile = durations[durations.size() * 99 / 100];
+  double totalDuration = 0;
+  for (double duration : durations) {
+    totalDuration += duration;
+  }
+  WARN("callbacks: " << durations.size() << ", mean: " << 1e6 * totalDuration / durations.size()
+                     << " us, 99th percentile: " << 1e6 * percentile
+                     << " us, worst: " << 1e6 * durations.back() << " us, budget: " << 1e6 * budget
+                     << " us");
+  CHECK(percentile < budget);
+}
@@ -0,0 +1,206 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Synthesizer/include/VoicePool.h>
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <chrono>
+
+using haptics::synthesizer::VoicePool;
+using haptics::types::Band;
+using haptics::types::BandType;
+using haptics::types::BaseSignal;
+using haptics::types::Channel;
+using haptics::types::CurveType;
+using haptics::types::Effect;
+using haptics::types::EffectType;
+using haptics::types::Haptics;
+using haptics::types::Perception;
+
+namespace {
+constexpr int FS = 8000;
+constexpr size_t MAX_FRAMES = 64;
+
+// Perception 3 with a vectorial library effect 0 and a curve library effect 1 referenced by a
+// curve band
+auto makeHaptics() -> Haptics {
+  Haptics haptic;
+  haptic.setTimescale(1000);
+  Perception perception(3, 0, "", haptics::types::PerceptionModality::Vibrotactile);
+  perception.setPriority(2);
+  Effect vectorialEffect(0, 0, BaseSignal::Sine, EffectType::Basis);
+  vectorialEffect.setId(0);
+  vectorialEffect.addKeyframe(0, .5, 90);
+  vectorialEffect.addKeyframe(60, .8, 250);
+  vectorialEffect.addKeyframe(110, .2, 150);
+  perception.addBasisEffect(vectorialEffect);
+  Effect curveEffect(0, EffectType::Basis);
+  curveEffect.setId(1);
+  curveEffect.addKeyframe(0, .25, std::nullopt);
+  curveEffect.addKeyframe(40, .75, std::nullopt);
+  curveEffect.addKeyframe(90, 0, std::nullopt);
+  perception.addBasisEffect(curveEffect);
+
+  Channel channel(0, "", 1, 1, 0);
+  Band curve(BandType::Curve, CurveType::Cubic, 0, 72);
+  Effect reference(100, EffectType::Reference);
+  reference.setId(1);
+  curve.addEffect(reference);
+  channel.addBand(curve);
+  perception.addChannel(channel);
+  haptic.addPerception(perception);
+  return haptic;
+}
+
+// Plays the voices of the pool until they end, returning the signal of the given channel
+auto renderChannel(VoicePool &pool, size_t channel) -> std::vector<double> {
+  std::vector<double> res;
+  pool.startTriggeredVoices();
+  while (pool.getActiveVoiceCount() > 0) {
+    pool.renderBlock(MAX_FRAMES);
+    const bool written = ((pool.getChannelMask() >> channel) & 1U) != 0;
+    for (size_t i = 0; i < MAX_FRAMES; i++) {
+      res.push_back(written ? pool.getChannelBlock(channel)[i] : 0);
+    }
+  }
+  return res;
+}
+} // namespace
+
+TEST_CASE("VoicePool::trigger", "[VoicePool]") {
+  Haptics haptic = makeHaptics();
+  Perception &perception = haptic.getPerceptionAt(0);
+  VoicePool pool(haptic, FS, 8, MAX_FRAMES);
+  REQUIRE(pool.getVoiceCount() == 8);
+  CHECK_FALSE(pool.trigger(3, 2, 1, 1));
+  CHECK_FALSE(pool.trigger(0, 0, 1, 1));
+
+  SECTION("vectorial effect") {
+    const std::optional<std::vector<double>> expected = perception.renderLibraryEffect(
+        0, Band(BandType::VectorialWave, 0, FS / 2), FS, haptic.getTimescaleOrDefault());
+    REQUIRE(expected.has_value());
+    REQUIRE(pool.trigger(3, 0, 0b101, .5));
+    pool.startTriggeredVoices();
+    CHECK(pool.getActiveVoiceCount() == 1);
+    pool.renderBlock(MAX_FRAMES);
+    CHECK(pool.getChannelMask() == 0b101);
+    for (size_t i = 0; i < MAX_FRAMES; i++) {
+      CHECK(pool.getChannelBlock(0)[i] == Approx(expected->at(i) * .5));
+      CHECK(pool.getChannelBlock(2)[i] == pool.getChannelBlock(0)[i]);
+    }
+  }
+
+  SECTION("effect rendered in its band") {
+    const std::optional<std::vector<double>> expected =
+        perception.renderLibraryEffect(1, perception.getChannelAt(0).getBandAt(0), FS,
+                                       haptic.getTimescaleOrDefault());
+    REQUIRE(expected.has_value());
+    REQUIRE(pool.trigger(3, 1, 1, 1));
+    REQUIRE(pool.trigger(3, 1, 1, 1));
+    const std::vector<double> res = renderChannel(pool, 0);
+    REQUIRE(res.size() >= expected->size());
+    for (size_t i = 0; i < expected->size(); i++) {
+      REQUIRE(res[i] == Approx(2 * expected->at(i)));
+    }
+    pool.renderBlock(MAX_FRAMES);
+    CHECK(pool.getChannelMask() == 0);
+  }
+
+  SECTION("full queue") {
+    size_t accepted = 0;
+    while (pool.trigger(3, 0, 1, 1)) {
+      accepted++;
+    }
+    CHECK(accepted > pool.getVoiceCount());
+    pool.startTriggeredVoices();
+    CHECK(pool.getActiveVoiceCount() == pool.getVoiceCount());
+    CHECK(pool.trigger(3, 0, 1, 1));
+  }
+}
+
+TEST_CASE("VoicePool voice stealing", "[VoicePool]") {
+  Haptics haptic = makeHaptics();
+  VoicePool pool(haptic, FS, 2, MAX_FRAMES);
+  REQUIRE(pool.trigger(3, 0, 0b1, 1));
+  REQUIRE(pool.trigger(3, 0, 0b10, 1));
+  pool.startTriggeredVoices();
+  pool.renderBlock(MAX_FRAMES);
+  REQUIRE(pool.getChannelMask() == 0b11);
+
+  SECTION("oldest voice of lowest priority") {
+    REQUIRE(pool.trigger(3, 0, 0b100, 1));
+    REQUIRE(pool.trigger(3, 0, 0b1000, 1));
+    pool.startTriggeredVoices();
+    pool.renderBlock(MAX_FRAMES);
+    CHECK(pool.getChannelMask() == 0b1100);
+    CHECK(pool.getRejectedCount() == 0);
+  }
+
+  SECTION("higher priorities") {
+    REQUIRE(pool.trigger(3, 0, 0b100, 1, 1));
+    pool.startTriggeredVoices();
+    pool.renderBlock(MAX_FRAMES);
+    CHECK(pool.getChannelMask() == 0b11);
+    CHECK(pool.getRejectedCount() == 1);
+  }
+}
+
+// Run with the [benchmark] tag. Hundreds of voices must be mixed well within a millisecond, the
+// pool being kept full by new triggers for every block.
+TEST_CASE("VoicePool latency budget", "[.][benchmark]") {
+  const size_t voiceCount = 512;
+  const size_t channelCount = 16;
+  const int blockCount = 500;
+  const double budget = 1e-3;
+
+  Haptics haptic = makeHaptics();
+  VoicePool pool(haptic, FS, voiceCount, MAX_FRAMES);
+  std::vector<double> durations;
+  durations.reserve(blockCount);
+  for (int block = 0; block < blockCount; block++) {
+    for (size_t v = pool.getActiveVoiceCount(); v < voiceCount; v++) {
+      pool.trigger(3, static_cast<int>(v % 2), 1ULL << (v % channelCount), .01);
+    }
+    const auto begin = std::chrono::steady_clock::now();
+    pool.startTriggeredVoices();
+    pool.renderBlock(MAX_FRAMES);
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+    durations.push_back(duration.count());
+  }
+  std::sort(durations.begin(), durations.end());
+  const double percentile = durations[durations.size() * 99 / 100];
+  WARN("voices: " << voiceCount << ", 99th percentile: " << 1e6 * percentile
+                  << " us, worst: " << 1e6 * durations.back() << " us, budget: " << 1e6 * budget
+                  << " us");
+  CHECK(percentile < budget);
+}
@@ -0,0 +1,62 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef WAVELETBANDFIXTURE_H
+#define WAVELETBANDFIXTURE_H
+
+#include <Spiht/include/Spiht_Enc.h>
+#include <Types/include/Band.h>
+#include <vector>
+
+namespace haptics::testsupport {
+
+// Wavelet band of blockCount blocks of blockSampleCount samples at fs, whose coefficients are
+// encoded with SPIHT. Positions are in milliseconds.
+inline auto makeWaveletBand(int blockCount, int fs, int blockSampleCount) -> types::Band {
+  types::Band band(types::BandType::WaveletWave, blockSampleCount * 1000 / fs, 0, fs);
+  spiht::Spiht_Enc encoder;
+  for (int b = 0; b < blockCount; b++) {
+    std::vector<int> block_intquant(blockSampleCount, 0);
+    for (int i = 0; i < blockSampleCount; i++) {
+      block_intquant[i] = (((i + 1) * (b + 3) * 29) % 53 - 26) * blockSampleCount /
+                          (4 * (i + blockSampleCount / 4));
+    }
+    types::Effect effect;
+    effect.setPosition(b * band.getBlockLength().value());
+    encoder.encodeEffect(block_intquant, 5, 1, effect.getWaveletBitstream());
+    band.addEffect(effect);
+  }
+  return band;
+}
+} // namespace haptics::testsupport
+#endif // WAVELETBANDFIXTURE_H
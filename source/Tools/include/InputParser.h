@@ -36,6 +36,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <optional>
 #include <vector>
 
 namespace haptics::tools {
@@ -45,6 +46,9 @@ public:
   InputParser(const std::vector<const char *> &args);
   [[nodiscard]] auto getCmdOption(const std::string &option) const -> const std::string &;
   [[nodiscard]] auto cmdOptionExists(const std::string &option) const -> bool;
+  // Number of threads given with the option, 0 standing for every hardware thread. Returns 1 when
+  // the option is absent, and std::nullopt when its value is negative.
+  [[nodiscard]] auto getThreadCount(const std::string &option) const -> std::optional<size_t>;
   auto static getFileExt(std::string &filename) -> std::string;
 
 private:
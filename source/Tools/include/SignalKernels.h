@@ -0,0 +1,114 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SIGNALKERNELS_H
+#define SIGNALKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace haptics::tools {
+
+enum class Waveform { Sine, Square, Triangle, SawToothUp, SawToothDown };
+
+// Instruction sets used by the kernels, the best one supported by the CPU being selected at
+// runtime
+enum class SimdLevel { Scalar = 0, SSE41 = 1, AVX2 = 2 };
+
+// Maximum absolute error of the polynomial sine approximation used by every kernel
+constexpr double SINE_APPROXIMATION_ERROR = 1e-10;
+
+// Fills out[i] with the periodic signal of frequency frequency[i] and phase phase (in radians)
+// evaluated at time[i] (in seconds), for i in [0, count). Except for the sine approximation,
+// results are identical to a scalar evaluation of the waveform.
+auto computeWaveform(Waveform waveform, const double *time, const double *frequency, double phase,
+                     double *out, size_t count) -> void;
+
+// Adds gain * in[i] to out[i], for i in [0, count). Results are identical whatever the instruction
+// set.
+auto multiplyAccumulate(const double *in, double gain, double *out, size_t count) -> void;
+
+// Adds in[i] to out[i] and clamps the sum to [-1, 1], for i in [0, count), as Channel::mixBand
+// does. Results are identical whatever the instruction set.
+auto addClamped(const double *in, double *out, size_t count) -> void;
+auto addClamped(const float *in, float *out, size_t count) -> void;
+
+// Mixes the inCount signals in[0] to in[inCount - 1] in this order, clamping the sum to [-1, 1]
+// after each signal as addClamped does, and writes the mix scaled by gain to out[i], for i in
+// [0, count). Results are identical whatever the instruction set.
+auto mixClamped(const double *const *in, size_t inCount, double gain, double *out, size_t count)
+    -> void;
+// Same as mixClamped, the scaled mix being quantized to 16 bits PCM as WavParser::quantize does
+// and written to out[i * stride], so that the channels of interleaved frames can be written in
+// place.
+auto mixClampedQuantized(const double *const *in, size_t inCount, double gain, int16_t *out,
+                         size_t stride, size_t count) -> void;
+// Single precision version of mixClampedQuantized, the signals being mixed in single precision and
+// the mix being scaled and quantized in double precision
+auto mixClampedQuantized(const float *const *in, size_t inCount, double gain, int16_t *out,
+                         size_t stride, size_t count) -> void;
+
+// Maximum relative error of decibelsToPower against std::pow(10, in / 10), for levels in
+// [-1000, 1000] dB. The error mostly comes from the rounding of the exponent, and is about 1e-14
+// at 200 dB.
+constexpr double DECIBEL_CONVERSION_ERROR = 1e-13;
+
+// Converts the levels in[i], in dB, to powers 10^(in[i] / 10) written to out[i], for i in
+// [0, count). The power is computed as 2^n.2^f, with n the nearest integer of the exponent in base
+// 2 and a polynomial for 2^f. Powers below 2^-1022 are flushed to zero, those above 2^1023 are
+// infinite and NaN values are kept. Results are identical whatever the instruction set.
+auto decibelsToPower(const double *in, double *out, size_t count) -> void;
+
+// Parabolas (x - center[p])^2 * curvature[p] + offset[p], for p in [0, count)
+struct Parabolas {
+  const double *center = nullptr;
+  const double *curvature = nullptr;
+  const double *offset = nullptr;
+  size_t count = 0;
+};
+
+// Writes to out[i] the upper envelope of the parabolas evaluated at x[i], for i in [0, count),
+// each parabola being evaluated in the order of operations of its formula. A parabola only
+// replaces the envelope when it is strictly above it, so that a NaN of the first parabola is kept.
+// out is left as it is without parabola. Results are identical whatever the instruction set.
+auto computeParabolaEnvelope(const double *x, const Parabolas &parabolas, double *out,
+                             size_t count) -> void;
+
+[[nodiscard]] auto getSupportedSimdLevel() -> SimdLevel;
+[[nodiscard]] auto getSimdLevel() -> SimdLevel;
+// Forces the instruction set used by the kernels, bounded by the one supported by the CPU.
+// Returns the level actually selected.
+auto setSimdLevel(SimdLevel level) -> SimdLevel;
+
+} // namespace haptics::tools
+#endif // SIGNALKERNELS_H
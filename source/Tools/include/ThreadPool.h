@@ -0,0 +1,98 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace haptics::tools {
+
+// Work-stealing thread pool. Each worker owns a task queue: it takes its own tasks from the back
+// and, once empty, steals tasks from the front of the other queues. The thread calling
+// parallelFor also executes tasks until all the tasks it submitted are done.
+class ThreadPool {
+public:
+  // A pool with threadCount threads in total, including the calling thread. With a count of 0 or
+  // 1, no worker is started and every task is executed by the calling thread.
+  explicit ThreadPool(size_t threadCount);
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool(ThreadPool &&) = delete;
+  auto operator=(const ThreadPool &) -> ThreadPool & = delete;
+  auto operator=(ThreadPool &&) -> ThreadPool & = delete;
+  ~ThreadPool();
+
+  [[nodiscard]] auto getThreadCount() const -> size_t;
+  // Calls task(i) for every i in [0, taskCount) and returns once all calls are done. The first
+  // exception thrown by a task is rethrown once the other tasks are finished.
+  auto parallelFor(size_t taskCount, const std::function<void(size_t)> &task) -> void;
+
+private:
+  struct TaskGroup {
+    const std::function<void(size_t)> *body = nullptr;
+    std::atomic<size_t> remaining = 0;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+  };
+  struct Task {
+    TaskGroup *group = nullptr;
+    size_t index = 0;
+  };
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<TaskQueue>> queues;
+  std::vector<std::thread> workers;
+  std::mutex stateMutex;
+  std::condition_variable workAvailable;
+  std::condition_variable groupFinished;
+  std::atomic<size_t> queuedTasks = 0;
+  bool stopping = false;
+
+  auto workerLoop(size_t queueIndex) -> void;
+  auto popTask(size_t queueIndex, Task &task) -> bool;
+  auto runTask(Task &task) -> void;
+};
+} // namespace haptics::tools
+#endif // THREADPOOL_H
@@ -79,6 +79,18 @@ namespace haptics::tools {
 [[nodiscard]] auto bsplineInterpolation(const std::vector<std::pair<int, double>> &points)
     -> std::vector<double>;
 
+// Streaming counterparts of the interpolation functions above. curveCoefficients computes once
+// the coefficients of the curve going through points. curveInterpolationBlock then adds the
+// samples [first, first + count) of the curve to out, without building the whole curve. Positions
+// of the points must be strictly increasing, starting at 0. Curves going through two points are
+// linear, whatever the curve type.
+auto curveCoefficients(const std::vector<std::pair<int, double>> &points,
+                       types::CurveType curveType, std::vector<double> &coefficients) -> void;
+
+auto curveInterpolationBlock(const std::vector<std::pair<int, double>> &points,
+                             types::CurveType curveType, const std::vector<double> &coefficients,
+                             int first, double *out, size_t count) -> void;
+
 [[nodiscard]] auto interpolationCodec(const std::vector<std::pair<int, double>> &points,
                                       types::CurveType curveType) -> std::vector<double>;
 
@@ -51,6 +51,8 @@ public:
       -> bool;
   static auto saveFile(const std::string &filename, const std::vector<std::vector<double>> &buff,
                        int sampleRate) -> bool;
+  // Converts a sample in [-1, 1] to the 16 bits PCM value written in the output files
+  [[nodiscard]] static auto quantize(double value) -> uint16_t;
   [[nodiscard]] auto getSamplerate() const -> uint32_t;
   [[nodiscard]] auto getNumChannels() const -> size_t;
   [[nodiscard]] auto getNumSamples() const -> size_t;
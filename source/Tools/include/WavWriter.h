@@ -0,0 +1,71 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef WAVWRITER_H
+#define WAVWRITER_H
+
+#include <cstdint>
+#include <dr_wav.h>
+#include <string>
+#include <vector>
+
+namespace haptics::tools {
+
+// Writes a 16 bits PCM WAV file incrementally, so that a signal does not need to be held in
+// memory as a whole to be saved. The samples are quantized as in WavParser::saveFile.
+class WavWriter {
+public:
+  explicit WavWriter() = default;
+  WavWriter(const WavWriter &) = delete;
+  WavWriter(WavWriter &&) = delete;
+  auto operator=(const WavWriter &) -> WavWriter & = delete;
+  auto operator=(WavWriter &&) -> WavWriter & = delete;
+  ~WavWriter();
+
+  auto open(const std::string &filename, size_t channelCount, int sampleRate) -> bool;
+  // Appends the first frameCount samples of every channel of buff to the file
+  auto writeFrames(const std::vector<std::vector<double>> &buff, size_t frameCount) -> bool;
+  // Appends frameCount frames of samples already quantized and interleaved
+  auto writeFrames(const int16_t *frames, size_t frameCount) -> bool;
+  // Finalizes the file header. Called by the destructor if needed.
+  auto close() -> bool;
+  [[nodiscard]] auto isOpen() const -> bool;
+
+private:
+  drwav wav{};
+  bool opened = false;
+  size_t channelCount = 0;
+  std::vector<uint16_t> interleaved;
+};
+} // namespace haptics::tools
+#endif // WAVWRITER_H
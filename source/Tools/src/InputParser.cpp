@@ -32,6 +32,7 @@
  */
 
 #include <Tools/include/InputParser.h>
+#include <thread>
 
 namespace haptics::tools {
 
@@ -56,6 +57,22 @@ InputParser::InputParser(const std::vector<const char *> &args) {
   return std::find(this->tokens.begin(), this->tokens.end(), option) != this->tokens.end();
 }
 
+[[nodiscard]] auto InputParser::getThreadCount(const std::string &option) const
+    -> std::optional<size_t> {
+  const std::string &threadsStr = getCmdOption(option);
+  if (threadsStr.empty()) {
+    return 1;
+  }
+  const int threads = std::stoi(threadsStr);
+  if (threads < 0) {
+    return std::nullopt;
+  }
+  if (threads == 0) {
+    return std::max(std::thread::hardware_concurrency(), 1U);
+  }
+  return static_cast<size_t>(threads);
+}
+
 auto InputParser::getFileExt(std::string &filename) -> std::string {
   size_t i = filename.rfind('.', filename.length());
   if (i != std::string::npos) {
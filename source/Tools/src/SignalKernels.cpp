@@ -0,0 +1,913 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Tools/include/SignalKernels.h>
+#include <Tools/include/WavParser.h>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define HAPTICS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace haptics::tools {
+
+namespace {
+
+constexpr double HALF = .5;
+constexpr double QUARTER = .25;
+constexpr double TWO_PI = 2 * M_PI;
+// Taylor series of the sine up to the 15th degree, its error on [-pi/2, pi/2] is below 1e-11
+constexpr double SIN_C3 = -1.0 / 6;
+constexpr double SIN_C5 = 1.0 / 120;
+constexpr double SIN_C7 = -1.0 / 5040;
+constexpr double SIN_C9 = 1.0 / 362880;
+constexpr double SIN_C11 = -1.0 / 39916800;
+constexpr double SIN_C13 = 1.0 / 6227020800;
+constexpr double SIN_C15 = -1.0 / 1307674368000;
+// log2(10) / 10, converting a level in dB to an exponent in base 2
+constexpr double DECIBEL_TO_EXP2 = 0.332192809488736235;
+// Range of the exponents in base 2 giving normal powers
+constexpr double EXP2_MIN = -1022;
+constexpr double EXP2_MAX = 1023;
+// Taylor series of 2^f = exp(f.ln2) up to the 12th degree, its relative error on [-1/2, 1/2] is
+// below 2e-16
+constexpr double EXP2_C1 = 6.93147180559945286e-01;
+constexpr double EXP2_C2 = 2.40226506959100722e-01;
+constexpr double EXP2_C3 = 5.55041086648215831e-02;
+constexpr double EXP2_C4 = 9.61812910762847688e-03;
+constexpr double EXP2_C5 = 1.33335581464284433e-03;
+constexpr double EXP2_C6 = 1.54035303933816088e-04;
+constexpr double EXP2_C7 = 1.52527338040598411e-05;
+constexpr double EXP2_C8 = 1.32154867901443095e-06;
+constexpr double EXP2_C9 = 1.01780860092396999e-07;
+constexpr double EXP2_C10 = 7.05491162080112336e-09;
+constexpr double EXP2_C11 = 4.44553827187081162e-10;
+constexpr double EXP2_C12 = 2.56784359934882055e-11;
+// Adding 1.5 * 2^52 to an integer below 2^51 in magnitude leaves it in the low bits of the
+// mantissa, from which the exponent bits of 2^n are built
+constexpr double ROUNDING_MAGIC = 6755399441055744.0;
+constexpr int64_t EXPONENT_BIAS = 1023 - 0x4338000000000000LL;
+constexpr int MANTISSA_BITS = 52;
+
+// Number of periods elapsed at the given time, as computed by Effect::computeBaseSignal
+inline auto periods(double time, double frequency, double phase) -> double {
+  if (frequency != 0) {
+    time += phase / (TWO_PI * frequency);
+  }
+  return time * frequency;
+}
+
+inline auto sinePolynomial(double x) -> double {
+  const double x2 = x * x;
+  return x * (1 +
+              x2 * (SIN_C3 +
+                    x2 * (SIN_C5 +
+                          x2 * (SIN_C7 +
+                                x2 * (SIN_C9 + x2 * (SIN_C11 + x2 * (SIN_C13 + x2 * SIN_C15)))))));
+}
+
+inline auto scalarWaveform(Waveform waveform, double x) -> double {
+  switch (waveform) {
+  case Waveform::Sine: {
+    // Reduction to a quarter of period: sin(2 pi r) with r in [-1/4, 1/4]
+    double r = x - std::floor(x + HALF);
+    if (r > QUARTER) {
+      r = HALF - r;
+    } else if (r < -QUARTER) {
+      r = -HALF - r;
+    }
+    return sinePolynomial(TWO_PI * r);
+  }
+  case Waveform::Square:
+    return x - std::floor(x) >= HALF ? -1 : 1;
+  case Waveform::Triangle: {
+    const double y = x - QUARTER;
+    return 1 - 4 * std::abs(std::floor(y + HALF) - y);
+  }
+  case Waveform::SawToothUp:
+    return 2 * (x - std::floor(x + HALF));
+  case Waveform::SawToothDown:
+    return 2 * (std::floor(x + HALF) - x);
+  default:
+    return 1;
+  }
+}
+
+auto computeWaveformScalar(Waveform waveform, const double *time, const double *frequency,
+                           double phase, double *out, size_t count) -> void {
+  for (size_t i = 0; i < count; i++) {
+    out[i] = scalarWaveform(waveform, periods(time[i], frequency[i], phase));
+  }
+}
+
+auto multiplyAccumulateScalar(const double *in, double gain, double *out, size_t count) -> void {
+  for (size_t i = 0; i < count; i++) {
+    out[i] += gain * in[i];
+  }
+}
+
+// Same comparisons as Channel::mixBand, a NaN being left as it is
+template <typename T> inline auto clampUnit(T value) -> T {
+  if (value < -1) {
+    return -1;
+  }
+  if (value > 1) {
+    return 1;
+  }
+  return value;
+}
+
+inline auto quantizeSample(double value) -> int16_t {
+  return static_cast<int16_t>(WavParser::quantize(value));
+}
+
+template <typename T> inline auto mixSample(const T *const *in, size_t inCount, size_t i) -> T {
+  T mix = 0;
+  for (size_t s = 0; s < inCount; s++) {
+    mix = clampUnit(mix + in[s][i]);
+  }
+  return mix;
+}
+
+template <typename T> auto addClampedScalar(const T *in, T *out, size_t count) -> void {
+  for (size_t i = 0; i < count; i++) {
+    out[i] = clampUnit(out[i] + in[i]);
+  }
+}
+
+auto mixClampedScalar(const double *const *in, size_t inCount, double gain, double *out,
+                      size_t count) -> void {
+  for (size_t i = 0; i < count; i++) {
+    out[i] = mixSample(in, inCount, i) * gain;
+  }
+}
+
+// Single precision mixes are widened to double precision before being scaled
+template <typename T>
+auto mixClampedQuantizedScalar(const T *const *in, size_t inCount, double gain, int16_t *out,
+                               size_t stride, size_t count) -> void {
+  for (size_t i = 0; i < count; i++) {
+    out[i * stride] = quantizeSample(static_cast<double>(mixSample(in, inCount, i)) * gain);
+  }
+}
+
+inline auto exp2Polynomial(double f) -> double {
+  double p = EXP2_C11 + f * EXP2_C12;
+  p = EXP2_C10 + f * p;
+  p = EXP2_C9 + f * p;
+  p = EXP2_C8 + f * p;
+  p = EXP2_C7 + f * p;
+  p = EXP2_C6 + f * p;
+  p = EXP2_C5 + f * p;
+  p = EXP2_C4 + f * p;
+  p = EXP2_C3 + f * p;
+  p = EXP2_C2 + f * p;
+  p = EXP2_C1 + f * p;
+  return 1 + f * p;
+}
+
+inline auto decibelToPower(double level) -> double {
+  const double t = level * DECIBEL_TO_EXP2;
+  if (std::isnan(t)) {
+    return t;
+  }
+  if (t < EXP2_MIN) {
+    return 0;
+  }
+  if (t > EXP2_MAX) {
+    return std::numeric_limits<double>::infinity();
+  }
+  const double n = std::nearbyint(t);
+  return exp2Polynomial(t - n) * std::ldexp(1.0, static_cast<int>(n));
+}
+
+auto decibelsToPowerScalar(const double *in, double *out, size_t count) -> void {
+  for (size_t i = 0; i < count; i++) {
+    out[i] = decibelToPower(in[i]);
+  }
+}
+
+inline auto parabola(double x, const Parabolas &parabolas, size_t p) -> double {
+  const double distance = x - parabolas.center[p];
+  return distance * distance * parabolas.curvature[p] + parabolas.offset[p];
+}
+
+auto computeParabolaEnvelopeScalar(const double *x, const Parabolas &parabolas, double *out,
+                                   size_t count) -> void {
+  for (size_t i = 0; i < count; i++) {
+    double envelope = parabola(x[i], parabolas, 0);
+    for (size_t p = 1; p < parabolas.count; p++) {
+      const double value = parabola(x[i], parabolas, p);
+      if (value > envelope) {
+        envelope = value;
+      }
+    }
+    out[i] = envelope;
+  }
+}
+
+#ifdef HAPTICS_X86_KERNELS
+
+__attribute__((target("sse4.1"))) auto waveformSSE41(Waveform waveform, __m128d x) -> __m128d {
+  const __m128d half = _mm_set1_pd(HALF);
+  const __m128d quarter = _mm_set1_pd(QUARTER);
+  const __m128d one = _mm_set1_pd(1);
+  const __m128d two = _mm_set1_pd(2);
+  switch (waveform) {
+  case Waveform::Sine: {
+    __m128d r = _mm_sub_pd(x, _mm_floor_pd(_mm_add_pd(x, half)));
+    r = _mm_blendv_pd(r, _mm_sub_pd(half, r), _mm_cmpgt_pd(r, quarter));
+    r = _mm_blendv_pd(r, _mm_sub_pd(_mm_set1_pd(-HALF), r),
+                      _mm_cmplt_pd(r, _mm_set1_pd(-QUARTER)));
+    const __m128d a = _mm_mul_pd(_mm_set1_pd(TWO_PI), r);
+    const __m128d a2 = _mm_mul_pd(a, a);
+    __m128d p = _mm_add_pd(_mm_set1_pd(SIN_C13), _mm_mul_pd(a2, _mm_set1_pd(SIN_C15)));
+    p = _mm_add_pd(_mm_set1_pd(SIN_C11), _mm_mul_pd(a2, p));
+    p = _mm_add_pd(_mm_set1_pd(SIN_C9), _mm_mul_pd(a2, p));
+    p = _mm_add_pd(_mm_set1_pd(SIN_C7), _mm_mul_pd(a2, p));
+    p = _mm_add_pd(_mm_set1_pd(SIN_C5), _mm_mul_pd(a2, p));
+    p = _mm_add_pd(_mm_set1_pd(SIN_C3), _mm_mul_pd(a2, p));
+    p = _mm_add_pd(one, _mm_mul_pd(a2, p));
+    return _mm_mul_pd(a, p);
+  }
+  case Waveform::Square: {
+    const __m128d fraction = _mm_sub_pd(x, _mm_floor_pd(x));
+    return _mm_blendv_pd(one, _mm_set1_pd(-1), _mm_cmpge_pd(fraction, half));
+  }
+  case Waveform::Triangle: {
+    const __m128d y = _mm_sub_pd(x, quarter);
+    const __m128d distance = _mm_sub_pd(_mm_floor_pd(_mm_add_pd(y, half)), y);
+    const __m128d absDistance = _mm_andnot_pd(_mm_set1_pd(-0.0), distance);
+    return _mm_sub_pd(one, _mm_mul_pd(_mm_set1_pd(4), absDistance));
+  }
+  case Waveform::SawToothUp:
+    return _mm_mul_pd(two, _mm_sub_pd(x, _mm_floor_pd(_mm_add_pd(x, half))));
+  case Waveform::SawToothDown:
+    return _mm_mul_pd(two, _mm_sub_pd(_mm_floor_pd(_mm_add_pd(x, half)), x));
+  default:
+    return one;
+  }
+}
+
+__attribute__((target("sse4.1"))) auto computeWaveformSSE41(Waveform waveform, const double *time,
+                                                            const double *frequency, double phase,
+                                                            double *out, size_t count) -> void {
+  const __m128d phaseVector = _mm_set1_pd(phase);
+  const __m128d twoPi = _mm_set1_pd(TWO_PI);
+  const __m128d zero = _mm_setzero_pd();
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128d t = _mm_loadu_pd(time + i);
+    const __m128d f = _mm_loadu_pd(frequency + i);
+    // The phase shift is masked out for null frequencies
+    const __m128d shift = _mm_div_pd(phaseVector, _mm_mul_pd(twoPi, f));
+    t = _mm_add_pd(t, _mm_and_pd(_mm_cmpneq_pd(f, zero), shift));
+    _mm_storeu_pd(out + i, waveformSSE41(waveform, _mm_mul_pd(t, f)));
+  }
+  computeWaveformScalar(waveform, time + i, frequency + i, phase, out + i, count - i);
+}
+
+__attribute__((target("avx2"))) auto waveformAVX2(Waveform waveform, __m256d x) -> __m256d {
+  const __m256d half = _mm256_set1_pd(HALF);
+  const __m256d quarter = _mm256_set1_pd(QUARTER);
+  const __m256d one = _mm256_set1_pd(1);
+  const __m256d two = _mm256_set1_pd(2);
+  switch (waveform) {
+  case Waveform::Sine: {
+    __m256d r = _mm256_sub_pd(x, _mm256_floor_pd(_mm256_add_pd(x, half)));
+    r = _mm256_blendv_pd(r, _mm256_sub_pd(half, r), _mm256_cmp_pd(r, quarter, _CMP_GT_OQ));
+    r = _mm256_blendv_pd(r, _mm256_sub_pd(_mm256_set1_pd(-HALF), r),
+                         _mm256_cmp_pd(r, _mm256_set1_pd(-QUARTER), _CMP_LT_OQ));
+    const __m256d a = _mm256_mul_pd(_mm256_set1_pd(TWO_PI), r);
+    const __m256d a2 = _mm256_mul_pd(a, a);
+    __m256d p = _mm256_add_pd(_mm256_set1_pd(SIN_C13), _mm256_mul_pd(a2, _mm256_set1_pd(SIN_C15)));
+    p = _mm256_add_pd(_mm256_set1_pd(SIN_C11), _mm256_mul_pd(a2, p));
+    p = _mm256_add_pd(_mm256_set1_pd(SIN_C9), _mm256_mul_pd(a2, p));
+    p = _mm256_add_pd(_mm256_set1_pd(SIN_C7), _mm256_mul_pd(a2, p));
+    p = _mm256_add_pd(_mm256_set1_pd(SIN_C5), _mm256_mul_pd(a2, p));
+    p = _mm256_add_pd(_mm256_set1_pd(SIN_C3), _mm256_mul_pd(a2, p));
+    p = _mm256_add_pd(one, _mm256_mul_pd(a2, p));
+    return _mm256_mul_pd(a, p);
+  }
+  case Waveform::Square: {
+    const __m256d fraction = _mm256_sub_pd(x, _mm256_floor_pd(x));
+    return _mm256_blendv_pd(one, _mm256_set1_pd(-1), _mm256_cmp_pd(fraction, half, _CMP_GE_OQ));
+  }
+  case Waveform::Triangle: {
+    const __m256d y = _mm256_sub_pd(x, quarter);
+    const __m256d distance = _mm256_sub_pd(_mm256_floor_pd(_mm256_add_pd(y, half)), y);
+    const __m256d absDistance = _mm256_andnot_pd(_mm256_set1_pd(-0.0), distance);
+    return _mm256_sub_pd(one, _mm256_mul_pd(_mm256_set1_pd(4), absDistance));
+  }
+  case Waveform::SawToothUp:
+    return _mm256_mul_pd(two, _mm256_sub_pd(x, _mm256_floor_pd(_mm256_add_pd(x, half))));
+  case Waveform::SawToothDown:
+    return _mm256_mul_pd(two, _mm256_sub_pd(_mm256_floor_pd(_mm256_add_pd(x, half)), x));
+  default:
+    return one;
+  }
+}
+
+__attribute__((target("avx2"))) auto computeWaveformAVX2(Waveform waveform, const double *time,
+                                                         const double *frequency, double phase,
+                                                         double *out, size_t count) -> void {
+  const __m256d phaseVector = _mm256_set1_pd(phase);
+  const __m256d twoPi = _mm256_set1_pd(TWO_PI);
+  const __m256d zero = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256d t = _mm256_loadu_pd(time + i);
+    const __m256d f = _mm256_loadu_pd(frequency + i);
+    // The phase shift is masked out for null frequencies
+    const __m256d shift = _mm256_div_pd(phaseVector, _mm256_mul_pd(twoPi, f));
+    t = _mm256_add_pd(t, _mm256_and_pd(_mm256_cmp_pd(f, zero, _CMP_NEQ_UQ), shift));
+    _mm256_storeu_pd(out + i, waveformAVX2(waveform, _mm256_mul_pd(t, f)));
+  }
+  computeWaveformScalar(waveform, time + i, frequency + i, phase, out + i, count - i);
+}
+
+// Multiplications and additions are not fused, so that the results match the scalar version
+__attribute__((target("sse4.1"))) auto multiplyAccumulateSSE41(const double *in, double gain,
+                                                               double *out, size_t count) -> void {
+  const __m128d gainVector = _mm_set1_pd(gain);
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    const __m128d product = _mm_mul_pd(gainVector, _mm_loadu_pd(in + i));
+    _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(out + i), product));
+  }
+  multiplyAccumulateScalar(in + i, gain, out + i, count - i);
+}
+
+__attribute__((target("avx2"))) auto multiplyAccumulateAVX2(const double *in, double gain,
+                                                            double *out, size_t count) -> void {
+  const __m256d gainVector = _mm256_set1_pd(gain);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m256d product = _mm256_mul_pd(gainVector, _mm256_loadu_pd(in + i));
+    _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(out + i), product));
+  }
+  multiplyAccumulateScalar(in + i, gain, out + i, count - i);
+}
+
+// The clamps rely on minpd and maxpd returning their second operand when one of them is a NaN, so
+// that they behave as clampUnit
+__attribute__((target("sse4.1"))) inline auto clampUnitSSE41(__m128d value) -> __m128d {
+  return _mm_max_pd(_mm_set1_pd(-1), _mm_min_pd(_mm_set1_pd(1), value));
+}
+
+__attribute__((target("sse4.1"))) inline auto mixSSE41(const double *const *in, size_t inCount,
+                                                       size_t i) -> __m128d {
+  __m128d mix = _mm_setzero_pd();
+  for (size_t s = 0; s < inCount; s++) {
+    mix = clampUnitSSE41(_mm_add_pd(mix, _mm_loadu_pd(in[s] + i)));
+  }
+  return mix;
+}
+
+// Rounds half away from zero as std::round does, and saturates as WavParser::quantize does
+__attribute__((target("sse4.1"))) inline auto quantizeSSE41(__m128d value) -> __m128i {
+  const __m128d signMask = _mm_set1_pd(-0.0);
+  const __m128d scaled = _mm_mul_pd(value, _mm_set1_pd(SCALING));
+  const __m128d truncated = _mm_round_pd(scaled, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  const __m128d fraction = _mm_andnot_pd(signMask, _mm_sub_pd(scaled, truncated));
+  const __m128d away = _mm_cmpge_pd(fraction, _mm_set1_pd(HALF));
+  const __m128d step = _mm_or_pd(_mm_and_pd(scaled, signMask), _mm_set1_pd(1));
+  const __m128d rounded = _mm_add_pd(truncated, _mm_and_pd(away, step));
+  return _mm_cvttpd_epi32(
+      _mm_max_pd(_mm_set1_pd(-SCALING), _mm_min_pd(_mm_set1_pd(SCALING - 1), rounded)));
+}
+
+__attribute__((target("sse4.1"))) auto addClampedSSE41(const double *in, double *out,
+                                                       size_t count) -> void {
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    const __m128d sum = _mm_add_pd(_mm_loadu_pd(out + i), _mm_loadu_pd(in + i));
+    _mm_storeu_pd(out + i, clampUnitSSE41(sum));
+  }
+  addClampedScalar(in + i, out + i, count - i);
+}
+
+__attribute__((target("sse4.1"))) inline auto clampUnitSSE41(__m128 value) -> __m128 {
+  return _mm_max_ps(_mm_set1_ps(-1), _mm_min_ps(_mm_set1_ps(1), value));
+}
+
+__attribute__((target("sse4.1"))) inline auto mixSSE41(const float *const *in, size_t inCount,
+                                                       size_t i) -> __m128 {
+  __m128 mix = _mm_setzero_ps();
+  for (size_t s = 0; s < inCount; s++) {
+    mix = clampUnitSSE41(_mm_add_ps(mix, _mm_loadu_ps(in[s] + i)));
+  }
+  return mix;
+}
+
+__attribute__((target("sse4.1"))) auto addClampedSSE41(const float *in, float *out, size_t count)
+    -> void {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128 sum = _mm_add_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(in + i));
+    _mm_storeu_ps(out + i, clampUnitSSE41(sum));
+  }
+  addClampedScalar(in + i, out + i, count - i);
+}
+
+__attribute__((target("sse4.1"))) auto mixClampedSSE41(const double *const *in, size_t inCount,
+                                                       double gain, double *out, size_t count)
+    -> void {
+  const __m128d gainVector = _mm_set1_pd(gain);
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    _mm_storeu_pd(out + i, _mm_mul_pd(mixSSE41(in, inCount, i), gainVector));
+  }
+  for (; i < count; i++) {
+    out[i] = mixSample(in, inCount, i) * gain;
+  }
+}
+
+__attribute__((target("sse4.1"))) auto mixClampedQuantizedSSE41(const double *const *in,
+                                                                size_t inCount, double gain,
+                                                                int16_t *out, size_t stride,
+                                                                size_t count) -> void {
+  const __m128d gainVector = _mm_set1_pd(gain);
+  std::array<int32_t, 4> samples{};
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    const __m128i quantized = quantizeSSE41(_mm_mul_pd(mixSSE41(in, inCount, i), gainVector));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(samples.data()), quantized);
+    out[i * stride] = static_cast<int16_t>(samples[0]);
+    out[(i + 1) * stride] = static_cast<int16_t>(samples[1]);
+  }
+  for (; i < count; i++) {
+    out[i * stride] = quantizeSample(mixSample(in, inCount, i) * gain);
+  }
+}
+
+__attribute__((target("sse4.1"))) auto mixClampedQuantizedSSE41(const float *const *in,
+                                                                size_t inCount, double gain,
+                                                                int16_t *out, size_t stride,
+                                                                size_t count) -> void {
+  const __m128d gainVector = _mm_set1_pd(gain);
+  std::array<int32_t, 4> samples{};
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128 mix = mixSSE41(in, inCount, i);
+    const __m128d low = _mm_cvtps_pd(mix);
+    const __m128d high = _mm_cvtps_pd(_mm_movehl_ps(mix, mix));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(samples.data()),
+                     quantizeSSE41(_mm_mul_pd(low, gainVector)));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(samples.data() + 2),
+                     quantizeSSE41(_mm_mul_pd(high, gainVector)));
+    for (size_t k = 0; k < samples.size(); k++) {
+      out[(i + k) * stride] = static_cast<int16_t>(samples[k]);
+    }
+  }
+  for (; i < count; i++) {
+    out[i * stride] = quantizeSample(static_cast<double>(mixSample(in, inCount, i)) * gain);
+  }
+}
+
+__attribute__((target("avx2"))) inline auto clampUnitAVX2(__m256d value) -> __m256d {
+  return _mm256_max_pd(_mm256_set1_pd(-1), _mm256_min_pd(_mm256_set1_pd(1), value));
+}
+
+__attribute__((target("avx2"))) inline auto mixAVX2(const double *const *in, size_t inCount,
+                                                    size_t i) -> __m256d {
+  __m256d mix = _mm256_setzero_pd();
+  for (size_t s = 0; s < inCount; s++) {
+    mix = clampUnitAVX2(_mm256_add_pd(mix, _mm256_loadu_pd(in[s] + i)));
+  }
+  return mix;
+}
+
+__attribute__((target("avx2"))) inline auto quantizeAVX2(__m256d value) -> __m128i {
+  const __m256d signMask = _mm256_set1_pd(-0.0);
+  const __m256d scaled = _mm256_mul_pd(value, _mm256_set1_pd(SCALING));
+  const __m256d truncated = _mm256_round_pd(scaled, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  const __m256d fraction = _mm256_andnot_pd(signMask, _mm256_sub_pd(scaled, truncated));
+  const __m256d away = _mm256_cmp_pd(fraction, _mm256_set1_pd(HALF), _CMP_GE_OQ);
+  const __m256d step = _mm256_or_pd(_mm256_and_pd(scaled, signMask), _mm256_set1_pd(1));
+  const __m256d rounded = _mm256_add_pd(truncated, _mm256_and_pd(away, step));
+  return _mm256_cvttpd_epi32(
+      _mm256_max_pd(_mm256_set1_pd(-SCALING), _mm256_min_pd(_mm256_set1_pd(SCALING - 1), rounded)));
+}
+
+__attribute__((target("avx2"))) auto addClampedAVX2(const double *in, double *out, size_t count)
+    -> void {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m256d sum = _mm256_add_pd(_mm256_loadu_pd(out + i), _mm256_loadu_pd(in + i));
+    _mm256_storeu_pd(out + i, clampUnitAVX2(sum));
+  }
+  addClampedScalar(in + i, out + i, count - i);
+}
+
+__attribute__((target("avx2"))) auto mixClampedAVX2(const double *const *in, size_t inCount,
+                                                    double gain, double *out, size_t count)
+    -> void {
+  const __m256d gainVector = _mm256_set1_pd(gain);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(mixAVX2(in, inCount, i), gainVector));
+  }
+  for (; i < count; i++) {
+    out[i] = mixSample(in, inCount, i) * gain;
+  }
+}
+
+__attribute__((target("avx2"))) auto mixClampedQuantizedAVX2(const double *const *in,
+                                                             size_t inCount, double gain,
+                                                             int16_t *out, size_t stride,
+                                                             size_t count) -> void {
+  const __m256d gainVector = _mm256_set1_pd(gain);
+  std::array<int32_t, 4> samples{};
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128i quantized = quantizeAVX2(_mm256_mul_pd(mixAVX2(in, inCount, i), gainVector));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(samples.data()), quantized);
+    for (size_t k = 0; k < samples.size(); k++) {
+      out[(i + k) * stride] = static_cast<int16_t>(samples[k]);
+    }
+  }
+  for (; i < count; i++) {
+    out[i * stride] = quantizeSample(mixSample(in, inCount, i) * gain);
+  }
+}
+
+__attribute__((target("avx2"))) inline auto clampUnitAVX2(__m256 value) -> __m256 {
+  return _mm256_max_ps(_mm256_set1_ps(-1), _mm256_min_ps(_mm256_set1_ps(1), value));
+}
+
+__attribute__((target("avx2"))) inline auto mixAVX2(const float *const *in, size_t inCount,
+                                                    size_t i) -> __m256 {
+  __m256 mix = _mm256_setzero_ps();
+  for (size_t s = 0; s < inCount; s++) {
+    mix = clampUnitAVX2(_mm256_add_ps(mix, _mm256_loadu_ps(in[s] + i)));
+  }
+  return mix;
+}
+
+__attribute__((target("avx2"))) auto addClampedAVX2(const float *in, float *out, size_t count)
+    -> void {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m256 sum = _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_loadu_ps(in + i));
+    _mm256_storeu_ps(out + i, clampUnitAVX2(sum));
+  }
+  addClampedScalar(in + i, out + i, count - i);
+}
+
+__attribute__((target("avx2"))) auto mixClampedQuantizedAVX2(const float *const *in,
+                                                             size_t inCount, double gain,
+                                                             int16_t *out, size_t stride,
+                                                             size_t count) -> void {
+  const __m256d gainVector = _mm256_set1_pd(gain);
+  std::array<int32_t, 8> samples{};
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m256 mix = mixAVX2(in, inCount, i);
+    const __m256d low = _mm256_cvtps_pd(_mm256_castps256_ps128(mix));
+    const __m256d high = _mm256_cvtps_pd(_mm256_extractf128_ps(mix, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(samples.data()),
+                     quantizeAVX2(_mm256_mul_pd(low, gainVector)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(samples.data() + 4),
+                     quantizeAVX2(_mm256_mul_pd(high, gainVector)));
+    for (size_t k = 0; k < samples.size(); k++) {
+      out[(i + k) * stride] = static_cast<int16_t>(samples[k]);
+    }
+  }
+  for (; i < count; i++) {
+    out[i * stride] = quantizeSample(static_cast<double>(mixSample(in, inCount, i)) * gain);
+  }
+}
+
+__attribute__((target("sse4.1"))) auto decibelsToPowerSSE41(const double *in, double *out,
+                                                            size_t count) -> void {
+  const __m128d minimum = _mm_set1_pd(EXP2_MIN);
+  const __m128d maximum = _mm_set1_pd(EXP2_MAX);
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    const __m128d t = _mm_mul_pd(_mm_loadu_pd(in + i), _mm_set1_pd(DECIBEL_TO_EXP2));
+    // Out of range and NaN exponents are replaced below, they are clamped to stay representable
+    const __m128d clamped = _mm_min_pd(_mm_max_pd(t, minimum), maximum);
+    const __m128d n = _mm_round_pd(clamped, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    const __m128d f = _mm_sub_pd(clamped, n);
+    __m128d p = _mm_add_pd(_mm_set1_pd(EXP2_C11), _mm_mul_pd(f, _mm_set1_pd(EXP2_C12)));
+    p = _mm_add_pd(_mm_set1_pd(EXP2_C10), _mm_mul_pd(f, p));
+    p = _mm_add_pd(_mm_set1_pd(EXP2_C9), _mm_mul_pd(f, p));
+    p = _mm_add_pd(_mm_set1_pd(EXP2_C8), _mm_mul_pd(f, p));
+    p = _mm_add_pd(_mm_set1_pd(EXP2_C7), _mm_mul_pd(f, p));
+    p = _mm_add_pd(_mm_set1_pd(EXP2_C6), _mm_mul_pd(f, p));
+    p = _mm_add_pd(_mm_set1_pd(EXP2_C5), _mm_mul_pd(f, p));
+    p = _mm_add_pd(_mm_set1_pd(EXP2_C4), _mm_mul_pd(f, p));
+    p = _mm_add_pd(_mm_set1_pd(EXP2_C3), _mm_mul_pd(f, p));
+    p = _mm_add_pd(_mm_set1_pd(EXP2_C2), _mm_mul_pd(f, p));
+    p = _mm_add_pd(_mm_set1_pd(EXP2_C1), _mm_mul_pd(f, p));
+    p = _mm_add_pd(_mm_set1_pd(1), _mm_mul_pd(f, p));
+    const __m128i exponent =
+        _mm_add_epi64(_mm_castpd_si128(_mm_add_pd(n, _mm_set1_pd(ROUNDING_MAGIC))),
+                      _mm_set1_epi64x(EXPONENT_BIAS));
+    __m128d power = _mm_mul_pd(p, _mm_castsi128_pd(_mm_slli_epi64(exponent, MANTISSA_BITS)));
+    power = _mm_and_pd(power, _mm_cmpge_pd(t, minimum));
+    power = _mm_blendv_pd(power, _mm_set1_pd(std::numeric_limits<double>::infinity()),
+                          _mm_cmpgt_pd(t, maximum));
+    _mm_storeu_pd(out + i, _mm_blendv_pd(power, t, _mm_cmpunord_pd(t, t)));
+  }
+  decibelsToPowerScalar(in + i, out + i, count - i);
+}
+
+__attribute__((target("avx2"))) auto decibelsToPowerAVX2(const double *in, double *out,
+                                                         size_t count) -> void {
+  const __m256d minimum = _mm256_set1_pd(EXP2_MIN);
+  const __m256d maximum = _mm256_set1_pd(EXP2_MAX);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m256d t = _mm256_mul_pd(_mm256_loadu_pd(in + i), _mm256_set1_pd(DECIBEL_TO_EXP2));
+    const __m256d clamped = _mm256_min_pd(_mm256_max_pd(t, minimum), maximum);
+    const __m256d n = _mm256_round_pd(clamped, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    const __m256d f = _mm256_sub_pd(clamped, n);
+    __m256d p = _mm256_add_pd(_mm256_set1_pd(EXP2_C11), _mm256_mul_pd(f, _mm256_set1_pd(EXP2_C12)));
+    p = _mm256_add_pd(_mm256_set1_pd(EXP2_C10), _mm256_mul_pd(f, p));
+    p = _mm256_add_pd(_mm256_set1_pd(EXP2_C9), _mm256_mul_pd(f, p));
+    p = _mm256_add_pd(_mm256_set1_pd(EXP2_C8), _mm256_mul_pd(f, p));
+    p = _mm256_add_pd(_mm256_set1_pd(EXP2_C7), _mm256_mul_pd(f, p));
+    p = _mm256_add_pd(_mm256_set1_pd(EXP2_C6), _mm256_mul_pd(f, p));
+    p = _mm256_add_pd(_mm256_set1_pd(EXP2_C5), _mm256_mul_pd(f, p));
+    p = _mm256_add_pd(_mm256_set1_pd(EXP2_C4), _mm256_mul_pd(f, p));
+    p = _mm256_add_pd(_mm256_set1_pd(EXP2_C3), _mm256_mul_pd(f, p));
+    p = _mm256_add_pd(_mm256_set1_pd(EXP2_C2), _mm256_mul_pd(f, p));
+    p = _mm256_add_pd(_mm256_set1_pd(EXP2_C1), _mm256_mul_pd(f, p));
+    p = _mm256_add_pd(_mm256_set1_pd(1), _mm256_mul_pd(f, p));
+    const __m256i exponent =
+        _mm256_add_epi64(_mm256_castpd_si256(_mm256_add_pd(n, _mm256_set1_pd(ROUNDING_MAGIC))),
+                         _mm256_set1_epi64x(EXPONENT_BIAS));
+    __m256d power =
+        _mm256_mul_pd(p, _mm256_castsi256_pd(_mm256_slli_epi64(exponent, MANTISSA_BITS)));
+    power = _mm256_and_pd(power, _mm256_cmp_pd(t, minimum, _CMP_GE_OQ));
+    power = _mm256_blendv_pd(power, _mm256_set1_pd(std::numeric_limits<double>::infinity()),
+                             _mm256_cmp_pd(t, maximum, _CMP_GT_OQ));
+    _mm256_storeu_pd(out + i, _mm256_blendv_pd(power, t, _mm256_cmp_pd(t, t, _CMP_UNORD_Q)));
+  }
+  decibelsToPowerScalar(in + i, out + i, count - i);
+}
+
+// The envelope is kept in a register while the parabolas are evaluated. maxpd returns its first
+// operand only when it is strictly greater, as computeParabolaEnvelopeScalar does.
+__attribute__((target("sse4.1"))) auto computeParabolaEnvelopeSSE41(const double *x,
+                                                                    const Parabolas &parabolas,
+                                                                    double *out, size_t count)
+    -> void {
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    const __m128d position = _mm_loadu_pd(x + i);
+    __m128d envelope = _mm_setzero_pd();
+    for (size_t p = 0; p < parabolas.count; p++) {
+      const __m128d distance = _mm_sub_pd(position, _mm_set1_pd(parabolas.center[p]));
+      const __m128d square = _mm_mul_pd(distance, distance);
+      const __m128d value = _mm_add_pd(_mm_mul_pd(square, _mm_set1_pd(parabolas.curvature[p])),
+                                       _mm_set1_pd(parabolas.offset[p]));
+      envelope = p == 0 ? value : _mm_max_pd(value, envelope);
+    }
+    _mm_storeu_pd(out + i, envelope);
+  }
+  computeParabolaEnvelopeScalar(x + i, parabolas, out + i, count - i);
+}
+
+__attribute__((target("avx2"))) auto computeParabolaEnvelopeAVX2(const double *x,
+                                                                 const Parabolas &parabolas,
+                                                                 double *out, size_t count)
+    -> void {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m256d position = _mm256_loadu_pd(x + i);
+    __m256d envelope = _mm256_setzero_pd();
+    for (size_t p = 0; p < parabolas.count; p++) {
+      const __m256d distance = _mm256_sub_pd(position, _mm256_set1_pd(parabolas.center[p]));
+      const __m256d square = _mm256_mul_pd(distance, distance);
+      const __m256d value =
+          _mm256_add_pd(_mm256_mul_pd(square, _mm256_set1_pd(parabolas.curvature[p])),
+                        _mm256_set1_pd(parabolas.offset[p]));
+      envelope = p == 0 ? value : _mm256_max_pd(value, envelope);
+    }
+    _mm256_storeu_pd(out + i, envelope);
+  }
+  computeParabolaEnvelopeScalar(x + i, parabolas, out + i, count - i);
+}
+
+#endif
+
+auto selectedSimdLevel() -> std::atomic<SimdLevel> & {
+  static std::atomic<SimdLevel> level(getSupportedSimdLevel());
+  return level;
+}
+
+} // namespace
+
+auto computeWaveform(Waveform waveform, const double *time, const double *frequency, double phase,
+                     double *out, size_t count) -> void {
+  switch (getSimdLevel()) {
+#ifdef HAPTICS_X86_KERNELS
+  case SimdLevel::AVX2:
+    computeWaveformAVX2(waveform, time, frequency, phase, out, count);
+    break;
+  case SimdLevel::SSE41:
+    computeWaveformSSE41(waveform, time, frequency, phase, out, count);
+    break;
+#endif
+  default:
+    computeWaveformScalar(waveform, time, frequency, phase, out, count);
+    break;
+  }
+}
+
+auto multiplyAccumulate(const double *in, double gain, double *out, size_t count) -> void {
+  switch (getSimdLevel()) {
+#ifdef HAPTICS_X86_KERNELS
+  case SimdLevel::AVX2:
+    multiplyAccumulateAVX2(in, gain, out, count);
+    break;
+  case SimdLevel::SSE41:
+    multiplyAccumulateSSE41(in, gain, out, count);
+    break;
+#endif
+  default:
+    multiplyAccumulateScalar(in, gain, out, count);
+    break;
+  }
+}
+
+auto addClamped(const double *in, double *out, size_t count) -> void {
+  switch (getSimdLevel()) {
+#ifdef HAPTICS_X86_KERNELS
+  case SimdLevel::AVX2:
+    addClampedAVX2(in, out, count);
+    break;
+  case SimdLevel::SSE41:
+    addClampedSSE41(in, out, count);
+    break;
+#endif
+  default:
+    addClampedScalar(in, out, count);
+    break;
+  }
+}
+
+auto addClamped(const float *in, float *out, size_t count) -> void {
+  switch (getSimdLevel()) {
+#ifdef HAPTICS_X86_KERNELS
+  case SimdLevel::AVX2:
+    addClampedAVX2(in, out, count);
+    break;
+  case SimdLevel::SSE41:
+    addClampedSSE41(in, out, count);
+    break;
+#endif
+  default:
+    addClampedScalar(in, out, count);
+    break;
+  }
+}
+
+auto mixClamped(const double *const *in, size_t inCount, double gain, double *out, size_t count)
+    -> void {
+  switch (getSimdLevel()) {
+#ifdef HAPTICS_X86_KERNELS
+  case SimdLevel::AVX2:
+    mixClampedAVX2(in, inCount, gain, out, count);
+    break;
+  case SimdLevel::SSE41:
+    mixClampedSSE41(in, inCount, gain, out, count);
+    break;
+#endif
+  default:
+    mixClampedScalar(in, inCount, gain, out, count);
+    break;
+  }
+}
+
+auto mixClampedQuantized(const double *const *in, size_t inCount, double gain, int16_t *out,
+                         size_t stride, size_t count) -> void {
+  switch (getSimdLevel()) {
+#ifdef HAPTICS_X86_KERNELS
+  case SimdLevel::AVX2:
+    mixClampedQuantizedAVX2(in, inCount, gain, out, stride, count);
+    break;
+  case SimdLevel::SSE41:
+    mixClampedQuantizedSSE41(in, inCount, gain, out, stride, count);
+    break;
+#endif
+  default:
+    mixClampedQuantizedScalar(in, inCount, gain, out, stride, count);
+    break;
+  }
+}
+
+auto mixClampedQuantized(const float *const *in, size_t inCount, double gain, int16_t *out,
+                         size_t stride, size_t count) -> void {
+  switch (getSimdLevel()) {
+#ifdef HAPTICS_X86_KERNELS
+  case SimdLevel::AVX2:
+    mixClampedQuantizedAVX2(in, inCount, gain, out, stride, count);
+    break;
+  case SimdLevel::SSE41:
+    mixClampedQuantizedSSE41(in, inCount, gain, out, stride, count);
+    break;
+#endif
+  default:
+    mixClampedQuantizedScalar(in, inCount, gain, out, stride, count);
+    break;
+  }
+}
+
+auto decibelsToPower(const double *in, double *out, size_t count) -> void {
+  switch (getSimdLevel()) {
+#ifdef HAPTICS_X86_KERNELS
+  case SimdLevel::AVX2:
+    decibelsToPowerAVX2(in, out, count);
+    break;
+  case SimdLevel::SSE41:
+    decibelsToPowerSSE41(in, out, count);
+    break;
+#endif
+  default:
+    decibelsToPowerScalar(in, out, count);
+    break;
+  }
+}
+
+auto computeParabolaEnvelope(const double *x, const Parabolas &parabolas, double *out,
+                             size_t count) -> void {
+  if (parabolas.count == 0) {
+    return;
+  }
+  switch (getSimdLevel()) {
+#ifdef HAPTICS_X86_KERNELS
+  case SimdLevel::AVX2:
+    computeParabolaEnvelopeAVX2(x, parabolas, out, count);
+    break;
+  case SimdLevel::SSE41:
+    computeParabolaEnvelopeSSE41(x, parabolas, out, count);
+    break;
+#endif
+  default:
+    computeParabolaEnvelopeScalar(x, parabolas, out, count);
+    break;
+  }
+}
+
+[[nodiscard]] auto getSupportedSimdLevel() -> SimdLevel {
+#ifdef HAPTICS_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::AVX2;
+  }
+  if (__builtin_cpu_supports("sse4.1")) {
+    return SimdLevel::SSE41;
+  }
+#endif
+  return SimdLevel::Scalar;
+}
+
+[[nodiscard]] auto getSimdLevel() -> SimdLevel { return selectedSimdLevel(); }
+
+auto setSimdLevel(SimdLevel level) -> SimdLevel {
+  const SimdLevel supported = getSupportedSimdLevel();
+  const SimdLevel selected =
+      static_cast<int>(level) < static_cast<int>(supported) ? level : supported;
+  selectedSimdLevel() = selected;
+  return selected;
+}
+
+} // namespace haptics::tools
@@ -0,0 +1,161 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Tools/include/ThreadPool.h>
+
+namespace haptics::tools {
+
+ThreadPool::ThreadPool(size_t threadCount) {
+  const size_t workerCount = threadCount > 1 ? threadCount - 1 : 0;
+  // One queue per worker, plus one filled by the calling thread
+  for (size_t i = 0; i <= workerCount; i++) {
+    queues.push_back(std::make_unique<TaskQueue>());
+  }
+  for (size_t i = 0; i < workerCount; i++) {
+    workers.emplace_back(&ThreadPool::workerLoop, this, i + 1);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    stopping = true;
+  }
+  workAvailable.notify_all();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+}
+
+[[nodiscard]] auto ThreadPool::getThreadCount() const -> size_t { return workers.size() + 1; }
+
+auto ThreadPool::parallelFor(size_t taskCount, const std::function<void(size_t)> &task) -> void {
+  if (taskCount == 0) {
+    return;
+  }
+  if (workers.empty()) {
+    for (size_t i = 0; i < taskCount; i++) {
+      task(i);
+    }
+    return;
+  }
+
+  TaskGroup group;
+  group.body = &task;
+  group.remaining = taskCount;
+  {
+    // Counted before being queued so that the counter never goes below the number of queued tasks
+    std::lock_guard<std::mutex> lock(stateMutex);
+    queuedTasks += taskCount;
+  }
+  for (size_t i = 0; i < taskCount; i++) {
+    TaskQueue &queue = *queues[i % queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back({&group, i});
+  }
+  workAvailable.notify_all();
+
+  Task current;
+  while (group.remaining > 0) {
+    if (popTask(0, current)) {
+      runTask(current);
+      continue;
+    }
+    // Nothing left to steal: the last tasks of the group are running on the workers
+    std::unique_lock<std::mutex> lock(stateMutex);
+    groupFinished.wait(lock, [&] { return group.remaining == 0 || queuedTasks > 0; });
+  }
+
+  if (group.error) {
+    std::rethrow_exception(group.error);
+  }
+}
+
+auto ThreadPool::workerLoop(size_t queueIndex) -> void {
+  Task current;
+  while (true) {
+    if (popTask(queueIndex, current)) {
+      runTask(current);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(stateMutex);
+    workAvailable.wait(lock, [&] { return stopping || queuedTasks > 0; });
+    if (stopping && queuedTasks == 0) {
+      return;
+    }
+  }
+}
+
+auto ThreadPool::popTask(size_t queueIndex, Task &task) -> bool {
+  {
+    TaskQueue &own = *queues[queueIndex];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = own.tasks.back();
+      own.tasks.pop_back();
+      queuedTasks--;
+      return true;
+    }
+  }
+  for (size_t i = 1; i < queues.size(); i++) {
+    TaskQueue &victim = *queues[(queueIndex + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = victim.tasks.front();
+      victim.tasks.pop_front();
+      queuedTasks--;
+      return true;
+    }
+  }
+  return false;
+}
+
+auto ThreadPool::runTask(Task &task) -> void {
+  TaskGroup &group = *task.group;
+  try {
+    (*group.body)(task.index);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(group.errorMutex);
+    if (!group.error) {
+      group.error = std::current_exception();
+    }
+  }
+  if (--group.remaining == 0) {
+    // Taking the lock prevents the notification from being lost between the check of the
+    // waiting thread and its wait
+    std::lock_guard<std::mutex> lock(stateMutex);
+    groupFinished.notify_all();
+  }
+}
+
+} // namespace haptics::tools
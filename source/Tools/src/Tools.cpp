@@ -32,6 +32,9 @@
  */
 
 #include <Tools/include/Tools.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <cmath>
 
 namespace haptics::tools {
@@ -425,6 +428,298 @@ auto linearInterpolation(std::pair<int, double> a, std::pair<int, double> b, dou
   return interpolation;
 }
 
+namespace {
+
+// Knot index of the quadratic B-spline interpolating pointCount points, as built by
+// bsplineInterpolation: knots are uniform in [0, 1] and clamped at both ends.
+auto bsplineKnot(int index, int pointCount) -> double {
+  if (index < 2) {
+    return 0;
+  }
+  if (index > pointCount) {
+    return 1;
+  }
+  return (index - 2) / static_cast<double>(pointCount - 2);
+}
+
+// First knot index greater than t, searched from the index k. It is kept within the knot spans
+// that have three control points.
+auto bsplineSpan(double t, int pointCount, int k) -> int {
+  while (k > 3 && t < bsplineKnot(k - 1, pointCount)) {
+    k--;
+  }
+  while (k < pointCount && t >= bsplineKnot(k, pointCount)) {
+    k++;
+  }
+  return k;
+}
+
+// De Boor evaluation of the B-spline at the parameter t of the knot span k. Sample positions are
+// interpolated when abscissa is set, amplitudes otherwise.
+auto bsplineValue(const std::vector<std::pair<int, double>> &points, double t, int k,
+                  bool abscissa) -> double {
+  const auto pointCount = static_cast<int>(points.size());
+  std::array<std::array<double, 3>, 3> x{};
+  for (int j = 0; j < 3; j++) {
+    const std::pair<int, double> &point = points[k - 3 + j];
+    x[0][j] = abscissa ? point.first : point.second;
+  }
+  for (int i = 1; i < 3; i++) {
+    for (int j = i; j < 3; j++) {
+      const double num = t - bsplineKnot(k - 3 + j, pointCount);
+      double wt = 0;
+      if (num != 0) {
+        wt = num / (bsplineKnot(k + j - i, pointCount) - bsplineKnot(k - 3 + j, pointCount));
+      }
+      x[i][j] = (1 - wt) * x[i - 1][j - 1] + wt * x[i - 1][j];
+    }
+  }
+  return x[2][2];
+}
+
+auto akimaCoefficients(const std::vector<std::pair<int, double>> &points,
+                       std::vector<double> &coefficients) -> void {
+  const size_t n = points.size();
+  auto dx = [&points](size_t i) -> double { return points[i + 1].first - points[i].first; };
+  auto m = [&points, &dx](size_t i) -> double {
+    return (points[i + 1].second - points[i].second) / dx(i);
+  };
+  // slopes extended by two extrapolated slopes on each side
+  auto m1 = [n, &m](size_t i) -> double {
+    if (i == 0) {
+      return 3 * m(0) - 2 * m(1);
+    }
+    if (i == 1) {
+      return 2 * m(0) - m(1);
+    }
+    if (i == n + 1) {
+      return 2 * m(n - 2) - m(n - 3);
+    }
+    if (i == n + 2) {
+      return 3 * m(n - 2) - 2 * m(n - 3);
+    }
+    return m(i - 2);
+  };
+  auto dm = [&m1](size_t i) -> double { return fabs(m1(i + 1) - m1(i)); };
+
+  // coefficients[3 * i], coefficients[3 * i + 1] and coefficients[3 * i + 2] hold b[i], c[i] and
+  // d[i] of akimaInterpolation
+  coefficients.assign(3 * n, 0);
+  double max = AKIMA_EPSILON;
+  for (size_t i = 0; i < n; i++) {
+    max = std::max(max, dm(i + 2) + dm(i));
+  }
+  for (size_t i = 0; i < n; i++) {
+    const double f1 = dm(i + 2);
+    const double f2 = dm(i);
+    const double f = f1 + f2;
+    coefficients[3 * i] = m1(i + 1);
+    if (f > std::pow(AKIMA_THRESHOLD, AKIMA_THRESHOLD2) * max) {
+      coefficients[3 * i] = (f1 * m1(i + 1) + f2 * m1(i + 2)) / f;
+    }
+  }
+  for (size_t i = 0; i + 1 < n; i++) {
+    const double b0 = coefficients[3 * i];
+    const double b1 = coefficients[3 * (i + 1)];
+    coefficients[3 * i + 1] = (3 * m(i) - 2 * b0 - b1) / dx(i);
+    coefficients[3 * i + 2] = (b0 + b1 - 2 * m(i)) / std::pow(dx(i), 2);
+  }
+}
+
+auto linearValue(const std::pair<int, double> &a, const std::pair<int, double> &b, double t)
+    -> double {
+  const double t0 = a.first;
+  const double t1 = b.first;
+  return (a.second * (t1 - t) + b.second * (t - t0)) / (t1 - t0);
+}
+
+auto cubicValue(const std::pair<int, double> &a, const std::pair<int, double> &b, double t)
+    -> double {
+  const double t0 = a.first;
+  const double f0 = a.second;
+  const double h = b.first - t0;
+  return f0 + (b.second - f0) * (3 * h + 2 * (t0 - t)) * std::pow(t - t0, 2) / std::pow(h, 3);
+}
+
+auto bezierValue(const std::vector<std::pair<int, double>> &points, size_t i, int sample)
+    -> double {
+  const int dx1 = points[i + 1].first - points[i].first + 1;
+  const int dx2 = points[i + 2].first - points[i].first + 1;
+  const int j = sample - points[i].first + 1;
+  double t = 0;
+  if (1 - 2 * dx1 + dx2 != 0) {
+    t = (1 - dx1 + std::sqrt(std::pow(dx1, 2) - 2 * j * dx1 + j * 1 + j * dx2 - 1 * dx2)) /
+        (1 - 2 * dx1 + dx2);
+  } else {
+    t = (1 - j) / static_cast<double>(2 * (1 - dx1));
+  }
+  return std::pow(1 - t, 2) * points[i].second + (1 - t) * 2 * t * points[i + 1].second +
+         std::pow(t, 2) * points[i + 2].second;
+}
+
+// Linear and cubic curves: sample belongs to the first segment ending at or after it
+auto segmentBlock(const std::vector<std::pair<int, double>> &points, bool cubic, int first,
+                  int last, double *out) -> void {
+  size_t i = static_cast<size_t>(
+      std::lower_bound(points.begin() + 1, points.end(), first,
+                       [](const std::pair<int, double> &p, int s) { return p.first < s; }) -
+      points.begin() - 1);
+  for (int s = first; s <= last; s++) {
+    while (points[i + 1].first < s) {
+      i++;
+    }
+    *out++ += cubic ? cubicValue(points[i], points[i + 1], s)
+                    : linearValue(points[i], points[i + 1], s);
+  }
+}
+
+// Akima curves: sample belongs to the last segment starting at or before it
+auto akimaBlock(const std::vector<std::pair<int, double>> &points,
+                const std::vector<double> &coefficients, int first, int last, double *out)
+    -> void {
+  size_t i = static_cast<size_t>(
+      std::upper_bound(points.begin(), points.end() - 1, first,
+                       [](int s, const std::pair<int, double> &p) { return s < p.first; }) -
+      points.begin() - 1);
+  for (int s = first; s <= last; s++) {
+    if (s == points.back().first) {
+      *out++ += points.back().second;
+      continue;
+    }
+    while (points[i + 1].first <= s) {
+      i++;
+    }
+    const int x = s - points[i].first;
+    *out++ += ((x * coefficients[3 * i + 2] + coefficients[3 * i + 1]) * x + coefficients[3 * i]) *
+                  x +
+              points[i].second;
+  }
+}
+
+// Quadratic Bezier curves over pairs of segments. With an even number of points the last point
+// is joined linearly, which is the quadratic Bezier curve whose control point is the middle of the
+// segment.
+auto bezierBlock(const std::vector<std::pair<int, double>> &points, int first, int last,
+                 double *out) -> void {
+  const size_t size = points.size() % 2 == 0 ? points.size() - 1 : points.size();
+  const int bezierEnd = points[size - 1].first;
+  size_t i = 0;
+  while (i + 2 < size && points[i + 2].first <= first) {
+    i += 2;
+  }
+  for (int s = first; s <= last; s++) {
+    if (s < bezierEnd) {
+      while (points[i + 2].first <= s) {
+        i += 2;
+      }
+      *out++ += bezierValue(points, i, s);
+    } else if (s == bezierEnd) {
+      *out++ += points[size - 1].second;
+    } else {
+      *out++ += linearValue(points[size - 1], points.back(), s);
+    }
+  }
+}
+
+// Quadratic B-spline curves. As in bsplineInterpolation, the parameter of a sample is the first
+// point of a regular grid whose abscissa reaches the sample. Grid points are indexed rather than
+// accumulated, so that a sample does not depend on the first sample of the block.
+auto bsplineBlock(const std::vector<std::pair<int, double>> &points, int first, int last,
+                  double *out) -> void {
+  const auto pointCount = static_cast<int>(points.size());
+  const int n = points.back().first;
+  const double step = (1 / static_cast<double>(n)) / BSPLINE_STEP;
+  auto parameter = [step](int64_t q) -> double { return static_cast<double>(q) * step; };
+  auto span = [pointCount](double t) -> int {
+    const int k = 3 + static_cast<int>(t * (pointCount - 2));
+    return bsplineSpan(t, pointCount, std::clamp(k, 3, pointCount));
+  };
+
+  // first grid point reaching the first sample, found by dichotomy as abscissae are increasing
+  const int firstInner = std::max(first, 1);
+  int64_t low = 1;
+  int64_t high = static_cast<int64_t>(n) * BSPLINE_STEP + 1;
+  while (low < high) {
+    const int64_t middle = low + (high - low) / 2;
+    const double t = parameter(middle);
+    if (bsplineValue(points, t, span(t), true) < firstInner) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  int64_t q = low;
+  int k = span(parameter(q));
+
+  for (int s = first; s <= last; s++) {
+    if (s == 0) {
+      *out++ += points.front().second;
+      continue;
+    }
+    if (s == n) {
+      *out++ += points.back().second;
+      continue;
+    }
+    while (bsplineValue(points, parameter(q), k, true) < s) {
+      q++;
+      k = bsplineSpan(parameter(q), pointCount, k);
+    }
+    *out++ += bsplineValue(points, parameter(q), k, false);
+  }
+}
+
+} // namespace
+
+auto curveCoefficients(const std::vector<std::pair<int, double>> &points,
+                       types::CurveType curveType, std::vector<double> &coefficients) -> void {
+  coefficients.clear();
+  if (points.size() > 2 && curveType == types::CurveType::Akima) {
+    akimaCoefficients(points, coefficients);
+  }
+}
+
+auto curveInterpolationBlock(const std::vector<std::pair<int, double>> &points,
+                             types::CurveType curveType, const std::vector<double> &coefficients,
+                             int first, double *out, size_t count) -> void {
+  if (points.empty() || count == 0) {
+    return;
+  }
+  const int begin = std::max(first, 0);
+  const auto end = static_cast<int>(
+      std::min<int64_t>(static_cast<int64_t>(first) + static_cast<int64_t>(count) - 1,
+                        points.back().first));
+  if (begin > end) {
+    return;
+  }
+  out += begin - first;
+  if (points.size() == 1) {
+    *out += points.front().second;
+    return;
+  }
+  if (points.size() == 2) {
+    segmentBlock(points, false, begin, end, out);
+    return;
+  }
+  switch (curveType) {
+  case types::CurveType::Linear:
+    segmentBlock(points, false, begin, end, out);
+    break;
+  case types::CurveType::Akima:
+    akimaBlock(points, coefficients, begin, end, out);
+    break;
+  case types::CurveType::Bezier:
+    bezierBlock(points, begin, end, out);
+    break;
+  case types::CurveType::Bspline:
+    bsplineBlock(points, begin, end, out);
+    break;
+  case types::CurveType::Cubic:
+  default:
+    segmentBlock(points, true, begin, end, out);
+    break;
+  }
+}
+
 [[nodiscard]] auto isNumber(const std::string &s) -> bool {
   std::string::const_iterator it = s.begin();
   while (it != s.end() && std::isdigit(*it) != 0) {
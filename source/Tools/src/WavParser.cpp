@@ -83,16 +83,7 @@ auto WavParser::saveFile(const std::string &filename, const std::vector<double>
   drwav_init_file_write(&wav, filename.c_str(), &format, nullptr);
   std::vector<uint16_t> b_int;
   b_int.resize(buff.size());
-  std::transform(buff.begin(), buff.end(), b_int.begin(), [](double v) -> uint16_t {
-    auto v_scaled = (round(v * SCALING));
-    if (v_scaled > SCALING - 1) {
-      return (uint16_t)SCALING - 1;
-    }
-    if (v_scaled < -SCALING) {
-      return NEG_MAX;
-    }
-    return (uint16_t)v_scaled;
-  });
+  std::transform(buff.begin(), buff.end(), b_int.begin(), quantize);
   drwav_write_pcm_frames(&wav, b_int.size(), b_int.data());
   drwav_uninit(&wav);
   return true;
@@ -121,14 +112,7 @@ auto WavParser::saveFile(const std::string &filename, const std::vector<std::vec
   long c = 0;
   for (const auto &b : buff) {
     for (uint32_t i = 0; i < b.size(); i++) {
-      auto v = (round(b.at(i) * SCALING));
-      if (v > SCALING - 1) {
-        b_int.at((i * buff.size()) + c) = (uint16_t)SCALING - 1;
-      } else if (v < -SCALING) {
-        b_int.at((i * buff.size()) + c) = NEG_MAX;
-      } else {
-        b_int.at((i * buff.size()) + c) = (uint16_t)v;
-      }
+      b_int.at((i * buff.size()) + c) = quantize(b.at(i));
     }
     c++;
   }
@@ -137,6 +121,17 @@ auto WavParser::saveFile(const std::string &filename, const std::vector<std::vec
   return true;
 }
 
+auto WavParser::quantize(double value) -> uint16_t {
+  auto v = (round(value * SCALING));
+  if (v > SCALING - 1) {
+    return (uint16_t)SCALING - 1;
+  }
+  if (v < -SCALING) {
+    return NEG_MAX;
+  }
+  return (uint16_t)v;
+}
+
 auto WavParser::getSamplerate() const -> uint32_t { return sampleRate; }
 
 auto WavParser::getNumChannels() const -> size_t { return numChannels; }
@@ -0,0 +1,97 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Tools/include/WavParser.h>
+#include <Tools/include/WavWriter.h>
+
+namespace haptics::tools {
+
+WavWriter::~WavWriter() { close(); }
+
+auto WavWriter::open(const std::string &filename, size_t newChannelCount, int sampleRate)
+    -> bool {
+  if (opened || newChannelCount == 0) {
+    return false;
+  }
+  drwav_data_format format;
+  format.container = drwav_container_riff;
+  format.format = DR_WAVE_FORMAT_PCM;
+  format.channels = newChannelCount;
+  format.sampleRate = sampleRate;
+  format.bitsPerSample = BITS_PER_SAMPLE;
+  if (!(bool)drwav_init_file_write(&wav, filename.c_str(), &format, nullptr)) {
+    return false;
+  }
+  opened = true;
+  channelCount = newChannelCount;
+  return true;
+}
+
+auto WavWriter::writeFrames(const std::vector<std::vector<double>> &buff, size_t frameCount)
+    -> bool {
+  if (!opened || buff.size() != channelCount) {
+    return false;
+  }
+  for (const auto &b : buff) {
+    if (b.size() < frameCount) {
+      std::cerr << "Output Channels are of different size" << std::endl;
+      return false;
+    }
+  }
+  interleaved.resize(frameCount * channelCount);
+  for (size_t c = 0; c < channelCount; c++) {
+    for (size_t i = 0; i < frameCount; i++) {
+      interleaved[(i * channelCount) + c] = WavParser::quantize(buff[c][i]);
+    }
+  }
+  return drwav_write_pcm_frames(&wav, frameCount, interleaved.data()) == frameCount;
+}
+
+auto WavWriter::writeFrames(const int16_t *frames, size_t frameCount) -> bool {
+  if (!opened) {
+    return false;
+  }
+  return drwav_write_pcm_frames(&wav, frameCount, frames) == frameCount;
+}
+
+auto WavWriter::close() -> bool {
+  if (!opened) {
+    return false;
+  }
+  opened = false;
+  return drwav_uninit(&wav) == DRWAV_SUCCESS;
+}
+
+[[nodiscard]] auto WavWriter::isOpen() const -> bool { return opened; }
+
+} // namespace haptics::tools
@@ -71,3 +71,13 @@ TEST_CASE("InputParser::getFileExt") {
     }
   }
 }
+
+TEST_CASE("InputParser::getThreadCount") {
+  std::vector<const char *> fake_argv = {"fake_prg", "--threads", "3", "--zero", "0",
+                                         "--negative", "-2"};
+  InputParser inputParser(fake_argv);
+  CHECK(inputParser.getThreadCount("--threads") == 3);
+  CHECK(inputParser.getThreadCount("--zero") >= 1);
+  CHECK_FALSE(inputParser.getThreadCount("--negative").has_value());
+  CHECK(inputParser.getThreadCount("--absent") == 1);
+}
@@ -0,0 +1,375 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <Tools/include/SignalKernels.h>
+#include <Tools/include/WavParser.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using haptics::tools::SimdLevel;
+using haptics::tools::Waveform;
+
+namespace {
+// Same evaluation as Effect::computeBaseSignal
+auto referenceWaveform(Waveform waveform, double time, double frequency, double phase) -> double {
+  if (frequency != 0) {
+    time += phase / (2 * M_PI * frequency);
+  }
+  switch (waveform) {
+  case Waveform::Sine:
+    return std::sin(2 * M_PI * time * frequency);
+  case Waveform::Square:
+    return 1 - 2 * std::round(time * frequency - std::floor(time * frequency));
+  case Waveform::Triangle:
+    return 1 - 4 * std::abs(std::round(time * frequency - .25) - (time * frequency - .25));
+  case Waveform::SawToothUp:
+    return 2 * (time * frequency - std::floor(time * frequency + .5));
+  case Waveform::SawToothDown:
+    return 2 * (std::floor(time * frequency + .5) - time * frequency);
+  default:
+    return 1;
+  }
+}
+
+// Band mixing of Channel::mixBand followed by the channel gain
+auto referenceMix(const std::vector<std::vector<double>> &in, size_t i, double gain) -> double {
+  double mix = 0;
+  for (const std::vector<double> &signal : in) {
+    mix += signal[i];
+    if (mix < -1) {
+      mix = -1;
+    }
+    if (mix > 1) {
+      mix = 1;
+    }
+  }
+  return mix * gain;
+}
+} // namespace
+
+TEST_CASE("haptics::tools::computeWaveform") {
+  const size_t count = 1003;
+  std::mt19937 generator(42); // NOLINT
+  std::uniform_real_distribution<double> timeDistribution(0, 3);
+  std::uniform_int_distribution<int> frequencyDistribution(0, 1000);
+  std::vector<double> time(count);
+  std::vector<double> frequency(count);
+  for (size_t i = 0; i < count; i++) {
+    time[i] = timeDistribution(generator);
+    // null frequencies are used by the effects without frequency keyframes
+    frequency[i] = i % 10 == 0 ? 0 : frequencyDistribution(generator);
+  }
+  const std::vector<Waveform> waveforms = {Waveform::Sine, Waveform::Square, Waveform::Triangle,
+                                           Waveform::SawToothUp, Waveform::SawToothDown};
+  const SimdLevel supported = haptics::tools::getSupportedSimdLevel();
+
+  for (int level = 0; level <= static_cast<int>(supported); level++) {
+    CHECK(haptics::tools::setSimdLevel(static_cast<SimdLevel>(level)) ==
+          static_cast<SimdLevel>(level));
+    for (Waveform waveform : waveforms) {
+      for (double phase : {0.0, 1.3, -2.1}) {
+        std::vector<double> out(count);
+        haptics::tools::computeWaveform(waveform, time.data(), frequency.data(), phase,
+                                        out.data(), count);
+        for (size_t i = 0; i < count; i++) {
+          REQUIRE(out[i] ==
+                  Approx(referenceWaveform(waveform, time[i], frequency[i], phase))
+                      .margin(haptics::tools::SINE_APPROXIMATION_ERROR));
+        }
+      }
+    }
+  }
+  CHECK(haptics::tools::setSimdLevel(SimdLevel::AVX2) == supported);
+  CHECK(haptics::tools::getSimdLevel() == supported);
+}
+
+TEST_CASE("haptics::tools::multiplyAccumulate") {
+  const size_t count = 1003;
+  std::mt19937 generator(7); // NOLINT
+  std::uniform_real_distribution<double> distribution(-1, 1);
+  std::vector<double> in(count);
+  std::vector<double> initial(count);
+  for (size_t i = 0; i < count; i++) {
+    in[i] = distribution(generator);
+    initial[i] = distribution(generator);
+  }
+  const double gain = .37;
+  const SimdLevel supported = haptics::tools::getSupportedSimdLevel();
+
+  for (int level = 0; level <= static_cast<int>(supported); level++) {
+    haptics::tools::setSimdLevel(static_cast<SimdLevel>(level));
+    // Unaligned and partial blocks are handled by every instruction set
+    for (size_t offset : {0, 1, 3}) {
+      std::vector<double> out = initial;
+      haptics::tools::multiplyAccumulate(in.data() + offset, gain, out.data() + offset,
+                                         count - offset);
+      for (size_t i = 0; i < count; i++) {
+        REQUIRE(out[i] == (i < offset ? initial[i] : initial[i] + gain * in[i]));
+      }
+    }
+  }
+  haptics::tools::setSimdLevel(supported);
+}
+
+TEST_CASE("haptics::tools::addClamped") {
+  const size_t count = 1003;
+  std::mt19937 generator(11); // NOLINT
+  std::uniform_real_distribution<double> distribution(-1.5, 1.5);
+  std::vector<double> in(count);
+  std::vector<double> initial(count);
+  for (size_t i = 0; i < count; i++) {
+    in[i] = distribution(generator);
+    initial[i] = distribution(generator);
+  }
+  const SimdLevel supported = haptics::tools::getSupportedSimdLevel();
+
+  for (int level = 0; level <= static_cast<int>(supported); level++) {
+    haptics::tools::setSimdLevel(static_cast<SimdLevel>(level));
+    for (size_t offset : {0, 1, 3}) {
+      std::vector<double> out = initial;
+      haptics::tools::addClamped(in.data() + offset, out.data() + offset, count - offset);
+      for (size_t i = 0; i < count; i++) {
+        REQUIRE(out[i] == (i < offset ? initial[i] : std::clamp(initial[i] + in[i], -1.0, 1.0)));
+      }
+    }
+  }
+  haptics::tools::setSimdLevel(supported);
+}
+
+TEST_CASE("haptics::tools::mixClamped") {
+  const size_t count = 1003;
+  const size_t channels = 3;
+  std::mt19937 generator(13); // NOLINT
+  std::uniform_real_distribution<double> distribution(-.9, .9);
+  std::vector<std::vector<double>> in(4, std::vector<double>(count));
+  for (std::vector<double> &signal : in) {
+    for (double &sample : signal) {
+      sample = distribution(generator);
+    }
+  }
+  // Samples rounded halfway between two 16 bits values, and out of range ones
+  in[0][5] = 100.5 / haptics::tools::SCALING;
+  in[0][6] = -100.5 / haptics::tools::SCALING;
+  in[0][7] = -1;
+  in[0][8] = 1;
+  for (size_t s = 1; s < in.size(); s++) {
+    for (size_t i = 5; i < 9; i++) {
+      in[s][i] = 0;
+    }
+  }
+  const std::vector<const double *> data = {in[0].data(), in[1].data(), in[2].data(),
+                                            in[3].data()};
+  const SimdLevel supported = haptics::tools::getSupportedSimdLevel();
+
+  for (int level = 0; level <= static_cast<int>(supported); level++) {
+    haptics::tools::setSimdLevel(static_cast<SimdLevel>(level));
+    for (double gain : {1.0, .37, 1.8}) {
+      std::vector<double> out(count);
+      haptics::tools::mixClamped(data.data(), data.size(), gain, out.data(), count);
+      std::vector<int16_t> frames(count * channels);
+      haptics::tools::mixClampedQuantized(data.data(), data.size(), gain, frames.data() + 1,
+                                          channels, count);
+      for (size_t i = 0; i < count; i++) {
+        const double expected = referenceMix(in, i, gain);
+        REQUIRE(out[i] == expected);
+        REQUIRE(frames[i * channels] == 0);
+        REQUIRE(frames[i * channels + 1] ==
+                static_cast<int16_t>(haptics::tools::WavParser::quantize(expected)));
+      }
+    }
+    std::vector<double> empty(2, 1);
+    haptics::tools::mixClamped(data.data(), 0, 1, empty.data(), empty.size());
+    CHECK(empty == std::vector<double>(2, 0));
+  }
+  haptics::tools::setSimdLevel(supported);
+}
+
+TEST_CASE("haptics::tools::mixClamped in single precision") {
+  const size_t count = 1003;
+  const size_t channels = 2;
+  std::mt19937 generator(17); // NOLINT
+  std::uniform_real_distribution<float> distribution(-.9F, .9F);
+  std::vector<std::vector<float>> in(3, std::vector<float>(count));
+  for (std::vector<float> &signal : in) {
+    for (float &sample : signal) {
+      sample = distribution(generator);
+    }
+  }
+  in[0][5] = 1.5F;
+  in[0][6] = -1.5F;
+  const std::vector<const float *> data = {in[0].data(), in[1].data(), in[2].data()};
+  const SimdLevel supported = haptics::tools::getSupportedSimdLevel();
+
+  for (int level = 0; level <= static_cast<int>(supported); level++) {
+    haptics::tools::setSimdLevel(static_cast<SimdLevel>(level));
+    for (size_t offset : {0, 1, 5}) {
+      std::vector<float> out = in[1];
+      haptics::tools::addClamped(in[0].data() + offset, out.data() + offset, count - offset);
+      for (size_t i = 0; i < count; i++) {
+        REQUIRE(out[i] ==
+                (i < offset ? in[1][i] : std::clamp(in[1][i] + in[0][i], -1.0F, 1.0F)));
+      }
+    }
+    for (double gain : {1.0, .37, 1.8}) {
+      std::vector<int16_t> frames(count * channels);
+      haptics::tools::mixClampedQuantized(data.data(), data.size(), gain, frames.data() + 1,
+                                          channels, count);
+      for (size_t i = 0; i < count; i++) {
+        float mix = 0;
+        for (const std::vector<float> &signal : in) {
+          mix = std::clamp(mix + signal[i], -1.0F, 1.0F);
+        }
+        const double expected = static_cast<double>(mix) * gain;
+        REQUIRE(frames[i * channels] == 0);
+        REQUIRE(frames[i * channels + 1] ==
+                static_cast<int16_t>(haptics::tools::WavParser::quantize(expected)));
+      }
+    }
+  }
+  haptics::tools::setSimdLevel(supported);
+}
+
+TEST_CASE("haptics::tools::decibelsToPower") {
+  const size_t count = 20003;
+  std::mt19937 generator(17); // NOLINT
+  std::uniform_real_distribution<double> distribution(-1000, 1000);
+  std::vector<double> in(count);
+  for (double &level : in) {
+    level = distribution(generator);
+  }
+  // Levels around the limits of the range of normal numbers, and special values
+  const std::vector<double> special = {0,
+                                       -3076.5,
+                                       -3076.6,
+                                       3079.5,
+                                       3079.6,
+                                       -4000,
+                                       4000,
+                                       -std::numeric_limits<double>::infinity(),
+                                       std::numeric_limits<double>::infinity(),
+                                       std::numeric_limits<double>::quiet_NaN()};
+  std::copy(special.begin(), special.end(), in.begin());
+  const SimdLevel supported = haptics::tools::getSupportedSimdLevel();
+
+  haptics::tools::setSimdLevel(SimdLevel::Scalar);
+  std::vector<double> reference(count);
+  haptics::tools::decibelsToPower(in.data(), reference.data(), count);
+  for (size_t i = 0; i < count; i++) {
+    const double expected = std::pow(10, in[i] / 10); // NOLINT
+    if (std::abs(in[i]) <= 1000) { // NOLINT
+      REQUIRE(std::abs(reference[i] - expected) <=
+              haptics::tools::DECIBEL_CONVERSION_ERROR * expected);
+    }
+  }
+  CHECK(reference[0] == 1);
+  CHECK(reference[5] == 0);
+  CHECK(std::isinf(reference[6]));
+  CHECK(reference[7] == 0);
+  CHECK(std::isinf(reference[8]));
+  CHECK(std::isnan(reference[9]));
+
+  for (int level = 1; level <= static_cast<int>(supported); level++) {
+    haptics::tools::setSimdLevel(static_cast<SimdLevel>(level));
+    for (size_t offset : {0, 1, 3}) {
+      std::vector<double> out(count, -1);
+      haptics::tools::decibelsToPower(in.data() + offset, out.data() + offset, count - offset);
+      for (size_t i = offset; i < count; i++) {
+        REQUIRE((out[i] == reference[i] || (std::isnan(out[i]) && std::isnan(reference[i]))));
+      }
+    }
+  }
+  haptics::tools::setSimdLevel(supported);
+}
+
+TEST_CASE("haptics::tools::computeParabolaEnvelope") {
+  const size_t count = 1003;
+  std::mt19937 generator(19); // NOLINT
+  std::uniform_real_distribution<double> distribution(0, 1000);
+  std::vector<double> x(count);
+  for (double &position : x) {
+    position = distribution(generator);
+  }
+  const std::vector<double> center = {120, 40, 700, 701, 350};
+  const std::vector<double> curvature = {-1e-3, -2e-2, -5e-5, -5e-5, -1e-4};
+  const std::vector<double> offset = {30, 45, 12, 12.5, 20};
+  haptics::tools::Parabolas parabolas{center.data(), curvature.data(), offset.data(),
+                                      center.size()};
+  const SimdLevel supported = haptics::tools::getSupportedSimdLevel();
+
+  for (int level = 0; level <= static_cast<int>(supported); level++) {
+    haptics::tools::setSimdLevel(static_cast<SimdLevel>(level));
+    for (size_t offsetIndex : {0, 1, 3}) {
+      std::vector<double> out(count, -1);
+      haptics::tools::computeParabolaEnvelope(x.data() + offsetIndex, parabolas,
+                                              out.data() + offsetIndex, count - offsetIndex);
+      for (size_t i = 0; i < count; i++) {
+        double expected = -1;
+        for (size_t p = 0; i >= offsetIndex && p < center.size(); p++) {
+          double value = x[i] - center[p];
+          value *= value;
+          value *= curvature[p];
+          value += offset[p];
+          if (p == 0 || value > expected) {
+            expected = value;
+          }
+        }
+        REQUIRE(out[i] == expected);
+      }
+    }
+
+    // A NaN of the first parabola is kept, the following ones are ignored
+    const std::vector<double> nanOffset = {std::numeric_limits<double>::quiet_NaN(), 0};
+    const std::vector<double> twoCenters = {0, std::numeric_limits<double>::quiet_NaN()};
+    haptics::tools::Parabolas nanParabolas{twoCenters.data(), curvature.data(), nanOffset.data(),
+                                           2};
+    std::vector<double> out(7);
+    haptics::tools::computeParabolaEnvelope(x.data(), nanParabolas, out.data(), out.size());
+    CHECK(std::all_of(out.begin(), out.end(), [](double value) { return std::isnan(value); }));
+    const std::vector<double> nanCenter = {std::numeric_limits<double>::quiet_NaN(), 0};
+    nanParabolas = {nanCenter.data(), curvature.data(), offset.data(), 2};
+    haptics::tools::computeParabolaEnvelope(x.data(), nanParabolas, out.data(), out.size());
+    CHECK(std::all_of(out.begin(), out.end(), [](double value) { return std::isnan(value); }));
+
+    parabolas.count = 0;
+    std::vector<double> untouched(3, 2);
+    haptics::tools::computeParabolaEnvelope(x.data(), parabolas, untouched.data(), 3);
+    CHECK(untouched == std::vector<double>(3, 2));
+    parabolas.count = center.size();
+  }
+  haptics::tools::setSimdLevel(supported);
+}
@@ -0,0 +1,87 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <Tools/include/ThreadPool.h>
+#include <stdexcept>
+
+using haptics::tools::ThreadPool;
+
+TEST_CASE("ThreadPool::parallelFor") {
+  const size_t taskCount = 1000;
+
+  SECTION("every task is executed once") {
+    for (size_t threadCount : {0, 1, 2, 4}) {
+      ThreadPool pool(threadCount);
+      CHECK(pool.getThreadCount() == std::max<size_t>(threadCount, 1));
+      std::vector<std::atomic<int>> calls(taskCount);
+      pool.parallelFor(taskCount, [&](size_t i) { calls[i]++; });
+      for (size_t i = 0; i < taskCount; i++) {
+        CHECK(calls[i] == 1);
+      }
+    }
+  }
+
+  SECTION("pool reused for several batches") {
+    ThreadPool pool(3);
+    std::atomic<size_t> sum = 0;
+    for (int batch = 0; batch < 50; batch++) {
+      pool.parallelFor(taskCount, [&](size_t i) { sum += i; });
+    }
+    CHECK(sum == 50 * taskCount * (taskCount - 1) / 2);
+  }
+
+  SECTION("nested calls") {
+    ThreadPool pool(4);
+    std::atomic<size_t> calls = 0;
+    pool.parallelFor(8, [&](size_t /*unused*/) {
+      pool.parallelFor(100, [&](size_t /*unused*/) { calls++; });
+    });
+    CHECK(calls == 800);
+  }
+
+  SECTION("exception") {
+    ThreadPool pool(4);
+    std::atomic<size_t> calls = 0;
+    CHECK_THROWS_AS(pool.parallelFor(taskCount,
+                                     [&](size_t i) {
+                                       calls++;
+                                       if (i == 3) {
+                                         throw std::runtime_error("task failed");
+                                       }
+                                     }),
+                    std::runtime_error);
+    CHECK(calls == taskCount);
+  }
+}
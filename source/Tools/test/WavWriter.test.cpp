@@ -0,0 +1,104 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <Tools/include/WavParser.h>
+#include <Tools/include/WavWriter.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+TEST_CASE("haptics::tools::WavWriter") {
+
+  using haptics::tools::WavParser;
+  using haptics::tools::WavWriter;
+
+  const int fs = 8000;
+  const size_t sampleCount = 1000;
+  std::vector<std::vector<double>> buffer(2, std::vector<double>(sampleCount));
+  for (size_t i = 0; i < sampleCount; i++) {
+    buffer[0][i] = std::sin(static_cast<double>(i) * .01);
+    buffer[1][i] = 1.2 * std::cos(static_cast<double>(i) * .03);
+  }
+
+  SECTION("Incremental writing") {
+    std::string filename = "test_incremental.wav";
+    std::string referenceFilename = "test_reference.wav";
+    WavParser::saveFile(referenceFilename, buffer, fs);
+
+    WavWriter wavWriter;
+    REQUIRE(wavWriter.open(filename, buffer.size(), fs));
+    CHECK(wavWriter.isOpen());
+    const size_t chunkLength = 300;
+    std::vector<std::vector<double>> chunk(buffer.size(), std::vector<double>(chunkLength));
+    for (size_t first = 0; first < sampleCount; first += chunkLength) {
+      const size_t length = std::min(chunkLength, sampleCount - first);
+      for (size_t c = 0; c < buffer.size(); c++) {
+        std::copy(buffer[c].begin() + static_cast<long>(first),
+                  buffer[c].begin() + static_cast<long>(first + length), chunk[c].begin());
+      }
+      CHECK(wavWriter.writeFrames(chunk, length));
+    }
+    CHECK(wavWriter.close());
+    CHECK_FALSE(wavWriter.isOpen());
+
+    std::ifstream file(filename, std::ios::binary);
+    std::ifstream referenceFile(referenceFilename, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+    std::vector<char> referenceBytes((std::istreambuf_iterator<char>(referenceFile)),
+                                     std::istreambuf_iterator<char>());
+    CHECK(bytes == referenceBytes);
+
+    WavParser wavParser;
+    REQUIRE(wavParser.loadFile(filename));
+    CHECK(wavParser.getNumChannels() == buffer.size());
+    CHECK(wavParser.getNumSamples() == buffer.size() * sampleCount);
+    std::filesystem::remove(filename);
+    std::filesystem::remove(referenceFilename);
+  }
+
+  SECTION("Invalid frames") {
+    std::string filename = "test_invalid.wav";
+    WavWriter wavWriter;
+    CHECK_FALSE(wavWriter.writeFrames(buffer, sampleCount));
+    REQUIRE(wavWriter.open(filename, buffer.size(), fs));
+    CHECK_FALSE(wavWriter.open(filename, buffer.size(), fs));
+    CHECK_FALSE(wavWriter.writeFrames({buffer[0]}, sampleCount));
+    CHECK_FALSE(wavWriter.writeFrames(buffer, sampleCount + 1));
+    CHECK(wavWriter.close());
+    std::filesystem::remove(filename);
+  }
+}
@@ -37,6 +37,9 @@
 #include <Types/include/BandType.h>
 #include <Types/include/CurveType.h>
 #include <Types/include/Effect.h>
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <vector>
 
 namespace haptics::types {
@@ -84,7 +87,15 @@ public:
   [[nodiscard]] auto getLowerFrequencyLimit() const -> int;
   auto setLowerFrequencyLimit(int newLowerFrequencyLimit) -> void;
   auto getEffectsSize() -> size_t;
+  // The returned effect may be modified, the index of the effects being rebuilt on the next
+  // evaluation
   auto getEffectAt(int index) -> haptics::types::Effect &;
+  [[nodiscard]] auto getEffectAt(int index) const -> const haptics::types::Effect &;
+  // Decoded samples and bitstream of the wavelet effect at index, which keep the index of the
+  // effects: decoding or releasing the samples of an encoded block does not change its extent.
+  // The samples of an effect without bitstream must keep their size.
+  auto getWaveletSamplesAt(int index) -> std::vector<double> &;
+  auto getWaveletBitstreamAt(int index) -> std::vector<unsigned char> &;
   auto addEffect(haptics::types::Effect &newEffect) -> void;
   auto replaceEffectAt(int index, haptics::types::Effect &newEffect) -> bool;
   auto removeEffectAt(int index) -> bool;
@@ -93,16 +104,69 @@ public:
                 unsigned int timescale) -> double;
   auto EvaluationBand(uint32_t sampleCount, int fs, int pad, unsigned int timescale)
       -> std::vector<double>;
+  // Evaluates the samples [firstSample, firstSample + bandAmp.size()) of the band into bandAmp.
+  // Rendering a signal chunk by chunk gives the same samples as rendering it at once. No memory is
+  // allocated once the band has been evaluated on a chunk of this size. The samples are summed in
+  // double or in single precision, as given by bandAmp, the positions and the phases of the
+  // effects being computed in double precision in both cases.
+  template <typename T>
+  auto EvaluationBand(uint32_t firstSample, int fs, int pad, unsigned int timescale,
+                      std::vector<T> &bandAmp) -> void;
+  // Evaluates the band on the samples of the window [startTick, endTick), the signal being sampled
+  // at fs from position 0. Only the effects overlapping the window are evaluated, the samples being
+  // the same as the corresponding samples of EvaluationBand.
+  auto renderRange(double startTick, double endTick, int fs, unsigned int timescale)
+      -> std::vector<double>;
+  // First sample and number of samples of the window [startTick, endTick)
+  [[nodiscard]] auto static getRangeSamples(double startTick, double endTick, int fs,
+                                            unsigned int timescale)
+      -> std::pair<uint32_t, uint32_t>;
   auto getBandTimeLength(unsigned int timescale) -> double;
+  auto getEffectsInWindow(double startPosition, double endPosition, unsigned int timescale,
+                          std::vector<int> &indices) -> void;
+  // Ticks on each side of a window rendered at fs whose wavelet samples contribute to it, when
+  // they are resampled. The wavelet blocks to decode for the window are those of the widened one.
+  [[nodiscard]] auto getWaveletWindowMargin(int fs, unsigned int timescale) const -> double;
+  // Samples of the library effect id rendered at fs for this band, starting at the effect
+  // position. They are added to the band at every Reference effect to this library effect.
+  // Reference effects without rendered samples are silent.
+  auto setReferenceRender(int id, int fs, std::shared_ptr<const std::vector<double>> samples)
+      -> void;
+  auto clearReferenceRenders() -> void;
+  [[nodiscard]] auto getReferenceRender(int id) const -> const std::vector<double> *;
+  // Cutoff frequency of the low-pass filter run over the decoded samples of a wavelet band, when
+  // the band is adapted to a device. It is applied by the wavelet decoder, as the blocks are
+  // decoded, and is not part of the file.
+  [[nodiscard]] auto getWaveletLowPassFrequency() const -> std::optional<double>;
+  auto setWaveletLowPassFrequency(std::optional<double> newWaveletLowPassFrequency) -> void;
   //[[nodiscard]] auto getTimescale() const -> int;
   // auto setTimescale(int newTimescale) -> void;
 
   static constexpr double TRANSIENT_DURATION_MS = 22;
 
 private:
+  struct EffectInterval {
+    double start;
+    double end;
+    int index;
+  };
+
   [[nodiscard]] auto static getTransientDuration(unsigned int timescale) -> double;
+  auto getEffectEndPosition(Effect &effect, unsigned int timescale) -> double;
+  auto updateEffectIntervals(unsigned int timescale) -> void;
+  auto updateTransientKernel(int fs, unsigned int timescale) -> void;
+  auto updateResamplingKernel(int fs) -> void;
+  template <typename T>
+  auto mixReference(Effect &effect, uint32_t firstSample, int fs, int pad, unsigned int timescale,
+                    std::vector<T> &bandAmp) -> void;
+  // Index of the sample nearest to the given position, in ticks
+  [[nodiscard]] auto static getSampleIndex(double position, int fs, int pad,
+                                           unsigned int timescale) -> int64_t;
   static constexpr CurveType DEFAULT_CURVE_TYPE = CurveType::Unknown;
   static constexpr int DEFAULT_BLOCK_LENGTH = 0;
+  static constexpr double BLACKMAN_A0 = 0.42;
+  static constexpr double BLACKMAN_A1 = 0.5;
+  static constexpr double BLACKMAN_A2 = 0.08;
   auto EvaluationSwitch(double position, haptics::types::Effect *effect, int lowFrequencyLimit,
                         int highFrequencyLimit, unsigned int timescale) -> double;
 
@@ -112,6 +176,27 @@ private:
   int lowerFrequencyLimit = 0;
   int upperFrequencyLimit = 0;
   std::vector<Effect> effects = std::vector<Effect>{};
+  // Interval index over the effects, sorted by start position (in ticks). It is built for a given
+  // timescale and invalidated when effects are added, replaced, removed or accessed for
+  // modification, and when the band settings change.
+  std::vector<EffectInterval> effectIntervals = std::vector<EffectInterval>{};
+  std::vector<double> effectIntervalsMaxEnd = std::vector<double>{};
+  std::optional<unsigned int> effectIntervalsTimescale = std::nullopt;
+  // Library effects rendered for this band, by effect id
+  std::map<int, std::shared_ptr<const std::vector<double>>> referenceRenders;
+  int referenceRendersFs = 0;
+  std::optional<double> waveletLowPassFrequency = std::nullopt;
+  // Transient waveform, built once per sampling frequency and timescale
+  TransientKernel transientKernel;
+  // Resampling kernel of the wavelet samples, built once per sampling frequency
+  ResamplingKernel resamplingKernel;
+  // Buffers reused from one evaluation to the next, so that evaluating a band repeatedly on chunks
+  // of the same size does not allocate memory
+  std::vector<double> evaluationPositions = std::vector<double>{};
+  std::vector<int> evaluationEffects = std::vector<int>{};
+  std::vector<double> evaluationEffectAmp = std::vector<double>{};
+  std::vector<std::pair<int, double>> evaluationKeyframes = std::vector<std::pair<int, double>>{};
+  std::vector<double> evaluationCurveCoefficients = std::vector<double>{};
   // int timescale = TIMESCALE;
   std::optional<int> priority;
 };
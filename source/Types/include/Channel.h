@@ -108,6 +108,14 @@ public:
   auto Evaluate(double position, unsigned int timescale) -> double;
   auto EvaluateChannel(uint32_t sampleCount, int fs, int pad, unsigned int timescale)
       -> std::vector<double>;
+  // Window version of EvaluateChannel, see Band::renderRange
+  auto renderRange(double startTick, double endTick, int fs, unsigned int timescale)
+      -> std::vector<double>;
+  // Adds a band signal to the channel signal, clamping the result to [-1, 1]. Bands must be mixed
+  // in their order in the channel to get the output of EvaluateChannel. Signals are either in
+  // double or in single precision.
+  template <typename T>
+  auto static mixBand(std::vector<T> &channelAmp, const std::vector<T> &bandAmp) -> void;
   [[nodiscard]] auto getFrequencySampling() const -> std::optional<uint32_t>;
   auto setFrequencySampling(std::optional<uint32_t> newFrequencySampling) -> void;
   [[nodiscard]] auto getSampleCount() const -> std::optional<uint32_t>;
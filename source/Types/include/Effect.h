@@ -38,6 +38,7 @@
 #include <Types/include/CurveType.h>
 #include <Types/include/EffectSemantic.h>
 #include <Types/include/Keyframe.h>
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -73,6 +74,30 @@ static const std::map<EffectType, std::string> effectTypeToString = {
     {EffectType::Reference, "Reference"},
     {EffectType::Composite, "Composite"}};
 
+// Transient waveform sampled for a sampling frequency and a timescale. sine[k] and cosine[k] hold
+// the sine and cosine of the phase reached by the transient k samples after its start.
+struct TransientKernel {
+  int fs = 0;
+  unsigned int timescale = 0;
+  double duration = 0; // in ticks
+  std::vector<double> sine;
+  std::vector<double> cosine;
+};
+
+// Windowed-sinc kernel resampling wavelet samples at fs to samplingFrequency. Its cutoff is the
+// Nyquist frequency of the lower of both rates, so that the samples are low-passed before being
+// downsampled. values[k] holds the kernel at k / STEPS wavelet samples from its center, up to
+// halfWidth wavelet samples.
+struct ResamplingKernel {
+  static constexpr int ZERO_CROSSINGS = 16;
+  static constexpr int STEPS = 512;
+
+  int fs = 0;
+  int samplingFrequency = 0;
+  double halfWidth = 0; // in wavelet samples
+  std::vector<double> values;
+};
+
 class Effect {
 public:
   explicit Effect() = default;
@@ -121,8 +146,26 @@ public:
   // Use Absolute position not relative
   auto EvaluateVectorial(double position, int lowFrequencyLimit, int highFrequencyLimit,
                          unsigned int timescale) -> double;
+  // Block version of EvaluateVectorial: out[i] receives the effect evaluated at the absolute
+  // position positions[first + i], for every i < out.size(). Positions must be increasing.
+  auto EvaluateVectorialBlock(const std::vector<double> &positions, size_t first,
+                              int lowFrequencyLimit, int highFrequencyLimit,
+                              unsigned int timescale, std::vector<double> &out) -> void;
   auto EvaluateWavelet(double position, int fs, unsigned int timescale) -> double;
+  // Block version of EvaluateWavelet: out[i] receives the effect evaluated at the absolute
+  // position positions[first + i], positions being sampled at kernel.samplingFrequency and the
+  // decoded samples at kernel.fs. The samples are copied as is when both rates are equal, and
+  // resampled with the kernel otherwise. A resampled effect spreads over kernel.halfWidth samples
+  // before and after it, so that the contributions of contiguous blocks join continuously.
+  auto EvaluateWaveletBlock(const std::vector<double> &positions, size_t first,
+                            const ResamplingKernel &kernel, unsigned int timescale,
+                            std::vector<double> &out) -> void;
   auto EvaluateTransient(double position, double transientDuration) -> double;
+  // Block version of EvaluateTransient: out[i] receives the effect evaluated on the sample
+  // firstSample + i of a signal sampled at kernel.fs and starting pad milliseconds before the
+  // origin. A copy of the kernel, scaled by the keyframe amplitude, is added at each keyframe.
+  auto EvaluateTransientBlock(uint32_t firstSample, int pad, const TransientKernel &kernel,
+                              std::vector<double> &out) -> void;
   auto EvaluateKeyframes(double position, types::CurveType curveType, unsigned int timescale)
       -> double;
 
@@ -134,6 +177,8 @@ public:
 private:
   static constexpr float DEFAULT_PHASE = 0;
   static constexpr BaseSignal DEFAULT_BASE_SIGNAL = BaseSignal::Sine;
+  static constexpr double WAVELET_INDEX_TOLERANCE = 1e-6;
+  static constexpr size_t VECTORIAL_BATCH_LENGTH = 256;
   int id = -1;
   int position = 0;
   std::optional<float> phase;
@@ -146,6 +191,8 @@ private:
   std::vector<unsigned char> waveletBitstream;
 
   [[nodiscard]] auto computeBaseSignal(double time, double frequency, double phase) const -> double;
+  [[nodiscard]] auto getFrequencyPhaseIncrement(int keyframeIndex, int previousKeyframeIndex) const
+      -> double;
 };
 } // namespace haptics::types
 
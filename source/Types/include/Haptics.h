@@ -87,6 +87,12 @@ public:
   auto loadMetadataFromOHM(haptics::tools::OHMData data) -> void;
   auto extractMetadataToOHM(std::string &filename) -> haptics::tools::OHMData;
   auto linearize() -> void;
+  auto renderLibrary(int fs) -> void;
+  // Renders the window [startTick, endTick) of every channel, sampled at fs, with the channel gain
+  // and the perception unit applied. Channels are given in the order of the perceptions. Wavelet
+  // bands must have been decoded, which can be restricted to the window with
+  // WaveletDecoder::transformBand.
+  auto renderRange(double startTick, double endTick, int fs) -> std::vector<std::vector<double>>;
   auto refactor() -> void;
 
 private:
@@ -155,6 +155,14 @@ public:
   auto searchForEquivalentEffects(Effect &effect, int startingChannel)
       -> std::vector<std::tuple<int, int, int>>;
   auto linearizeLibrary() -> void;
+  // Renders every library effect once for each kind of band referencing it, and gives the rendered
+  // samples to these bands. Reference effects can then be synthesized without linearizing the
+  // library.
+  auto renderLibrary(int fs, unsigned int timescale) -> void;
+  // Renders the library effect id alone, from position 0, in a band of the same type, curve type
+  // and frequency limits as band. Returns nothing if the library has no such effect.
+  auto renderLibraryEffect(int id, const Band &band, int fs, unsigned int timescale)
+      -> std::optional<std::vector<double>>;
   auto getEffectById(int id) -> std::optional<Effect>;
 
 private:
@@ -34,12 +34,20 @@
 #include <Tools/include/Tools.h>
 #include <Types/include/Band.h>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
 
 namespace haptics::types {
 
 [[nodiscard]] auto Band::getBandType() const -> BandType { return bandType; }
 
-auto Band::setBandType(BandType newBandType) -> void { bandType = newBandType; }
+auto Band::setBandType(BandType newBandType) -> void {
+  bandType = newBandType;
+  effectIntervalsTimescale.reset();
+}
 auto Band::getPriority() const -> std::optional<int> { return priority; }
 auto Band::getPriorityOrDefault() const -> int {
   if (priority.has_value()) {
@@ -68,12 +76,16 @@ auto Band::setCurveType(CurveType newCurveType) -> void { curveType = newCurveTy
 
 [[nodiscard]] auto Band::getBlockLength() const -> std::optional<int> { return blockLength; }
 
-auto Band::setBlockLength(int newBlockLength) -> void { blockLength = newBlockLength; }
+auto Band::setBlockLength(int newBlockLength) -> void {
+  blockLength = newBlockLength;
+  effectIntervalsTimescale.reset();
+}
 
 [[nodiscard]] auto Band::getUpperFrequencyLimit() const -> int { return upperFrequencyLimit; }
 
 auto Band::setUpperFrequencyLimit(int newUpperFrequencyLimit) -> void {
   upperFrequencyLimit = newUpperFrequencyLimit;
+  effectIntervalsTimescale.reset();
 }
 
 [[nodiscard]] auto Band::getLowerFrequencyLimit() const -> int { return lowerFrequencyLimit; }
@@ -84,7 +96,23 @@ auto Band::setLowerFrequencyLimit(int newLowerFrequencyLimit) -> void {
 
 auto Band::getEffectsSize() -> size_t { return effects.size(); }
 
-auto Band::getEffectAt(int index) -> haptics::types::Effect & { return effects.at(index); }
+auto Band::getEffectAt(int index) -> haptics::types::Effect & {
+  // The returned effect may be moved or resized by the caller
+  effectIntervalsTimescale.reset();
+  return effects.at(index);
+}
+
+[[nodiscard]] auto Band::getEffectAt(int index) const -> const haptics::types::Effect & {
+  return effects.at(index);
+}
+
+auto Band::getWaveletSamplesAt(int index) -> std::vector<double> & {
+  return effects.at(index).getWaveletSamples();
+}
+
+auto Band::getWaveletBitstreamAt(int index) -> std::vector<unsigned char> & {
+  return effects.at(index).getWaveletBitstream();
+}
 
 auto Band::addEffect(Effect &newEffect) -> void {
   auto it = std::find_if(effects.begin(), effects.end(), [newEffect](Effect &e) {
@@ -92,6 +120,7 @@ auto Band::addEffect(Effect &newEffect) -> void {
   });
 
   effects.insert(it, newEffect);
+  effectIntervalsTimescale.reset();
 }
 
 auto Band::replaceEffectAt(int index, haptics::types::Effect &newEffect) -> bool {
@@ -99,6 +128,7 @@ auto Band::replaceEffectAt(int index, haptics::types::Effect &newEffect) -> bool
     return false;
   }
   this->effects[index] = newEffect;
+  effectIntervalsTimescale.reset();
   return true;
 }
 
@@ -107,6 +137,7 @@ auto Band::removeEffectAt(int index) -> bool {
     return false;
   }
   this->effects.erase(this->effects.begin() + index);
+  effectIntervalsTimescale.reset();
   return true;
 }
 
@@ -171,100 +202,376 @@ auto Band::EvaluationSwitch(double position, haptics::types::Effect *effect, int
 auto Band::EvaluationBand(uint32_t sampleCount, int fs, int pad, unsigned int timescale)
     -> std::vector<double> { // TODO: check impact of pad (which is in ms)
   std::vector<double> bandAmp(sampleCount, 0);
+  EvaluationBand(0, fs, pad, timescale, bandAmp);
+  return bandAmp;
+}
+
+template <typename T>
+auto Band::EvaluationBand(uint32_t firstSample, int fs, int pad, unsigned int timescale,
+                          std::vector<T> &bandAmp) -> void {
+  std::fill(bandAmp.begin(), bandAmp.end(), T(0));
+  const auto sampleCount = static_cast<uint32_t>(bandAmp.size());
   switch (this->bandType) {
-  case BandType::Curve:
-    for (auto e : effects) {
-      std::vector<std::pair<int, double>> keyframes(
-          e.getKeyframesSize()); // keyframes converted to position relative to fs
-      for (int i = 0; i < static_cast<int>(e.getKeyframesSize()); i++) {
-        types::Keyframe myKeyframe;
-        myKeyframe = e.getKeyframeAt(i);
-        keyframes[i].first = static_cast<int>(myKeyframe.getRelativePosition().value() * fs /
-                                              timescale); // assuming position in ticks as input
-        if (i > 0) {
-          keyframes[i].first -= keyframes[0].first;
-        }
-        keyframes[i].second = myKeyframe.getAmplitudeModulation().value();
+  case BandType::Curve: {
+    if (sampleCount == 0) {
+      break;
+    }
+    // The window is widened by one sample on each side, as curves start on the nearest sample
+    const double sampleLength = timescale / static_cast<double>(fs);
+    const double windowStart =
+        timescale * (static_cast<double>(firstSample) / fs - pad * MS_2_S) - sampleLength;
+    std::vector<int> &activeEffects = evaluationEffects;
+    getEffectsInWindow(windowStart, windowStart + (sampleCount + 1) * sampleLength, timescale,
+                       activeEffects);
+    std::vector<std::pair<int, double>> &keyframes = evaluationKeyframes;
+    for (int index : activeEffects) {
+      Effect &effect = effects[index];
+      if (effect.getEffectType() == EffectType::Reference) {
+        mixReference(effect, firstSample, fs, pad, timescale, bandAmp);
+        continue;
       }
-      keyframes[0].first = 0;
-      std::vector<double> effectAmp(static_cast<::std::size_t>(keyframes.back().first) + 1, 0);
-      if (keyframes.size() == 2) {
-        effectAmp = haptics::tools::linearInterpolation2(keyframes);
-      } else {
-        switch (getCurveTypeOrDefault()) {
-        case CurveType::Linear:
-          effectAmp = haptics::tools::linearInterpolation2(keyframes);
-          break;
-        case CurveType::Cubic:
-          effectAmp = haptics::tools::cubicInterpolation2(keyframes);
-          break;
-        case CurveType::Akima:
-          effectAmp = haptics::tools::akimaInterpolation(keyframes);
-          break;
-        case CurveType::Bezier:
-          effectAmp = haptics::tools::bezierInterpolation(keyframes);
-          break;
-        case CurveType::Bspline:
-          effectAmp = haptics::tools::bsplineInterpolation(keyframes);
-          break;
-        default:
-          effectAmp = haptics::tools::cubicInterpolation2(keyframes);
-          break;
+      // keyframes converted to samples relative to fs, from the first keyframe
+      keyframes.clear();
+      double origin = 0;
+      for (int i = 0; i < static_cast<int>(effect.getKeyframesSize()); i++) {
+        Keyframe &keyframe = effect.getKeyframeAt(i);
+        if (!keyframe.getRelativePosition().has_value() ||
+            !keyframe.getAmplitudeModulation().has_value()) {
+          continue;
         }
-
-        int count = 0;
-        int position =
-            static_cast<int>((e.getPosition() + pad) * fs *
-                             timescale); // position converted from ticks to samples rel. to fs
-        if (position < 0) {
-          count = -position;
-          position = 0;
+        if (keyframes.empty()) {
+          origin = keyframe.getRelativePosition().value();
         }
-        for (int i = position;
-             (i < static_cast<int>(sampleCount)) && (count <= keyframes.back().first); i++) {
-          bandAmp[i] += effectAmp[count];
-          count++;
+        const auto position = static_cast<int>((keyframe.getRelativePosition().value() - origin) *
+                                               fs / static_cast<double>(timescale));
+        if (!keyframes.empty() && position <= keyframes.back().first) {
+          continue; // only the first of several keyframes on the same sample is kept
+        }
+        keyframes.emplace_back(position, keyframe.getAmplitudeModulation().value());
+      }
+      if (keyframes.empty()) {
+        continue;
+      }
+      const int64_t start = getSampleIndex(effect.getPosition() + origin, fs, pad, timescale);
+      const int64_t first = static_cast<int64_t>(firstSample) - start;
+      if (first > keyframes.back().first || first + sampleCount <= 0) {
+        continue; // the effect does not overlap the evaluated samples
+      }
+      haptics::tools::curveCoefficients(keyframes, getCurveTypeOrDefault(),
+                                        evaluationCurveCoefficients);
+      if constexpr (std::is_same_v<T, double>) {
+        haptics::tools::curveInterpolationBlock(keyframes, getCurveTypeOrDefault(),
+                                                evaluationCurveCoefficients,
+                                                static_cast<int>(first), bandAmp.data(),
+                                                bandAmp.size());
+      } else {
+        // The curve is interpolated in double precision, then added to the band
+        std::vector<double> &effectAmp = evaluationEffectAmp;
+        effectAmp.assign(sampleCount, 0);
+        haptics::tools::curveInterpolationBlock(keyframes, getCurveTypeOrDefault(),
+                                                evaluationCurveCoefficients,
+                                                static_cast<int>(first), effectAmp.data(),
+                                                effectAmp.size());
+        for (uint32_t i = 0; i < sampleCount; i++) {
+          bandAmp[i] += static_cast<T>(effectAmp[i]);
         }
       }
     }
     break;
-  default:
+  }
+  default: {
+    if (sampleCount == 0) {
+      break;
+    }
+    std::vector<double> &positions = evaluationPositions;
+    positions.resize(sampleCount);
+    // Positions in ticks, computed from the offset of the samples from the origin of the timeline
+    // so that they do not depend on the padding
+    const double padSamples = pad * fs * MS_2_S;
     for (uint32_t ti = 0; ti < sampleCount; ti++) {
-      double position = timescale * (static_cast<double>(ti) / static_cast<double>(fs) -
-                                     (pad * MS_2_S)); // position in ticks needed
-      if (effects.empty() ||
-          ((position > effects.back().getPosition() +
-                           effects.back().getEffectTimeLength(
-                               bandType, Band::getTransientDuration(timescale)) ||
-            position < 0) &&
-           (this->bandType != types::BandType::WaveletWave))) {
-        bandAmp[ti] = 0;
-      } // TODO: TRANSIENT_DURATION_MS: should it be transformed to ticks?
-
-      for (auto it = effects.end() - 1; it >= effects.begin(); it--) {
-        if (it->getPosition() <= position) {
-          bandAmp[ti] +=
-              EvaluationSwitch(position, &*it, lowerFrequencyLimit, upperFrequencyLimit, timescale);
-        }
-        if (it == effects.begin()) {
-          break;
+      positions[ti] = timescale * ((static_cast<double>(firstSample + ti) - padSamples) / fs);
+    }
+
+    // Effects are evaluated one after the other, in decreasing index order, on the samples where
+    // they are active only. Each sample therefore accumulates the same contributions, in the same
+    // order, as when every effect starting before it is evaluated.
+    if (this->bandType == BandType::Transient) {
+      updateTransientKernel(fs, timescale);
+    }
+    // Resampled wavelet effects spread over the margin on each side
+    double margin = 0;
+    if (this->bandType == BandType::WaveletWave) {
+      updateResamplingKernel(fs);
+      margin = getWaveletWindowMargin(fs, timescale);
+    }
+    std::vector<int> &activeEffects = evaluationEffects;
+    std::vector<double> &effectAmp = evaluationEffectAmp;
+    getEffectsInWindow(positions.front() - margin, positions.back() + margin, timescale,
+                       activeEffects);
+    for (int index : activeEffects) {
+      Effect &effect = effects[index];
+      if (effect.getEffectType() == EffectType::Reference) {
+        mixReference(effect, firstSample, fs, pad, timescale, bandAmp);
+        continue;
+      }
+      const double endPosition = getEffectEndPosition(effect, timescale) + margin;
+      auto first = std::lower_bound(positions.begin(), positions.end(),
+                                    static_cast<double>(effect.getPosition()) - margin);
+      auto last = std::upper_bound(first, positions.end(), endPosition);
+      const auto offset = static_cast<size_t>(first - positions.begin());
+      effectAmp.resize(last - first);
+      switch (this->bandType) {
+      case BandType::VectorialWave:
+        // Vectorial effects are rendered segment by segment instead of sample by sample
+        effect.EvaluateVectorialBlock(positions, offset, lowerFrequencyLimit, upperFrequencyLimit,
+                                      timescale, effectAmp);
+        break;
+      case BandType::WaveletWave:
+        // Decoded wavelet blocks are copied, or resampled when fs differs from the band rate
+        effect.EvaluateWaveletBlock(positions, offset, resamplingKernel, timescale, effectAmp);
+        break;
+      case BandType::Transient:
+        effect.EvaluateTransientBlock(firstSample + static_cast<uint32_t>(offset), pad,
+                                      transientKernel, effectAmp);
+        break;
+      default:
+        for (size_t i = 0; i < effectAmp.size(); i++) {
+          effectAmp[i] = EvaluationSwitch(positions[offset + i], &effect, lowerFrequencyLimit,
+                                          upperFrequencyLimit, timescale);
         }
+        break;
+      }
+      for (size_t i = 0; i < effectAmp.size(); i++) {
+        bandAmp[offset + i] += static_cast<T>(effectAmp[i]);
       }
     }
     break;
   }
+  }
+}
+
+auto Band::renderRange(double startTick, double endTick, int fs, unsigned int timescale)
+    -> std::vector<double> {
+  const auto [firstSample, sampleCount] = getRangeSamples(startTick, endTick, fs, timescale);
+  std::vector<double> bandAmp(sampleCount, 0);
+  EvaluationBand(firstSample, fs, 0, timescale, bandAmp);
   return bandAmp;
 }
 
+auto Band::getRangeSamples(double startTick, double endTick, int fs, unsigned int timescale)
+    -> std::pair<uint32_t, uint32_t> {
+  auto sample = [fs, timescale](double position) {
+    return static_cast<uint32_t>(std::ceil(std::max(position, 0.0) * fs / timescale));
+  };
+  const uint32_t firstSample = sample(startTick);
+  const uint32_t endSample = sample(endTick);
+  return {firstSample, endSample > firstSample ? endSample - firstSample : 0};
+}
+
 auto Band::getBandTimeLength(unsigned int timescale) -> double {
   if (this->effects.empty()) {
     return 0;
   }
+  if (this->effects.back().getEffectType() == EffectType::Reference) {
+    return getEffectEndPosition(this->effects.back(), timescale);
+  }
   return this->effects.back().getPosition() +
          this->effects.back().getEffectTimeLength(this->getBandType(),
                                                   Band::getTransientDuration(timescale));
 }
 
+auto Band::setReferenceRender(int id, int fs, std::shared_ptr<const std::vector<double>> samples)
+    -> void {
+  if (fs != referenceRendersFs) {
+    referenceRenders.clear();
+    referenceRendersFs = fs;
+  }
+  referenceRenders[id] = std::move(samples);
+  effectIntervalsTimescale.reset();
+}
+
+auto Band::clearReferenceRenders() -> void {
+  referenceRenders.clear();
+  effectIntervalsTimescale.reset();
+}
+
+auto Band::getReferenceRender(int id) const -> const std::vector<double> * {
+  auto it = referenceRenders.find(id);
+  return it == referenceRenders.end() ? nullptr : it->second.get();
+}
+
+[[nodiscard]] auto Band::getWaveletLowPassFrequency() const -> std::optional<double> {
+  return waveletLowPassFrequency;
+}
+
+auto Band::setWaveletLowPassFrequency(std::optional<double> newWaveletLowPassFrequency) -> void {
+  waveletLowPassFrequency = newWaveletLowPassFrequency;
+}
+
+template <typename T>
+auto Band::mixReference(Effect &effect, uint32_t firstSample, int fs, int pad,
+                        unsigned int timescale, std::vector<T> &bandAmp) -> void {
+  const std::vector<double> *samples = getReferenceRender(effect.getId());
+  if (samples == nullptr || fs != referenceRendersFs) {
+    return;
+  }
+  const int64_t first =
+      static_cast<int64_t>(firstSample) - getSampleIndex(effect.getPosition(), fs, pad, timescale);
+  const int64_t begin = std::max<int64_t>(first, 0);
+  const int64_t end = std::min(first + static_cast<int64_t>(bandAmp.size()),
+                               static_cast<int64_t>(samples->size()));
+  for (int64_t k = begin; k < end; k++) {
+    bandAmp[static_cast<size_t>(k - first)] += static_cast<T>((*samples)[static_cast<size_t>(k)]);
+  }
+}
+
+auto Band::getSampleIndex(double position, int fs, int pad, unsigned int timescale) -> int64_t {
+  return static_cast<int64_t>(std::round((position / timescale + pad * MS_2_S) * fs));
+}
+
+auto Band::getEffectsInWindow(double startPosition, double endPosition, unsigned int timescale,
+                              std::vector<int> &indices) -> void {
+  indices.clear();
+  if (!effectIntervalsTimescale.has_value() || effectIntervalsTimescale.value() != timescale) {
+    updateEffectIntervals(timescale);
+  }
+
+  // Intervals starting after the window are skipped, then intervals are visited backward as long
+  // as one of the remaining intervals may still end inside the window
+  auto it = std::upper_bound(
+      effectIntervals.begin(), effectIntervals.end(), endPosition,
+      [](double position, const EffectInterval &interval) { return position < interval.start; });
+  for (auto k = it - effectIntervals.begin() - 1;
+       k >= 0 && effectIntervalsMaxEnd[k] >= startPosition; k--) {
+    if (effectIntervals[k].end >= startPosition) {
+      indices.push_back(effectIntervals[k].index);
+    }
+  }
+  std::sort(indices.begin(), indices.end(), std::greater<>());
+}
+
+auto Band::getEffectEndPosition(Effect &effect, unsigned int timescale) -> double {
+  if (effect.getEffectType() == EffectType::Reference) {
+    const std::vector<double> *samples = getReferenceRender(effect.getId());
+    if (samples == nullptr || samples->empty() || referenceRendersFs <= 0) {
+      return effect.getPosition();
+    }
+    return effect.getPosition() +
+           static_cast<double>(samples->size() - 1) * timescale / referenceRendersFs;
+  }
+  switch (bandType) {
+  case BandType::WaveletWave: {
+    if (upperFrequencyLimit <= 0) {
+      return effect.getPosition();
+    }
+    // Blocks still encoded, which a WaveletBlockCache decodes and releases at any time without
+    // invalidating the index, span the block length of the band whether their samples are decoded
+    // or not. It is rounded up as it is stored as an integer number of ticks.
+    double sampleCount = static_cast<double>(effect.getWaveletSamples().size());
+    if (!effect.getWaveletBitstream().empty()) {
+      sampleCount = std::max(sampleCount,
+                             std::ceil(static_cast<double>(getBlockLengthOrDefault() + 1) *
+                                       upperFrequencyLimit / timescale));
+    }
+    // one extra sample is kept to stay conservative with respect to rounding errors
+    return effect.getPosition() + (sampleCount + 1) * timescale / upperFrequencyLimit;
+  }
+  case BandType::Transient:
+    return effect.getPosition() +
+           effect.getEffectTimeLength(bandType, Band::getTransientDuration(timescale));
+  default:
+    return effect.getPosition() + effect.getEffectTimeLength(bandType, TRANSIENT_DURATION_MS);
+  }
+}
+
+auto Band::updateEffectIntervals(unsigned int timescale) -> void {
+  effectIntervals.clear();
+  effectIntervals.reserve(effects.size());
+  for (int i = 0; i < static_cast<int>(effects.size()); i++) {
+    effectIntervals.push_back(
+        {static_cast<double>(effects[i].getPosition()), getEffectEndPosition(effects[i], timescale),
+         i});
+  }
+  std::stable_sort(
+      effectIntervals.begin(), effectIntervals.end(),
+      [](const EffectInterval &a, const EffectInterval &b) { return a.start < b.start; });
+
+  effectIntervalsMaxEnd.resize(effectIntervals.size());
+  double maxEnd = -std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < effectIntervals.size(); i++) {
+    maxEnd = std::max(maxEnd, effectIntervals[i].end);
+    effectIntervalsMaxEnd[i] = maxEnd;
+  }
+  evaluationEffects.reserve(effects.size());
+  if (bandType == BandType::Curve) {
+    size_t keyframeCount = 0;
+    for (Effect &effect : effects) {
+      keyframeCount = std::max(keyframeCount, effect.getKeyframesSize());
+    }
+    evaluationKeyframes.reserve(keyframeCount);
+    evaluationCurveCoefficients.reserve(3 * keyframeCount);
+  }
+  effectIntervalsTimescale = timescale;
+}
+
+auto Band::updateTransientKernel(int fs, unsigned int timescale) -> void {
+  if (transientKernel.fs == fs && transientKernel.timescale == timescale) {
+    return;
+  }
+  transientKernel.fs = fs;
+  transientKernel.timescale = timescale;
+  transientKernel.duration = getTransientDuration(timescale);
+  // Phase increment of the transient between two samples
+  const double step = 4 * M_PI * timescale / (static_cast<double>(fs) * transientKernel.duration);
+  const auto length =
+      static_cast<size_t>(std::floor(transientKernel.duration * fs / timescale)) + 2;
+  transientKernel.sine.resize(length);
+  transientKernel.cosine.resize(length);
+  for (size_t k = 0; k < length; k++) {
+    transientKernel.sine[k] = std::sin(static_cast<double>(k) * step);
+    transientKernel.cosine[k] = std::cos(static_cast<double>(k) * step);
+  }
+}
+
+auto Band::updateResamplingKernel(int fs) -> void {
+  if (resamplingKernel.fs == upperFrequencyLimit && resamplingKernel.samplingFrequency == fs) {
+    return;
+  }
+  resamplingKernel.fs = upperFrequencyLimit;
+  resamplingKernel.samplingFrequency = fs;
+  resamplingKernel.halfWidth = 0;
+  resamplingKernel.values.clear();
+  if (fs == upperFrequencyLimit || fs <= 0 || upperFrequencyLimit <= 0) {
+    return;
+  }
+  // Blackman windowed sinc, whose cutoff is given relative to the Nyquist frequency of the band
+  const double cutoff = std::min(1.0, static_cast<double>(fs) / upperFrequencyLimit);
+  const double halfWidth = ResamplingKernel::ZERO_CROSSINGS / cutoff;
+  const auto length = static_cast<size_t>(std::floor(halfWidth * ResamplingKernel::STEPS)) + 2;
+  resamplingKernel.halfWidth = halfWidth;
+  resamplingKernel.values.assign(length, 0);
+  for (size_t k = 0; k + 1 < length; k++) {
+    const double t = static_cast<double>(k) / ResamplingKernel::STEPS;
+    if (t >= halfWidth) {
+      break;
+    }
+    const double x = M_PI * cutoff * t;
+    const double sinc = x == 0 ? 1 : std::sin(x) / x;
+    const double window = BLACKMAN_A0 + BLACKMAN_A1 * std::cos(M_PI * t / halfWidth) +
+                          BLACKMAN_A2 * std::cos(2 * M_PI * t / halfWidth);
+    resamplingKernel.values[k] = cutoff * sinc * window;
+  }
+}
+
+[[nodiscard]] auto Band::getWaveletWindowMargin(int fs, unsigned int timescale) const -> double {
+  if (bandType != BandType::WaveletWave || fs <= 0 || upperFrequencyLimit <= 0 ||
+      fs == upperFrequencyLimit) {
+    return 0;
+  }
+  const double cutoff = std::min(1.0, static_cast<double>(fs) / upperFrequencyLimit);
+  return ResamplingKernel::ZERO_CROSSINGS / cutoff * timescale / upperFrequencyLimit;
+}
+
 //[[nodiscard]] auto Band::getTimescale() const -> int { return this->timescale; }
 
 // auto Band::setTimescale(int newTimescale) -> void { timescale = newTimescale; }
@@ -273,4 +580,9 @@ auto Band::getBandTimeLength(unsigned int timescale) -> double {
   return TRANSIENT_DURATION_MS / static_cast<double>((double)TIMESCALE / timescale);
 }
 
+template auto Band::EvaluationBand(uint32_t firstSample, int fs, int pad, unsigned int timescale,
+                                   std::vector<double> &bandAmp) -> void;
+template auto Band::EvaluationBand(uint32_t firstSample, int fs, int pad, unsigned int timescale,
+                                   std::vector<float> &bandAmp) -> void;
+
 } // namespace haptics::types
@@ -31,6 +31,7 @@
  * THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <Tools/include/SignalKernels.h>
 #include <Types/include/Channel.h>
 
 namespace haptics::types {
@@ -190,19 +191,34 @@ auto Channel::EvaluateChannel(uint32_t sampleCount, int fs, int pad, unsigned in
   std::vector<double> channelAmp(sampleCount, 0); // intialiser � 0?
   for (haptics::types::Band &b : bands) {
     std::vector<double> bandAmp = b.EvaluationBand(sampleCount, fs, pad, timescale);
-    for (uint32_t i = 0; i < bandAmp.size(); i++) {
-      channelAmp[i] += bandAmp[i];
-      if (channelAmp[i] < -1) {
-        channelAmp[i] = -1;
-      }
-      if (channelAmp[i] > 1) {
-        channelAmp[i] = 1;
-      }
-    }
+    mixBand(channelAmp, bandAmp);
+  }
+  return channelAmp;
+}
+
+auto Channel::renderRange(double startTick, double endTick, int fs, unsigned int timescale)
+    -> std::vector<double> {
+  const auto [firstSample, sampleCount] =
+      Band::getRangeSamples(startTick, endTick, fs, timescale);
+  std::vector<double> channelAmp(sampleCount, 0);
+  std::vector<double> bandAmp(sampleCount, 0);
+  for (haptics::types::Band &b : bands) {
+    b.EvaluationBand(firstSample, fs, 0, timescale, bandAmp);
+    mixBand(channelAmp, bandAmp);
   }
   return channelAmp;
 }
 
+template <typename T>
+auto Channel::mixBand(std::vector<T> &channelAmp, const std::vector<T> &bandAmp) -> void {
+  tools::addClamped(bandAmp.data(), channelAmp.data(), bandAmp.size());
+}
+
+template auto Channel::mixBand(std::vector<double> &channelAmp,
+                               const std::vector<double> &bandAmp) -> void;
+template auto Channel::mixBand(std::vector<float> &channelAmp, const std::vector<float> &bandAmp)
+    -> void;
+
 [[nodiscard]] auto Channel::getFrequencySampling() const -> std::optional<uint32_t> {
   return frequencySampling;
 }
@@ -31,14 +31,33 @@
  * THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <Tools/include/SignalKernels.h>
 #include <Tools/include/Tools.h>
 #include <Types/include/Effect.h>
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <functional>
 
 namespace haptics::types {
 
+namespace {
+auto getWaveform(BaseSignal baseSignal) -> tools::Waveform {
+  switch (baseSignal) {
+  case BaseSignal::Square:
+    return tools::Waveform::Square;
+  case BaseSignal::Triangle:
+    return tools::Waveform::Triangle;
+  case BaseSignal::SawToothUp:
+    return tools::Waveform::SawToothUp;
+  case BaseSignal::SawToothDown:
+    return tools::Waveform::SawToothDown;
+  default:
+    return tools::Waveform::Sine;
+  }
+}
+} // namespace
+
 [[nodiscard]] auto Effect::getId() const -> int { return id; }
 auto Effect::setId(int newId) -> void { id = newId; }
 
@@ -298,18 +317,199 @@ auto Effect::EvaluateVectorial(double position, int lowFrequencyLimit, int highF
                                                   freq_modulation, phi);
 }
 
+auto Effect::EvaluateVectorialBlock(const std::vector<double> &positions, size_t first,
+                                    int lowFrequencyLimit, int highFrequencyLimit,
+                                    unsigned int timescale, std::vector<double> &out) -> void {
+  std::fill(out.begin(), out.end(), 0);
+  if (keyframes.empty()) {
+    return;
+  }
+  const double maxPosition =
+      this->position + this->getEffectTimeLength(BandType::VectorialWave, 0);
+  const auto keyframesCount = static_cast<int>(keyframes.size());
+  auto keyframePosition = [this](int index) {
+    return keyframes[index].getRelativePosition().value_or(0);
+  };
+
+  // The keyframes are walked once. For both modulations, the state is made of the first keyframe
+  // at or after the current relative position and of the last one before it. The phase is
+  // accumulated each time a frequency keyframe is passed.
+  int amplitudeAfter = 0;
+  int amplitudeBefore = -1;
+  int frequencyAfter = 0;
+  int frequencyBefore = -1;
+  double phi = this->getPhaseOrDefault();
+  const tools::Waveform waveform = getWaveform(this->getBaseSignalOrDefault());
+  std::array<double, VECTORIAL_BATCH_LENGTH> times{};
+  std::array<double, VECTORIAL_BATCH_LENGTH> frequencies{};
+  std::array<double, VECTORIAL_BATCH_LENGTH> amplitudes{};
+
+  size_t i = 0;
+  while (i < out.size()) {
+    const double relativePosition = positions[first + i] - this->position;
+    if (relativePosition < 0 || positions[first + i] > maxPosition) {
+      i++;
+      continue;
+    }
+    while (amplitudeAfter < keyframesCount &&
+           !(keyframes[amplitudeAfter].getAmplitudeModulation().has_value() &&
+             keyframes[amplitudeAfter].getRelativePosition().has_value() &&
+             keyframes[amplitudeAfter].getRelativePosition().value() >= relativePosition)) {
+      if (keyframes[amplitudeAfter].getAmplitudeModulation().has_value()) {
+        amplitudeBefore = amplitudeAfter;
+      }
+      amplitudeAfter++;
+    }
+    while (frequencyAfter < keyframesCount &&
+           !(keyframes[frequencyAfter].getFrequencyModulation().has_value() &&
+             keyframePosition(frequencyAfter) >= relativePosition)) {
+      if (keyframes[frequencyAfter].getFrequencyModulation().has_value()) {
+        phi += getFrequencyPhaseIncrement(frequencyAfter, frequencyBefore);
+        frequencyBefore = frequencyAfter;
+      }
+      frequencyAfter++;
+    }
+
+    // The segment ends at the next amplitude or frequency keyframe
+    double segmentEnd = maxPosition - this->position;
+    if (amplitudeAfter < keyframesCount) {
+      segmentEnd = std::min(segmentEnd, static_cast<double>(keyframePosition(amplitudeAfter)));
+    }
+    if (frequencyAfter < keyframesCount) {
+      segmentEnd = std::min(segmentEnd, static_cast<double>(keyframePosition(frequencyAfter)));
+    }
+
+    bool chirp = false;
+    double f0 = 0;
+    double f1 = 0;
+    int t0 = 0;
+    int t1 = 0;
+    if (frequencyAfter < keyframesCount) {
+      f1 = keyframes[frequencyAfter].getFrequencyModulation().value();
+      t1 = keyframePosition(frequencyAfter);
+      chirp = frequencyBefore >= 0;
+      f0 = chirp ? keyframes[frequencyBefore].getFrequencyModulation().value() : f1;
+      t0 = chirp ? keyframePosition(frequencyBefore) : 0;
+    } else if (frequencyBefore >= 0) {
+      f0 = keyframes[frequencyBefore].getFrequencyModulation().value();
+    }
+
+    // The modulations are computed for a batch of samples, then the base signal is generated for
+    // the whole batch at once
+    while (i < out.size() && positions[first + i] - this->position <= segmentEnd) {
+      size_t count = 0;
+      for (; count < VECTORIAL_BATCH_LENGTH && i + count < out.size() &&
+             positions[first + i + count] - this->position <= segmentEnd;
+           count++) {
+        double t = positions[first + i + count] - this->position;
+
+        double amp_modulation = 1;
+        if (amplitudeAfter < keyframesCount && amplitudeBefore >= 0) {
+          float a0 = keyframes[amplitudeBefore].getAmplitudeModulation().value();
+          float a1 = keyframes[amplitudeAfter].getAmplitudeModulation().value();
+          amp_modulation = haptics::tools::linearInterpolation(
+              {keyframePosition(amplitudeBefore), a0},
+              {keyframes[amplitudeAfter].getRelativePosition().value(), a1}, t);
+        } else if (amplitudeAfter < keyframesCount) {
+          amp_modulation = keyframes[amplitudeAfter].getAmplitudeModulation().value();
+        } else if (amplitudeBefore >= 0) {
+          amp_modulation = keyframes[amplitudeBefore].getAmplitudeModulation().value();
+        }
+
+        double freq_modulation = f0;
+        if (chirp) {
+          freq_modulation = tools::chirpInterpolation(t0, t1, f0, f1, t);
+          freq_modulation = std::clamp(freq_modulation, static_cast<double>(lowFrequencyLimit),
+                                       static_cast<double>(highFrequencyLimit));
+          t -= t0;
+        }
+        amplitudes[count] = amp_modulation;
+        frequencies[count] = freq_modulation;
+        times[count] = t / static_cast<double>(timescale);
+      }
+      tools::computeWaveform(waveform, times.data(), frequencies.data(), phi, &out[i], count);
+      for (size_t k = 0; k < count; k++) {
+        out[i + k] *= amplitudes[k];
+      }
+      i += count;
+    }
+  }
+}
+
+auto Effect::getFrequencyPhaseIncrement(int keyframeIndex, int previousKeyframeIndex) const
+    -> double {
+  const int pos = keyframes[keyframeIndex].getRelativePosition().value_or(0);
+  if (previousKeyframeIndex >= 0) {
+    int deltaT = pos - keyframes[previousKeyframeIndex].getRelativePosition().value_or(0);
+    return M_PI * deltaT * MS_2_S *
+           (keyframes[previousKeyframeIndex].getFrequencyModulation().value() +
+            keyframes[keyframeIndex].getFrequencyModulation().value());
+  }
+  if (pos > 0) { // first keyframe with frequency value
+    return 2 * M_PI * pos * MS_2_S * keyframes[keyframeIndex].getFrequencyModulation().value();
+  }
+  return 0;
+}
+
 auto Effect::EvaluateWavelet(double position, int fs, unsigned int timescale) -> double {
   double relativePosition = (position - this->getPosition()) * (double)fs /
                             (double)timescale; // relative position in samples rel. to fs
   int index = std::floor(relativePosition);
 
-  auto samples = this->getWaveletSamples();
-  if (index >= (int)samples.size()) {
+  const auto &samples = this->getWaveletSamples();
+  if (index < 0 || index >= (int)samples.size()) {
     return 0;
   }
   return samples[index];
 }
 
+auto Effect::EvaluateWaveletBlock(const std::vector<double> &positions, size_t first,
+                                  const ResamplingKernel &kernel, unsigned int timescale,
+                                  std::vector<double> &out) -> void {
+  std::fill(out.begin(), out.end(), 0);
+  const auto &samples = this->getWaveletSamples();
+  if (out.empty() || samples.empty() || kernel.fs <= 0) {
+    return;
+  }
+  const auto sampleCount = static_cast<int>(samples.size());
+  auto relativeIndex = [&](size_t i) {
+    return (positions[first + i] - this->getPosition()) * static_cast<double>(kernel.fs) /
+           static_cast<double>(timescale);
+  };
+
+  if (kernel.fs == kernel.samplingFrequency) {
+    // Both signals share the same sampling grid: the decoded samples are copied in one go. The
+    // tolerance keeps rounding errors on the positions from shifting the whole block by a sample.
+    const auto startIndex =
+        static_cast<int>(std::floor(relativeIndex(0) + WAVELET_INDEX_TOLERANCE));
+    const int begin = std::max(0, -startIndex);
+    const int end = std::min(static_cast<int>(out.size()), sampleCount - startIndex);
+    if (begin < end) {
+      std::copy(samples.begin() + startIndex + begin, samples.begin() + startIndex + end,
+                out.begin() + begin);
+    }
+    return;
+  }
+
+  // Each output sample sums the decoded samples within the half width of the kernel, the kernel
+  // being linearly interpolated between its tabulated values. The last value of the table is 0.
+  const auto lastStep = static_cast<double>(kernel.values.size() - 2);
+  for (size_t i = 0; i < out.size(); i++) {
+    const double x = relativeIndex(i);
+    const int begin = std::max(0, static_cast<int>(std::ceil(x - kernel.halfWidth)));
+    const int end = std::min(sampleCount, static_cast<int>(std::floor(x + kernel.halfWidth)) + 1);
+    double sum = 0;
+    for (int k = begin; k < end; k++) {
+      const double t = std::min(std::abs(x - k) * ResamplingKernel::STEPS, lastStep);
+      const auto j = static_cast<size_t>(t);
+      sum += samples[k] *
+             (kernel.values[j] + (t - static_cast<double>(j)) *
+                                     (kernel.values[j + 1] - kernel.values[j]));
+    }
+    out[i] = sum;
+  }
+}
+
 auto Effect::EvaluateTransient(double position, double transientDuration) -> double {
   const double relativePosition = position - this->getPosition();
 
@@ -323,6 +523,7 @@ auto Effect::EvaluateTransient(double position, double transientDuration) -> dou
   double res = 0;
   while (it != keyframes.rend() && checkingFunction(*it)) {
     if (!it->getAmplitudeModulation().has_value()) {
+      it++;
       continue;
     }
 
@@ -335,6 +536,48 @@ auto Effect::EvaluateTransient(double position, double transientDuration) -> dou
   return res;
 }
 
+auto Effect::EvaluateTransientBlock(uint32_t firstSample, int pad, const TransientKernel &kernel,
+                                    std::vector<double> &out) -> void {
+  std::fill(out.begin(), out.end(), 0);
+  if (out.empty() || kernel.sine.empty()) {
+    return;
+  }
+  const double samplesPerTick = kernel.fs / static_cast<double>(kernel.timescale);
+  const auto outFirst = static_cast<int64_t>(firstSample);
+  const auto outLast = outFirst + static_cast<int64_t>(out.size()) - 1;
+  for (Keyframe &keyframe : keyframes) {
+    if (!keyframe.getRelativePosition().has_value() ||
+        !keyframe.getAmplitudeModulation().has_value()) {
+      continue;
+    }
+    // Start and end of the transient, as fractional sample indices. They only depend on the
+    // keyframe, so the samples rendered are the same whatever the chunk boundaries are.
+    const double start = this->getPosition() + keyframe.getRelativePosition().value();
+    const double startSample = (start / kernel.timescale + pad * MS_2_S) * kernel.fs;
+    const double endSample = startSample + kernel.duration * samplesPerTick;
+    const auto kernelFirst = static_cast<int64_t>(std::ceil(startSample));
+    const auto kernelLast =
+        std::min(static_cast<int64_t>(std::floor(endSample)),
+                 kernelFirst + static_cast<int64_t>(kernel.sine.size()) - 1);
+    const int64_t first = std::max(kernelFirst, outFirst);
+    const int64_t last = std::min(kernelLast, outLast);
+    if (first > last) {
+      continue;
+    }
+    // The kernel is shifted by the offset between the keyframe and the first sample after it
+    const double phase =
+        4 * M_PI * (static_cast<double>(kernelFirst) - startSample) / (endSample - startSample);
+    const double sinePhase = std::sin(phase);
+    const double cosinePhase = std::cos(phase);
+    const double amplitude = keyframe.getAmplitudeModulation().value();
+    for (int64_t g = first; g <= last; g++) {
+      const auto k = static_cast<size_t>(g - kernelFirst);
+      out[static_cast<size_t>(g - outFirst)] +=
+          amplitude * (sinePhase * kernel.cosine[k] + cosinePhase * kernel.sine[k]);
+    }
+  }
+}
+
 auto Effect::EvaluateKeyframes(double position, types::CurveType curveType, unsigned int timescale)
     -> double {
   const double relativePosition = position - this->getPosition();
@@ -32,6 +32,7 @@
  */
 
 #include <Types/include/Haptics.h>
+#include <cmath>
 #include <ctime>
 
 namespace haptics::types {
@@ -186,6 +187,30 @@ auto Haptics::linearize() -> void {
   }
 }
 
+auto Haptics::renderLibrary(int fs) -> void {
+  for (types::Perception &p : perceptions) {
+    p.renderLibrary(fs, getTimescaleOrDefault());
+  }
+}
+
+auto Haptics::renderRange(double startTick, double endTick, int fs)
+    -> std::vector<std::vector<double>> {
+  std::vector<std::vector<double>> res;
+  for (types::Perception &p : perceptions) {
+    const double perceptionUnitFactor = std::pow(10.0, p.getPerceptionUnitExponentOrDefault());
+    for (uint32_t i = 0; i < p.getChannelsSize(); i++) {
+      types::Channel &channel = p.getChannelAt(static_cast<int>(i));
+      std::vector<double> channelAmp =
+          channel.renderRange(startTick, endTick, fs, getTimescaleOrDefault());
+      for (double &amp : channelAmp) {
+        amp *= channel.getGain() * perceptionUnitFactor;
+      }
+      res.push_back(std::move(channelAmp));
+    }
+  }
+  return res;
+}
+
 auto Haptics::refactor() -> void {
   for (types::Perception &p : perceptions) {
     p.refactorEffects();
@@ -32,6 +32,10 @@
  */
 
 #include <Types/include/Perception.h>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <tuple>
 
 namespace haptics::types {
 
@@ -326,6 +330,57 @@ auto Perception::linearizeLibrary() -> void {
   effectLibrary.clear();
 }
 
+auto Perception::renderLibrary(int fs, unsigned int timescale) -> void {
+  // Library effects rendered for a band type, a curve type and frequency limits, by effect id
+  using RenderKey = std::tuple<BandType, CurveType, int, int, int>;
+  std::map<RenderKey, std::shared_ptr<const std::vector<double>>> renders;
+  for (Channel &channel : channels) {
+    for (int j = 0; j < static_cast<int>(channel.getBandsSize()); j++) {
+      Band &band = channel.getBandAt(j);
+      band.clearReferenceRenders();
+      for (int k = 0; k < static_cast<int>(band.getEffectsSize()); k++) {
+        Effect &effect = band.getEffectAt(k);
+        if (effect.getEffectType() != EffectType::Reference ||
+            band.getReferenceRender(effect.getId()) != nullptr) {
+          continue;
+        }
+        const RenderKey key = {band.getBandType(), band.getCurveTypeOrDefault(),
+                               band.getLowerFrequencyLimit(), band.getUpperFrequencyLimit(),
+                               effect.getId()};
+        auto it = renders.find(key);
+        if (it == renders.end()) {
+          std::optional<std::vector<double>> samples =
+              renderLibraryEffect(effect.getId(), band, fs, timescale);
+          if (!samples.has_value()) {
+            continue;
+          }
+          it = renders
+                   .emplace(key, std::make_shared<const std::vector<double>>(
+                                     std::move(samples.value())))
+                   .first;
+        }
+        band.setReferenceRender(effect.getId(), fs, it->second);
+      }
+    }
+  }
+}
+
+auto Perception::renderLibraryEffect(int id, const Band &band, int fs, unsigned int timescale)
+    -> std::optional<std::vector<double>> {
+  std::optional<Effect> libraryEffect = getEffectById(id);
+  if (!libraryEffect.has_value()) {
+    return std::nullopt;
+  }
+  Band libraryBand(band.getBandType(), band.getCurveTypeOrDefault(), band.getLowerFrequencyLimit(),
+                   band.getUpperFrequencyLimit());
+  libraryEffect->setPosition(0);
+  libraryEffect->setEffectType(EffectType::Basis);
+  libraryBand.addEffect(libraryEffect.value());
+  const auto sampleCount = static_cast<uint32_t>(
+      std::floor(libraryBand.getBandTimeLength(timescale) * fs / timescale) + 1);
+  return libraryBand.EvaluationBand(sampleCount, fs, 0, timescale);
+}
+
 auto Perception::refactorEffects() -> void {
   for (int i = 0; i < static_cast<int>(getChannelsSize()); i++) {
     auto channel = getChannelAt(i);
@@ -31,15 +31,289 @@
  * THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <Tools/include/Tools.h>
 #include <Types/include/Band.h>
 #include <catch2/catch.hpp>
 
 using haptics::types::Band;
 using haptics::types::BandType;
+using haptics::types::BaseSignal;
 using haptics::types::CurveType;
+using haptics::types::Effect;
+using haptics::types::EffectType;
 
 TEST_CASE("haptics::types::Band", "[placeholder]") {
   const Band b(BandType::VectorialWave, 70, 1000);
 
   CHECK(true);
 }
+
+TEST_CASE("haptics::types::Band::EvaluationBand with overlapping effects", "[EvaluationBand]") {
+  const int fs = 8000;
+  const unsigned int timescale = 1000;
+  const uint32_t sampleCount = 4000;
+  Band b(BandType::VectorialWave, 0, 1000);
+  for (int i = 0; i < 20; i++) {
+    Effect e(i * 20, 0, BaseSignal::Sine, EffectType::Basis);
+    e.addKeyframe(0, 1, 90 + i);
+    e.addKeyframe(60 + i * 5, 0.5, 200);
+    b.addEffect(e);
+  }
+
+  std::vector<double> bandAmp = b.EvaluationBand(sampleCount, fs, 0, timescale);
+
+  REQUIRE(bandAmp.size() == sampleCount);
+  for (uint32_t ti = 0; ti < sampleCount; ti++) {
+    const double position = timescale * static_cast<double>(ti) / fs;
+    double expected = 0;
+    for (int i = static_cast<int>(b.getEffectsSize()) - 1; i >= 0; i--) {
+      Effect &e = b.getEffectAt(i);
+      if (e.getPosition() <= position) {
+        expected += e.EvaluateVectorial(position, 0, 1000, timescale);
+      }
+    }
+    CHECK(bandAmp[ti] == Approx(expected).margin(1e-12));
+  }
+}
+
+TEST_CASE("haptics::types::Band::getEffectsInWindow", "[getEffectsInWindow]") {
+  const unsigned int timescale = 1000;
+  Band b(BandType::VectorialWave, 0, 1000);
+  Effect longEffect(0, 0, BaseSignal::Sine, EffectType::Basis);
+  longEffect.addKeyframe(0, 1, 90);
+  longEffect.addKeyframe(1000, 1, 90);
+  b.addEffect(longEffect);
+  for (int i = 1; i < 10; i++) {
+    Effect e(i * 100, 0, BaseSignal::Sine, EffectType::Basis);
+    e.addKeyframe(0, 1, 90);
+    e.addKeyframe(50, 1, 90);
+    b.addEffect(e);
+  }
+
+  std::vector<int> indices;
+  b.getEffectsInWindow(460, 560, timescale, indices);
+  CHECK(indices == std::vector<int>{5, 0});
+
+  b.getEffectsInWindow(1001, 2000, timescale, indices);
+  CHECK(indices.empty());
+
+  REQUIRE(b.removeEffectAt(0));
+  b.getEffectsInWindow(460, 560, timescale, indices);
+  CHECK(indices == std::vector<int>{4});
+
+  Effect lateEffect(2000, 0, BaseSignal::Sine, EffectType::Basis);
+  lateEffect.addKeyframe(0, 1, 90);
+  b.addEffect(lateEffect);
+  b.getEffectsInWindow(1001, 2000, timescale, indices);
+  CHECK(indices == std::vector<int>{9});
+
+  b.getEffectAt(9).setPosition(3000);
+  b.getEffectsInWindow(2500, 3500, timescale, indices);
+  CHECK(indices == std::vector<int>{9});
+}
+
+TEST_CASE("haptics::types::Band::EvaluationBand with transients", "[EvaluationBand]") {
+  const int fs = 8000;
+  const unsigned int timescale = 1000;
+  const uint32_t sampleCount = 6000;
+  const double duration = Band::TRANSIENT_DURATION_MS;
+  Band band(BandType::Transient, CurveType::Unknown, 0, 1000);
+  for (int i = 0; i < 12; i++) {
+    Effect effect(i * 53, 0, BaseSignal::Sine, EffectType::Basis);
+    effect.addKeyframe(0, .7, 150);
+    effect.addKeyframe(7, .4, 200);
+    effect.addKeyframe(40, std::nullopt, 200); // no amplitude: ignored
+    effect.addKeyframe(61, -.5, 100);
+    band.addEffect(effect);
+  }
+
+  std::vector<double> expected(sampleCount, 0);
+  for (uint32_t ti = 0; ti < sampleCount; ti++) {
+    const double position = timescale * static_cast<double>(ti) / fs;
+    for (int i = static_cast<int>(band.getEffectsSize()) - 1; i >= 0; i--) {
+      Effect &effect = band.getEffectAt(i);
+      const double end =
+          effect.getPosition() + effect.getEffectTimeLength(BandType::Transient, duration);
+      if (effect.getPosition() <= position && position <= end) {
+        expected[ti] += effect.EvaluateTransient(position, duration);
+      }
+    }
+  }
+
+  std::vector<double> res = band.EvaluationBand(sampleCount, fs, 0, timescale);
+  REQUIRE(res.size() == expected.size());
+  for (uint32_t ti = 0; ti < sampleCount; ti++) {
+    CHECK(res[ti] == Approx(expected[ti]).margin(1e-9));
+  }
+}
+
+TEST_CASE("haptics::types::Band::EvaluationBand with curves", "[EvaluationBand]") {
+  const int fs = 1000;
+  const unsigned int timescale = 1000;
+  const uint32_t sampleCount = 900;
+  const std::vector<std::pair<int, double>> points = {
+      {0, .125}, {37, .75}, {80, -.25}, {150, .5}, {210, 0}, {260, .625}, {300, -.375}};
+  auto makeBand = [&points](CurveType curveType, size_t pointCount) {
+    Band band(BandType::Curve, curveType, 0, 72);
+    for (int position : {100, 500}) {
+      Effect effect(position, EffectType::Basis);
+      for (size_t i = 0; i < pointCount; i++) {
+        effect.addKeyframe(points[i].first, points[i].second, std::nullopt);
+      }
+      band.addEffect(effect);
+    }
+    return band;
+  };
+
+  SECTION("dense interpolation") {
+    const std::vector<std::pair<int, double>> odd(points.begin(), points.end());
+    const std::vector<std::pair<CurveType, std::vector<double>>> curves = {
+        {CurveType::Linear, haptics::tools::linearInterpolation2(odd)},
+        {CurveType::Cubic, haptics::tools::cubicInterpolation2(odd)},
+        {CurveType::Akima, haptics::tools::akimaInterpolation(odd)},
+        {CurveType::Bezier, haptics::tools::bezierInterpolation(odd)},
+        {CurveType::Bspline, haptics::tools::bsplineInterpolation(odd)}};
+    for (const auto &curve : curves) {
+      // B-spline samples may be one step of the parameter grid away from bsplineInterpolation,
+      // which accumulates the steps instead of indexing them
+      const double margin = curve.first == CurveType::Bspline ? 5e-3 : 0;
+      Band band = makeBand(curve.first, points.size());
+      std::vector<double> res = band.EvaluationBand(sampleCount, fs, 0, timescale);
+      REQUIRE(curve.second.size() == static_cast<size_t>(points.back().first) + 1);
+      for (size_t i = 0; i < curve.second.size(); i++) {
+        CHECK(res[100 + i] == Approx(curve.second[i]).margin(margin));
+        CHECK(res[500 + i] == Approx(curve.second[i]).margin(margin));
+      }
+      CHECK(res[99] == 0);
+      CHECK(res[401] == 0);
+      CHECK(res[801] == 0);
+    }
+  }
+
+  SECTION("two keyframes") {
+    Band band = makeBand(CurveType::Cubic, 2);
+    std::vector<double> res = band.EvaluationBand(sampleCount, fs, 0, timescale);
+    CHECK(res[100] == Approx(.125));
+    CHECK(res[100 + 20] == Approx(.125 + .625 * 20 / 37));
+    CHECK(res[100 + 37] == Approx(.75));
+    CHECK(res[100 + 38] == 0);
+  }
+
+  SECTION("first keyframe after the effect position") {
+    // The curve starts at the first keyframe, as in Effect::EvaluateKeyframes
+    Band band(BandType::Curve, CurveType::Linear, 0, 72);
+    Effect effect(100, EffectType::Basis);
+    effect.addKeyframe(40, .2, std::nullopt);
+    effect.addKeyframe(80, .6, std::nullopt);
+    band.addEffect(effect);
+    std::vector<double> res = band.EvaluationBand(sampleCount, fs, 0, timescale);
+    CHECK(res[100] == 0);
+    CHECK(res[139] == 0);
+    CHECK(res[140] == Approx(.2));
+    CHECK(res[160] == Approx(.4));
+    CHECK(res[160] == Approx(effect.EvaluateKeyframes(160, CurveType::Linear, timescale)));
+    CHECK(res[180] == Approx(.6));
+    CHECK(res[181] == 0);
+  }
+
+  SECTION("chunks") {
+    for (CurveType curveType : {CurveType::Linear, CurveType::Cubic, CurveType::Akima,
+                                CurveType::Bezier, CurveType::Bspline}) {
+      for (size_t pointCount : {points.size() - 1, points.size()}) {
+        Band band = makeBand(curveType, pointCount);
+        std::vector<double> expected = band.EvaluationBand(sampleCount, fs, 0, timescale);
+        CHECK(expected[100 + points[pointCount - 1].first] ==
+              Approx(points[pointCount - 1].second));
+        const uint32_t chunkLength = 45;
+        std::vector<double> chunk(chunkLength);
+        for (uint32_t first = 0; first < sampleCount; first += chunkLength) {
+          band.EvaluationBand(first, fs, 0, timescale, chunk);
+          for (uint32_t i = 0; i < chunkLength; i++) {
+            REQUIRE(chunk[i] == expected[first + i]);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("haptics::types::Band::renderRange", "[renderRange]") {
+  const int fs = 8000;
+  const unsigned int timescale = 1000;
+  Band band(BandType::VectorialWave, CurveType::Unknown, 72, 1000);
+  for (int i = 0; i < 200; i++) {
+    Effect effect(i * 97, 0, static_cast<BaseSignal>(i % 5), EffectType::Basis);
+    effect.addKeyframe(0, .6, 90);
+    effect.addKeyframe(50, .2, 300);
+    effect.addKeyframe(120, .5, 150);
+    band.addEffect(effect);
+  }
+  const auto sampleCount =
+      static_cast<uint32_t>(band.getBandTimeLength(timescale) * fs / timescale) + 1;
+  const std::vector<double> expected = band.EvaluationBand(sampleCount, fs, 0, timescale);
+
+  const std::vector<std::pair<double, double>> windows = {
+      {0, 100}, {15000.3, 15200}, {19000, 19400.5}, {-10, 5}, {300, 300}, {400, 200}};
+  for (const auto &window : windows) {
+    const auto [firstSample, count] =
+        Band::getRangeSamples(window.first, window.second, fs, timescale);
+    std::vector<double> res = band.renderRange(window.first, window.second, fs, timescale);
+    REQUIRE(res.size() == count);
+    for (uint32_t i = 0; i < count; i++) {
+      REQUIRE(res[i] == expected[firstSample + i]);
+    }
+  }
+  CHECK(Band::getRangeSamples(15000.3, 15200, fs, timescale).first == 120003);
+  CHECK(Band::getRangeSamples(15000.3, 15200, fs, timescale).second == 1597);
+  CHECK(Band::getRangeSamples(-10, 5, fs, timescale) == std::pair<uint32_t, uint32_t>(0, 40));
+  CHECK(Band::getRangeSamples(400, 200, fs, timescale).second == 0);
+}
+
+TEST_CASE("haptics::types::Band::EvaluationBand with resampled wavelets", "[EvaluationBand]") {
+  const int bandFs = 8000;
+  const int bl = 128;
+  const int blockCount = 16;
+  const unsigned int timescale = 1000;
+  const double low = 100;
+  const double high = 3000;
+  // Decoded blocks of a low and a high frequency sine, which is continuous across blocks
+  Band band(BandType::WaveletWave, 0, bandFs);
+  band.setBlockLength(bl * static_cast<int>(timescale) / bandFs);
+  for (int b = 0; b < blockCount; b++) {
+    std::vector<double> samples(bl);
+    for (int i = 0; i < bl; i++) {
+      const double t = static_cast<double>(b * bl + i) / bandFs;
+      samples[i] = .5 * std::sin(2 * M_PI * low * t) + .3 * std::sin(2 * M_PI * high * t);
+    }
+    Effect effect;
+    effect.setPosition(b * band.getBlockLength().value());
+    effect.setWaveletSamples(samples);
+    band.addEffect(effect);
+  }
+
+  // Samples within the half width of the kernel from the ends of the band are left out, the
+  // signal being cut there. Every block boundary is within the checked samples.
+  for (const int fs : {12000, 2000}) {
+    const double margin = band.getWaveletWindowMargin(fs, timescale) * fs / timescale;
+    const auto sampleCount = static_cast<uint32_t>(blockCount * bl * fs / bandFs);
+    const std::vector<double> res = band.EvaluationBand(sampleCount, fs, 0, timescale);
+    REQUIRE(res.size() == sampleCount);
+    for (auto i = static_cast<uint32_t>(margin) + 1; i + margin + 1 < sampleCount; i++) {
+      const double t = static_cast<double>(i) / fs;
+      double expected = .5 * std::sin(2 * M_PI * low * t);
+      if (high < fs / 2.0) {
+        expected += .3 * std::sin(2 * M_PI * high * t);
+      }
+      REQUIRE(res[i] == Approx(expected).margin(1e-3));
+    }
+
+    // Rendering chunk by chunk gives the same samples
+    std::vector<double> chunk(97);
+    for (uint32_t first = 0; first + chunk.size() <= sampleCount; first += 97) {
+      band.EvaluationBand(first, fs, 0, timescale, chunk);
+      for (size_t i = 0; i < chunk.size(); i++) {
+        REQUIRE(chunk[i] == res[first + i]);
+      }
+    }
+  }
+}
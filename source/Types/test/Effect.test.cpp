@@ -103,3 +103,106 @@ TEST_CASE("addKeyframe with amplitude and frequency", "[addKeyframe]") {
   REQUIRE(testedKeyframe.getFrequencyModulation().has_value());
   CHECK(testedKeyframe.getFrequencyModulation().value() == Approx(testingFrequency));
 }
+
+TEST_CASE("EvaluateVectorialBlock matches EvaluateVectorial", "[EvaluateVectorialBlock]") {
+  const int lowFrequencyLimit = 0;
+  const int highFrequencyLimit = 1000;
+  const unsigned int timescale = 1000;
+  const int fs = 8000;
+  const int effectPosition = 63;
+  const std::vector<BaseSignal> baseSignals = {BaseSignal::Sine, BaseSignal::Square,
+                                               BaseSignal::Triangle, BaseSignal::SawToothUp,
+                                               BaseSignal::SawToothDown};
+
+  for (BaseSignal baseSignal : baseSignals) {
+    Effect e(effectPosition, .3F, baseSignal, EffectType::Basis);
+    e.addKeyframe(0, .2, 90);
+    e.addKeyframe(40, std::nullopt, 160);
+    e.addKeyframe(75, 1, std::nullopt);
+    e.addKeyframe(110, .6, 240);
+    e.addKeyframe(150, std::nullopt, 60);
+    e.addKeyframe(210, .1, std::nullopt);
+
+    // positions start before the effect and end after it
+    std::vector<double> positions(2400, 0);
+    for (size_t i = 0; i < positions.size(); i++) {
+      positions[i] = timescale * static_cast<double>(i) / fs;
+    }
+    const size_t first = 100;
+    std::vector<double> res(positions.size() - first, 1);
+    e.EvaluateVectorialBlock(positions, first, lowFrequencyLimit, highFrequencyLimit, timescale,
+                             res);
+
+    for (size_t i = 0; i < res.size(); i++) {
+      const double expected = e.EvaluateVectorial(positions[first + i], lowFrequencyLimit,
+                                                  highFrequencyLimit, timescale);
+      CHECK(res[i] == Approx(expected).margin(1e-9));
+    }
+  }
+}
+
+TEST_CASE("EvaluateVectorialBlock with a single frequency keyframe", "[EvaluateVectorialBlock]") {
+  const unsigned int timescale = 1000;
+  Effect e(0, 0, BaseSignal::Sine, EffectType::Basis);
+  e.addKeyframe(30, std::nullopt, 120);
+  e.addKeyframe(60, .5, std::nullopt);
+  e.addKeyframe(100, .9, std::nullopt);
+
+  std::vector<double> positions(1000, 0);
+  for (size_t i = 0; i < positions.size(); i++) {
+    positions[i] = static_cast<double>(i) / 8;
+  }
+  std::vector<double> res(positions.size(), 0);
+  e.EvaluateVectorialBlock(positions, 0, 0, 1000, timescale, res);
+
+  for (size_t i = 0; i < res.size(); i++) {
+    const double expected = e.EvaluateVectorial(positions[i], 0, 1000, timescale);
+    CHECK(res[i] == Approx(expected).margin(1e-9));
+  }
+}
+
+TEST_CASE("EvaluateWaveletBlock", "[EvaluateWaveletBlock]") {
+  const unsigned int timescale = 1000;
+  const int fs = 1000;
+  Effect e(20, 0, BaseSignal::Sine, EffectType::Basis);
+  std::vector<double> samples = {.1, -.4, .25, .8, -.6, .3};
+  e.setWaveletSamples(samples);
+  haptics::types::ResamplingKernel kernel;
+  kernel.fs = fs;
+
+  SECTION("same sampling frequency") {
+    kernel.samplingFrequency = fs;
+    std::vector<double> positions(40, 0);
+    for (size_t i = 0; i < positions.size(); i++) {
+      positions[i] = static_cast<double>(i);
+    }
+    std::vector<double> res(positions.size() - 5, 1);
+    e.EvaluateWaveletBlock(positions, 5, kernel, timescale, res);
+    for (size_t i = 0; i < res.size(); i++) {
+      CHECK(res[i] == e.EvaluateWavelet(positions[5 + i], fs, timescale));
+    }
+  }
+
+  SECTION("resampled") {
+    // Triangular kernel of half width 1, for which resampling is a linear interpolation
+    kernel.samplingFrequency = 4 * fs;
+    kernel.halfWidth = 1;
+    kernel.values.assign(haptics::types::ResamplingKernel::STEPS + 2, 0);
+    for (int k = 0; k <= haptics::types::ResamplingKernel::STEPS; k++) {
+      kernel.values[k] = 1 - static_cast<double>(k) / haptics::types::ResamplingKernel::STEPS;
+    }
+    std::vector<double> positions(160, 0);
+    for (size_t i = 0; i < positions.size(); i++) {
+      positions[i] = static_cast<double>(i) * timescale / kernel.samplingFrequency;
+    }
+    std::vector<double> res(positions.size(), 1);
+    e.EvaluateWaveletBlock(positions, 0, kernel, timescale, res);
+    for (size_t i = 0; i < samples.size(); i++) {
+      CHECK(res[80 + 4 * i] == Approx(samples[i]));
+    }
+    CHECK(res[82] == Approx((samples[0] + samples[1]) / 2));
+    CHECK(res[79] == Approx(.75 * samples[0]));
+    CHECK(res[76] == 0);
+    CHECK(res[80 + 4 * samples.size()] == 0);
+  }
+}
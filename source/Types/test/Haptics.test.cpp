@@ -110,3 +110,44 @@ TEST_CASE("haptics::types::Haptics loading ohm file", "[loadMetadataFromOHM]") {
     CHECK(channel.getBodyPartMask() == static_cast<uint32_t>(bodyPartMask));
   }
 }
+
+TEST_CASE("haptics::types::Haptics::renderRange", "[renderRange]") {
+  using haptics::types::Band;
+  using haptics::types::BandType;
+  using haptics::types::BaseSignal;
+  using haptics::types::Channel;
+  using haptics::types::CurveType;
+  using haptics::types::Effect;
+  using haptics::types::EffectType;
+  using haptics::types::Perception;
+  using haptics::types::PerceptionModality;
+  const int fs = 8000;
+
+  Haptics h("1", "02/04/2022", "test content");
+  Perception perception(0, 0, "Vibration effect", PerceptionModality::Vibrotactile);
+  perception.setPerceptionUnitExponent(-1);
+  for (int c = 0; c < 2; c++) {
+    Channel channel(c, "channel", .5F + static_cast<float>(c), 1, 0);
+    Band band(BandType::VectorialWave, CurveType::Unknown, 72, 1000);
+    for (int i = 0; i < 10; i++) {
+      Effect effect(i * 80 + c * 7, 0, BaseSignal::Sine, EffectType::Basis);
+      effect.addKeyframe(0, .9, 100);
+      effect.addKeyframe(60, .9, 200);
+      band.addEffect(effect);
+    }
+    channel.addBand(band);
+    perception.addChannel(channel);
+  }
+  h.addPerception(perception);
+
+  const std::vector<std::vector<double>> res = h.renderRange(250, 400, fs);
+  REQUIRE(res.size() == 2);
+  for (int c = 0; c < 2; c++) {
+    Channel &channel = h.getPerceptionAt(0).getChannelAt(c);
+    const std::vector<double> expected = channel.EvaluateChannel(8000, fs, 0, 1000);
+    REQUIRE(res[c].size() == 1200);
+    for (size_t i = 0; i < res[c].size(); i++) {
+      REQUIRE(res[c][i] == Approx(expected[2000 + i] * channel.getGain() * .1));
+    }
+  }
+}
@@ -149,3 +149,71 @@ TEST_CASE("haptics::types::Perception testing unit exponents with null values")
   CHECK_FALSE(perception.getPerceptionUnitExponent().has_value());
   CHECK(perception.getPerceptionUnitExponentOrDefault() == expected_perceptionUnitExponent);
 }
+
+TEST_CASE("haptics::types::Perception::renderLibrary") {
+  using haptics::types::Band;
+  using haptics::types::BandType;
+  using haptics::types::BaseSignal;
+  using haptics::types::Channel;
+  using haptics::types::CurveType;
+  using haptics::types::Effect;
+  using haptics::types::EffectType;
+  using haptics::types::Perception;
+  using haptics::types::PerceptionModality;
+  const int fs = 8000;
+  const unsigned int timescale = 1000;
+  const uint32_t sampleCount = 6000;
+
+  Perception perception(0, 0, "Some perception test content", PerceptionModality::Vibrotactile);
+  Effect vectorialEffect(0, 0, BaseSignal::Sine, EffectType::Basis);
+  vectorialEffect.setId(0);
+  vectorialEffect.addKeyframe(0, .5, 90);
+  vectorialEffect.addKeyframe(60, .8, 250);
+  vectorialEffect.addKeyframe(110, .2, 150);
+  perception.addBasisEffect(vectorialEffect);
+  Effect curveEffect(0, EffectType::Basis);
+  curveEffect.setId(1);
+  curveEffect.addKeyframe(0, .25, std::nullopt);
+  curveEffect.addKeyframe(40, .75, std::nullopt);
+  curveEffect.addKeyframe(90, 0, std::nullopt);
+  perception.addBasisEffect(curveEffect);
+
+  Channel channel(0, "Some channel", 1, 1, 0);
+  Band vectorial(BandType::VectorialWave, CurveType::Unknown, 72, 1000);
+  Band curve(BandType::Curve, CurveType::Cubic, 0, 72);
+  for (int position : {0, 100, 230, 500}) {
+    Effect reference(position, EffectType::Reference);
+    reference.setId(0);
+    vectorial.addEffect(reference);
+    reference.setId(1);
+    curve.addEffect(reference);
+  }
+  Effect basis(320, 0, BaseSignal::Triangle, EffectType::Basis);
+  basis.addKeyframe(0, .3, 120);
+  basis.addKeyframe(50, .3, 120);
+  vectorial.addEffect(basis);
+  channel.addBand(vectorial);
+  channel.addBand(vectorial);
+  channel.addBand(curve);
+  perception.addChannel(channel);
+
+  Perception linearized = perception;
+  linearized.linearizeLibrary();
+  perception.renderLibrary(fs, timescale);
+
+  Channel &rendered = perception.getChannelAt(0);
+  CHECK(rendered.getBandAt(0).getReferenceRender(0) != nullptr);
+  CHECK(rendered.getBandAt(0).getReferenceRender(0) == rendered.getBandAt(1).getReferenceRender(0));
+  CHECK(rendered.getBandAt(2).getReferenceRender(1) != nullptr);
+  for (int j = 0; j < 3; j++) {
+    Band &band = rendered.getBandAt(j);
+    Band &expectedBand = linearized.getChannelAt(0).getBandAt(j);
+    CHECK(band.getBandTimeLength(timescale) ==
+          Approx(expectedBand.getBandTimeLength(timescale)).margin(1));
+    std::vector<double> res = band.EvaluationBand(sampleCount, fs, 0, timescale);
+    std::vector<double> expected = expectedBand.EvaluationBand(sampleCount, fs, 0, timescale);
+    for (uint32_t i = 0; i < sampleCount; i++) {
+      REQUIRE(res[i] == Approx(expected[i]).margin(1e-9));
+    }
+  }
+}
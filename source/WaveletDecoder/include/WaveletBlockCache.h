@@ -0,0 +1,96 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef WAVELETBLOCKCACHE_H
+#define WAVELETBLOCKCACHE_H
+
+#include <WaveletDecoder/include/WaveletDecoder.h>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <utility>
+
+namespace haptics::waveletdecoder {
+
+class WaveletLowPass;
+
+// Decodes the blocks of wavelet bands the first time they are rendered instead of beforehand, and
+// keeps the most recently rendered ones up to a memory cap. Decoded blocks keep their bitstream, so
+// that the samples of the least recently used blocks can be released and decoded again when they
+// are rendered next. Decoding and releasing samples neither moves the blocks nor changes their
+// extent, so the interval index of the bands is kept. The bands must outlive the cache. The blocks
+// of bands with a low-pass frequency are low-passed as they are decoded, see WaveletLowPass.
+class WaveletBlockCache {
+public:
+  // newMaxBytes is the memory cap of the decoded samples of all the bands
+  explicit WaveletBlockCache(size_t newMaxBytes,
+                             DecodingPrecision newPrecision = DecodingPrecision::Double);
+  WaveletBlockCache(const WaveletBlockCache &) = delete;
+  WaveletBlockCache(WaveletBlockCache &&) = delete;
+  auto operator=(const WaveletBlockCache &) -> WaveletBlockCache & = delete;
+  auto operator=(WaveletBlockCache &&) -> WaveletBlockCache & = delete;
+  ~WaveletBlockCache();
+
+  // Decodes the blocks of the band overlapping [startTick, endTick) which are not decoded yet,
+  // then releases the least recently used blocks while the decoded samples exceed the cap. The
+  // blocks of the window are never released, even when they exceed the cap on their own.
+  auto decodeWindow(Band &band, unsigned int timescale, double startTick, double endTick) -> void;
+  // Releases the samples of every decoded block
+  auto clear() -> void;
+
+  [[nodiscard]] auto getMaxBytes() const -> size_t;
+  // Memory used by the decoded samples, in bytes
+  [[nodiscard]] auto getDecodedBytes() const -> size_t;
+  [[nodiscard]] auto getDecodedBlockCount() const -> size_t;
+  // Number of blocks decoded since the creation of the cache, blocks decoded again included
+  [[nodiscard]] auto getDecodeCount() const -> size_t;
+
+private:
+  using BlockKey = std::pair<Band *, int>;
+
+  auto release(BlockKey key) -> void;
+
+  size_t maxBytes = 0;
+  DecodingPrecision precision = DecodingPrecision::Double;
+  Spiht_Dec spihtDec;
+  // Decoded blocks, from the most recently used one to the least recently used one
+  std::list<BlockKey> recentBlocks;
+  std::map<BlockKey, std::list<BlockKey>::iterator> decodedBlocks;
+  size_t decodedBytes = 0;
+  size_t decodeCount = 0;
+  // Low-pass filters of the bands with a low-pass frequency, kept from one window to the next
+  std::map<Band *, std::unique_ptr<WaveletLowPass>> lowPasses;
+};
+} // namespace haptics::waveletdecoder
+#endif // WAVELETBLOCKCACHE_H
@@ -36,11 +36,15 @@
 
 #include <algorithm>
 #include <cmath>
+#include <functional>
+#include <memory>
 #include <optional>
+#include <utility>
 #include <vector>
 
 #include "FilterBank/include/Wavelet.h"
 #include "Spiht/include/Spiht_Dec.h"
+#include "Tools/include/ThreadPool.h"
 #include "Types/include/Band.h"
 #include "Types/include/Effect.h"
 #include "Types/include/Keyframe.h"
@@ -55,15 +59,46 @@ namespace haptics::waveletdecoder {
 
 constexpr double MS_2_S_WAVELET = 0.001;
 
+// Arithmetic used to reconstruct the decoded blocks. Single precision is faster, the difference
+// with double precision being below the resolution of 16 bits PCM output.
+enum class DecodingPrecision { Double = 0, Single = 1 };
+
 class WaveletDecoder {
 public:
+  // Blocks are decoded on threadCount threads, each thread with its own SPIHT decoder. The decoded
+  // samples do not depend on the number of threads.
+  explicit WaveletDecoder(DecodingPrecision newPrecision = DecodingPrecision::Double,
+                          size_t threadCount = 1);
+
   auto decodeBand(Band &band, int timescale) -> std::vector<double>;
+  // Decodes the blocks of the band, which are low-passed if the band has a low-pass frequency
   void transformBand(Band &band, unsigned int timescale);
+  // Decodes only the blocks of the band overlapping the window [startTick, endTick). Blocks
+  // already decoded are left as they are, so that successive windows decode each block once.
+  // Blocks decoded by a previous window are left out of the state of the low-pass filter: only
+  // WaveletBlockCache low-passes successive windows of a band exactly.
+  void transformBand(Band &band, unsigned int timescale, double startTick, double endTick);
   void static decodeBlock(std::vector<int> &block_dwt, std::vector<double> &block_time,
                           double scalar, int dwtl);
+  void static decodeBlock(std::vector<int> &block_dwt, std::vector<float> &block_time,
+                          float scalar, int dwtl);
+  // Decodes the bitstream of a block of bl samples into block_time, as transformBand does
+  void static decodeBlock(Spiht_Dec &decoder, std::vector<unsigned char> &bitstream, int bl,
+                          DecodingPrecision blockPrecision, std::vector<double> &block_time);
+  // Number of samples of the blocks of a wavelet band, 0 if the band cannot be decoded
+  [[nodiscard]] auto static getBlockSampleCount(Band &band) -> int;
+  // Blocks of the band overlapping the window [startTick, endTick), as the index of the first one
+  // and the index following the last one. The window is widened by one sample of the band on each
+  // side to stay conservative with respect to rounding errors.
+  [[nodiscard]] auto static getBlockRange(Band &band, unsigned int timescale, double startTick,
+                                          double endTick) -> std::pair<int, int>;
 
 private:
-  std::vector<double> sig_rec;
+  // Calls decode for every index in [0, count), on the threads of the decoder
+  void forEachBlock(size_t count, const std::function<void(Spiht_Dec &, size_t)> &decode);
+
+  DecodingPrecision precision = DecodingPrecision::Double;
+  std::unique_ptr<tools::ThreadPool> pool;
   Spiht_Dec spihtDec = Spiht_Dec();
 };
 } // namespace haptics::waveletdecoder
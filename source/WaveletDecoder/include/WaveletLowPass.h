@@ -0,0 +1,65 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef WAVELETLOWPASS_H
+#define WAVELETLOWPASS_H
+
+#include <Iir.h>
+#include <WaveletDecoder/include/WaveletDecoder.h>
+#include <vector>
+
+namespace haptics::waveletdecoder {
+
+// Second order Butterworth low-pass filter at the low-pass frequency of a wavelet band, run over
+// its decoded blocks as over the decoded signal of the whole band. Each block is filtered with the
+// state left by the block before it: a block which does not follow the last filtered one first
+// brings the filter to that state by decoding and filtering the blocks before it again, from their
+// bitstream.
+class WaveletLowPass {
+public:
+  WaveletLowPass(Band &newBand, DecodingPrecision newPrecision);
+
+  // Filters in place the decoded samples of block b of the band
+  auto filterBlock(int b, std::vector<double> &samples) -> void;
+
+private:
+  Band *band = nullptr;
+  DecodingPrecision precision = DecodingPrecision::Double;
+  Iir::Butterworth::LowPass<2> filter;
+  // Block following the last filtered one
+  int nextBlock = 0;
+  Spiht_Dec spihtDec;
+  std::vector<double> replaySamples;
+};
+} // namespace haptics::waveletdecoder
+#endif // WAVELETLOWPASS_H
@@ -0,0 +1,112 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <WaveletDecoder/include/WaveletBlockCache.h>
+#include <WaveletDecoder/include/WaveletLowPass.h>
+
+namespace haptics::waveletdecoder {
+
+WaveletBlockCache::WaveletBlockCache(size_t newMaxBytes, DecodingPrecision newPrecision)
+    : maxBytes(newMaxBytes), precision(newPrecision) {}
+
+WaveletBlockCache::~WaveletBlockCache() = default;
+
+auto WaveletBlockCache::decodeWindow(Band &band, unsigned int timescale, double startTick,
+                                     double endTick) -> void {
+  const int bl = WaveletDecoder::getBlockSampleCount(band);
+  if (bl <= 0) {
+    return;
+  }
+  const auto [firstBlock, endBlock] =
+      WaveletDecoder::getBlockRange(band, timescale, startTick, endTick);
+  size_t windowBlocks = 0;
+  for (int b = firstBlock; b < endBlock; b++) {
+    // The samples are reached without invalidating the index of the effects of the band
+    std::vector<unsigned char> &bitstream = band.getWaveletBitstreamAt(b);
+    if (bitstream.empty()) {
+      continue; // decoded by WaveletDecoder::transformBand, it cannot be released
+    }
+    const BlockKey key(&band, b);
+    auto decoded = decodedBlocks.find(key);
+    if (decoded != decodedBlocks.end()) {
+      recentBlocks.splice(recentBlocks.begin(), recentBlocks, decoded->second);
+    } else {
+      std::vector<double> &samples = band.getWaveletSamplesAt(b);
+      WaveletDecoder::decodeBlock(spihtDec, bitstream, bl, precision, samples);
+      if (band.getWaveletLowPassFrequency().has_value()) {
+        std::unique_ptr<WaveletLowPass> &lowPass = lowPasses[&band];
+        if (lowPass == nullptr) {
+          lowPass = std::make_unique<WaveletLowPass>(band, precision);
+        }
+        lowPass->filterBlock(b, samples);
+      }
+      decodedBytes += samples.capacity() * sizeof(double);
+      decodeCount++;
+      recentBlocks.push_front(key);
+      decodedBlocks.emplace(key, recentBlocks.begin());
+    }
+    windowBlocks++;
+  }
+
+  while (decodedBytes > maxBytes && recentBlocks.size() > windowBlocks) {
+    release(recentBlocks.back());
+  }
+}
+
+auto WaveletBlockCache::clear() -> void {
+  while (!recentBlocks.empty()) {
+    release(recentBlocks.back());
+  }
+}
+
+auto WaveletBlockCache::release(BlockKey key) -> void {
+  const auto [band, index] = key;
+  std::vector<double> &samples = band->getWaveletSamplesAt(index);
+  decodedBytes -= samples.capacity() * sizeof(double);
+  std::vector<double>().swap(samples);
+  auto decoded = decodedBlocks.find(key);
+  recentBlocks.erase(decoded->second);
+  decodedBlocks.erase(decoded);
+}
+
+[[nodiscard]] auto WaveletBlockCache::getMaxBytes() const -> size_t { return maxBytes; }
+
+[[nodiscard]] auto WaveletBlockCache::getDecodedBytes() const -> size_t { return decodedBytes; }
+
+[[nodiscard]] auto WaveletBlockCache::getDecodedBlockCount() const -> size_t {
+  return recentBlocks.size();
+}
+
+[[nodiscard]] auto WaveletBlockCache::getDecodeCount() const -> size_t { return decodeCount; }
+
+} // namespace haptics::waveletdecoder
@@ -32,9 +32,21 @@
  */
 
 #include "../include/WaveletDecoder.h"
+#include "../include/WaveletLowPass.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
 
 namespace haptics::waveletdecoder {
 
+WaveletDecoder::WaveletDecoder(DecodingPrecision newPrecision, size_t threadCount)
+    : precision(newPrecision) {
+  if (threadCount > 1) {
+    pool = std::make_unique<tools::ThreadPool>(threadCount);
+  }
+}
+
 auto WaveletDecoder::decodeBand(Band &band, int timescale) -> std::vector<double> {
   if (band.getBandType() != BandType::WaveletWave || !band.getBlockLength().has_value()) {
     return std::vector<double>();
@@ -43,58 +55,151 @@ auto WaveletDecoder::decodeBand(Band &band, int timescale) -> std::vector<double
   int bl = band.getBlockLength().value() * band.getUpperFrequencyLimit() / timescale;
   int dwtlevel = (int)log2((double)bl / 4);
   std::vector<double> sig_rec(numBlocks * bl, 0);
+  // The band is only accessed from the calling thread, the workers reading the bitstreams
+  std::vector<std::vector<unsigned char> *> bitstreams(numBlocks);
+  for (size_t b = 0; b < numBlocks; b++) {
+    bitstreams[b] = &band.getWaveletBitstreamAt((int)b);
+  }
 
-  for (uint32_t b = 0; b < numBlocks; b++) {
-    Effect effect = band.getEffectAt((int)b);
-    auto bitstream = effect.getWaveletBitstream();
+  forEachBlock(numBlocks, [&](Spiht_Dec &decoder, size_t b) {
     std::vector<int> block_dwt(bl, 0);
     double scalar = 0;
     int bits = 0;
-    spihtDec.decodeEffect(bitstream, block_dwt, bl, scalar, bits);
+    decoder.decodeEffect(*bitstreams[b], block_dwt, bl, scalar, bits);
     std::vector<double> block_time(bl);
     decodeBlock(block_dwt, block_time, scalar, dwtlevel);
-    std::copy(block_time.begin(), block_time.end(), sig_rec.begin() + effect.getPosition());
-  }
+    // Blocks are contiguous, the position of block b being b * bl samples
+    std::copy(block_time.begin(), block_time.end(), sig_rec.begin() + (long)b * bl);
+  });
   return sig_rec;
 }
 
 void WaveletDecoder::transformBand(Band &band, unsigned int timescale) {
+  transformBand(band, timescale, -std::numeric_limits<double>::infinity(),
+                std::numeric_limits<double>::infinity());
+}
 
-  if (band.getBandType() != BandType::WaveletWave) {
+void WaveletDecoder::transformBand(Band &band, unsigned int timescale, double startTick,
+                                   double endTick) {
+
+  const int bl = getBlockSampleCount(band);
+  if (bl <= 0) {
     return;
   }
-  size_t numBlocks = band.getEffectsSize();
-  auto bl = (int)(band.getBlockLengthOrDefault() * MS_2_S_WAVELET *
-                  (double)band.getUpperFrequencyLimit());
-  int dwtlevel = (int)log2((double)bl / 4);
+  const auto [firstBlock, endBlock] = getBlockRange(band, timescale, startTick, endTick);
+  std::vector<int> blocks;
+  // The band is only accessed from the calling thread, the workers reading the bitstreams
+  std::vector<std::vector<unsigned char> *> bitstreams;
+  for (int b = firstBlock; b < endBlock; b++) {
+    std::vector<unsigned char> &bitstream = band.getWaveletBitstreamAt(b);
+    if (!bitstream.empty()) {
+      blocks.push_back(b); // not decoded yet
+      bitstreams.push_back(&bitstream);
+    }
+  }
 
-  for (uint32_t b = 0; b < numBlocks; b++) {
-    Effect effect = band.getEffectAt((int)b);
-    auto bitstream = effect.getWaveletBitstream();
-    std::vector<int> block_dwt(bl, 0);
-    double scalar = 0;
-    int bits = 0;
-    spihtDec.decodeEffect(bitstream, block_dwt, bl, scalar, bits);
-    scalar /= pow(2, (double)bits);
+  std::vector<std::vector<double>> blockSamples(blocks.size());
+  forEachBlock(blocks.size(), [&](Spiht_Dec &decoder, size_t i) {
+    decodeBlock(decoder, *bitstreams[i], bl, precision, blockSamples[i]);
+  });
+  if (band.getWaveletLowPassFrequency().has_value()) {
+    WaveletLowPass lowPass(band, precision);
+    for (size_t i = 0; i < blocks.size(); i++) {
+      lowPass.filterBlock(blocks[i], blockSamples[i]);
+    }
+  }
+  for (size_t i = 0; i < blocks.size(); i++) {
     Effect newEffect;
-    newEffect.setPosition(
-        (int)((double)b * (double)bl * (double)timescale / (double)band.getUpperFrequencyLimit()));
-    auto block_time = std::vector<double>();
+    newEffect.setPosition((int)((double)blocks[i] * (double)bl * (double)timescale /
+                                (double)band.getUpperFrequencyLimit()));
+    newEffect.setWaveletSamples(std::move(blockSamples[i]));
+    band.replaceEffectAt(blocks[i], newEffect);
+  }
+}
+
+void WaveletDecoder::decodeBlock(Spiht_Dec &decoder, std::vector<unsigned char> &bitstream,
+                                 int bl, DecodingPrecision blockPrecision,
+                                 std::vector<double> &block_time) {
+  std::vector<int> block_dwt(bl, 0);
+  double scalar = 0;
+  int bits = 0;
+  decoder.decodeEffect(bitstream, block_dwt, bl, scalar, bits);
+  scalar /= pow(2, (double)bits);
+  const int dwtlevel = (int)log2((double)bl / 4);
+  if (blockPrecision == DecodingPrecision::Single) {
+    auto block_time_float = std::vector<float>();
+    decodeBlock(block_dwt, block_time_float, (float)scalar, dwtlevel);
+    block_time.assign(block_time_float.begin(), block_time_float.end());
+  } else {
     decodeBlock(block_dwt, block_time, scalar, dwtlevel);
-    newEffect.setWaveletSamples(block_time);
-    band.replaceEffectAt((int)b, newEffect);
   }
 }
 
+auto WaveletDecoder::getBlockSampleCount(Band &band) -> int {
+  if (band.getBandType() != BandType::WaveletWave || band.getUpperFrequencyLimit() <= 0) {
+    return 0;
+  }
+  return std::max((int)(band.getBlockLengthOrDefault() * MS_2_S_WAVELET *
+                        (double)band.getUpperFrequencyLimit()),
+                  0);
+}
+
+auto WaveletDecoder::getBlockRange(Band &band, unsigned int timescale, double startTick,
+                                   double endTick) -> std::pair<int, int> {
+  const int bl = getBlockSampleCount(band);
+  if (bl <= 0) {
+    return {0, 0};
+  }
+  // Block b covers the ticks [b * blockTicks, (b + 1) * blockTicks)
+  const double blockTicks = (double)bl * (double)timescale / (double)band.getUpperFrequencyLimit();
+  const double sampleTicks = (double)timescale / (double)band.getUpperFrequencyLimit();
+  const double firstBlock = std::max(std::floor((startTick - sampleTicks) / blockTicks), 0.0);
+  const double lastBlock = std::min(std::floor((endTick + sampleTicks) / blockTicks),
+                                    (double)band.getEffectsSize() - 1);
+  if (lastBlock < firstBlock) {
+    return {0, 0};
+  }
+  return {(int)firstBlock, (int)lastBlock + 1};
+}
+
+void WaveletDecoder::forEachBlock(size_t count,
+                                  const std::function<void(Spiht_Dec &, size_t)> &decode) {
+  const size_t rangeCount = pool == nullptr ? 1 : std::min(pool->getThreadCount(), count);
+  if (rangeCount <= 1) {
+    for (size_t i = 0; i < count; i++) {
+      decode(spihtDec, i);
+    }
+    return;
+  }
+  // Each thread decodes a contiguous range of blocks with its own SPIHT decoder
+  pool->parallelFor(rangeCount, [&](size_t r) {
+    Spiht_Dec rangeDecoder;
+    for (size_t i = count * r / rangeCount; i < count * (r + 1) / rangeCount; i++) {
+      decode(rangeDecoder, i);
+    }
+  });
+}
+
 void WaveletDecoder::decodeBlock(std::vector<int> &block_dwt, std::vector<double> &block_time,
                                  double scalar, int dwtl) {
 
-  Wavelet wavelet;
-  std::vector<double> block_scaled(block_dwt.size(), 0);
-  std::transform(block_dwt.begin(), block_dwt.end(), block_scaled.begin(),
+  // Kept from one block to the next, so that decoding a block does not allocate memory
+  thread_local Wavelet wavelet;
+  block_time.resize(block_dwt.size());
+  std::transform(block_dwt.begin(), block_dwt.end(), block_time.begin(),
                  [scalar](int d) -> double { return (double)d * scalar; });
+  wavelet.inv_DWT(block_time, dwtl);
+}
+
+void WaveletDecoder::decodeBlock(std::vector<int> &block_dwt, std::vector<float> &block_time,
+                                 float scalar, int dwtl) {
+
+  // Kept from one block to the next, so that decoding a block does not allocate memory
+  thread_local Wavelet wavelet;
   block_time.resize(block_dwt.size());
-  wavelet.inv_DWT(block_scaled, dwtl, block_time);
+  std::transform(block_dwt.begin(), block_dwt.end(), block_time.begin(),
+                 [scalar](int d) -> float { return (float)d * scalar; });
+  wavelet.inv_DWT(block_time, dwtl);
 }
 
 } // namespace haptics::waveletdecoder
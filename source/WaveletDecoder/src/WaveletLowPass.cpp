@@ -0,0 +1,65 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <WaveletDecoder/include/WaveletLowPass.h>
+
+namespace haptics::waveletdecoder {
+
+WaveletLowPass::WaveletLowPass(Band &newBand, DecodingPrecision newPrecision)
+    : band(&newBand), precision(newPrecision) {
+  filter.setup(band->getUpperFrequencyLimit(), band->getWaveletLowPassFrequency().value_or(0));
+}
+
+auto WaveletLowPass::filterBlock(int b, std::vector<double> &samples) -> void {
+  if (b < nextBlock) {
+    filter.reset();
+    nextBlock = 0;
+  }
+  const int bl = WaveletDecoder::getBlockSampleCount(*band);
+  for (; nextBlock < b; nextBlock++) {
+    std::vector<unsigned char> &bitstream = band->getWaveletBitstreamAt(nextBlock);
+    if (bitstream.empty()) {
+      continue; // decoded by WaveletDecoder::transformBand, which filters the band itself
+    }
+    WaveletDecoder::decodeBlock(spihtDec, bitstream, bl, precision, replaySamples);
+    for (double sample : replaySamples) {
+      filter.filter(sample);
+    }
+  }
+  for (double &sample : samples) {
+    sample = filter.filter(sample);
+  }
+  nextBlock = b + 1;
+}
+
+} // namespace haptics::waveletdecoder
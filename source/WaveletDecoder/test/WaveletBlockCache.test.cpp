@@ -0,0 +1,180 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2021, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <TestSupport/include/WaveletBandFixture.h>
+#include <WaveletDecoder/include/WaveletBlockCache.h>
+#include <catch2/catch.hpp>
+
+using haptics::waveletdecoder::DecodingPrecision;
+using haptics::waveletdecoder::WaveletBlockCache;
+using haptics::waveletdecoder::WaveletDecoder;
+using haptics::testsupport::makeWaveletBand;
+
+namespace {
+constexpr int FS = 8000;
+constexpr int BL = 128;
+constexpr unsigned int TIMESCALE = 1000;
+constexpr double BLOCK_TICKS = static_cast<double>(BL) * TIMESCALE / FS;
+
+// Decodes block b of the band, which is entirely within the window
+auto decodeBlock(WaveletBlockCache &cache, Band &band, int b) -> void {
+  cache.decodeWindow(band, TIMESCALE, b * BLOCK_TICKS + 1, (b + 1) * BLOCK_TICKS - 1);
+}
+
+auto isDecoded(Band &band, int b) -> bool {
+  return !band.getEffectAt(b).getWaveletSamples().empty();
+}
+} // namespace
+
+TEST_CASE("WaveletBlockCache", "[WaveletBlockCache]") {
+  const int blockCount = 8;
+  Band band = makeWaveletBand(blockCount, FS, BL);
+  Band reference = band;
+  WaveletDecoder().transformBand(reference, TIMESCALE);
+
+  SECTION("blocks are decoded on demand") {
+    WaveletBlockCache cache(SIZE_MAX);
+    decodeBlock(cache, band, 3);
+    CHECK(cache.getDecodedBlockCount() == 1);
+    CHECK(cache.getDecodeCount() == 1);
+    CHECK(cache.getDecodedBytes() >= BL * sizeof(double));
+    for (int b = 0; b < blockCount; b++) {
+      CHECK(isDecoded(band, b) == (b == 3));
+      CHECK_FALSE(band.getEffectAt(b).getWaveletBitstream().empty());
+    }
+    CHECK(band.getEffectAt(3).getWaveletSamples() == reference.getEffectAt(3).getWaveletSamples());
+
+    decodeBlock(cache, band, 3);
+    CHECK(cache.getDecodeCount() == 1);
+    cache.decodeWindow(band, TIMESCALE, 0, blockCount * BLOCK_TICKS);
+    CHECK(cache.getDecodedBlockCount() == blockCount);
+    CHECK(cache.getDecodeCount() == blockCount);
+    for (int b = 0; b < blockCount; b++) {
+      CHECK(band.getEffectAt(b).getWaveletSamples() ==
+            reference.getEffectAt(b).getWaveletSamples());
+    }
+
+    cache.clear();
+    CHECK(cache.getDecodedBlockCount() == 0);
+    CHECK(cache.getDecodedBytes() == 0);
+    for (int b = 0; b < blockCount; b++) {
+      CHECK_FALSE(isDecoded(band, b));
+    }
+  }
+
+  SECTION("the least recently used blocks are released") {
+    WaveletBlockCache probe(SIZE_MAX);
+    Band probeBand = band;
+    decodeBlock(probe, probeBand, 0);
+    const size_t blockBytes = probe.getDecodedBytes();
+
+    WaveletBlockCache cache(3 * blockBytes);
+    for (int b = 0; b < 5; b++) {
+      decodeBlock(cache, band, b);
+    }
+    CHECK(cache.getDecodedBlockCount() == 3);
+    CHECK(cache.getDecodedBytes() == 3 * blockBytes);
+    CHECK_FALSE(isDecoded(band, 0));
+    CHECK_FALSE(isDecoded(band, 1));
+
+    decodeBlock(cache, band, 2);
+    decodeBlock(cache, band, 5);
+    CHECK(isDecoded(band, 2));
+    CHECK_FALSE(isDecoded(band, 3));
+    CHECK(isDecoded(band, 4));
+    CHECK(isDecoded(band, 5));
+
+    decodeBlock(cache, band, 0);
+    CHECK(cache.getDecodeCount() == 7);
+    CHECK(band.getEffectAt(0).getWaveletSamples() == reference.getEffectAt(0).getWaveletSamples());
+  }
+
+  SECTION("the blocks of the window are kept beyond the cap") {
+    WaveletBlockCache cache(1);
+    cache.decodeWindow(band, TIMESCALE, BLOCK_TICKS, 3 * BLOCK_TICKS);
+    CHECK(cache.getDecodedBlockCount() == 4);
+    decodeBlock(cache, band, 6);
+    CHECK(cache.getDecodedBlockCount() == 1);
+    CHECK(isDecoded(band, 6));
+  }
+
+  SECTION("the extent of the blocks does not depend on their samples") {
+    WaveletBlockCache cache(SIZE_MAX);
+    std::vector<int> encodedIndices;
+    band.getEffectsInWindow(3 * BLOCK_TICKS + .5, 3 * BLOCK_TICKS + 1, TIMESCALE, encodedIndices);
+    CHECK_FALSE(encodedIndices.empty());
+    std::vector<int> indices;
+    cache.decodeWindow(band, TIMESCALE, 0, blockCount * BLOCK_TICKS);
+    // The index is rebuilt from the decoded samples, then from the released ones, the mutable
+    // access to an effect invalidating it
+    band.getEffectAt(0);
+    band.getEffectsInWindow(3 * BLOCK_TICKS + .5, 3 * BLOCK_TICKS + 1, TIMESCALE, indices);
+    CHECK(indices == encodedIndices);
+    cache.clear();
+    band.getEffectAt(0);
+    band.getEffectsInWindow(3 * BLOCK_TICKS + .5, 3 * BLOCK_TICKS + 1, TIMESCALE, indices);
+    CHECK(indices == encodedIndices);
+  }
+
+  SECTION("the blocks of low-passed bands are filtered as the whole band") {
+    band.setWaveletLowPassFrequency(FS / 16.0);
+    Band lowPassReference = band;
+    WaveletDecoder().transformBand(lowPassReference, TIMESCALE);
+    CHECK(lowPassReference.getEffectAt(3).getWaveletSamples() !=
+          reference.getEffectAt(3).getWaveletSamples());
+
+    WaveletBlockCache cache(SIZE_MAX);
+    // Blocks after the last filtered one, then released and earlier ones
+    for (int b : {2, 3, 5}) {
+      decodeBlock(cache, band, b);
+      CHECK(band.getEffectAt(b).getWaveletSamples() ==
+            lowPassReference.getEffectAt(b).getWaveletSamples());
+    }
+    cache.clear();
+    for (int b : {3, 1, 7}) {
+      decodeBlock(cache, band, b);
+      CHECK(band.getEffectAt(b).getWaveletSamples() ==
+            lowPassReference.getEffectAt(b).getWaveletSamples());
+    }
+    CHECK(cache.getDecodeCount() == 6);
+  }
+
+  SECTION("single precision") {
+    WaveletBlockCache cache(SIZE_MAX, DecodingPrecision::Single);
+    Band singleReference = band;
+    WaveletDecoder(DecodingPrecision::Single).transformBand(singleReference, TIMESCALE);
+    decodeBlock(cache, band, 4);
+    CHECK(band.getEffectAt(4).getWaveletSamples() ==
+          singleReference.getEffectAt(4).getWaveletSamples());
+  }
+}
@@ -33,15 +33,73 @@
 
 #include <catch2/catch.hpp>
 
+#include <cmath>
 #include <iostream>
 #include <vector>
 
 #include "../include/WaveletDecoder.h"
+#include "TestSupport/include/WaveletBandFixture.h"
 #include "Encoder/include/WaveletEncoder.h"
 
+using haptics::testsupport::makeWaveletBand;
+
+namespace {
+constexpr int FS = 8000;
+constexpr int BL = 128;
+constexpr unsigned int TIMESCALE = 1000;
+} // namespace
+
 TEST_CASE("haptics::WaveletDecoder") {
 
   using haptics::waveletdecoder::WaveletDecoder;
 
   SECTION("Input/Output test") { CHECK(true); }
+
+  SECTION("decodeBlock in single precision") {
+    const int blockLength = 64;
+    const int dwtLevels = 4;
+    const double scalar = 1.0 / 512;
+    std::vector<int> block_dwt(blockLength, 0);
+    for (int i = 0; i < blockLength; i++) {
+      block_dwt[i] = ((i * 37) % 101) - 50;
+    }
+    std::vector<double> block_time;
+    WaveletDecoder::decodeBlock(block_dwt, block_time, scalar, dwtLevels);
+    std::vector<float> block_time_float;
+    WaveletDecoder::decodeBlock(block_dwt, block_time_float, (float)scalar, dwtLevels);
+    REQUIRE(block_time_float.size() == block_time.size());
+    for (size_t i = 0; i < block_time.size(); i++) {
+      CHECK(std::abs(block_time_float[i] - block_time[i]) < 1e-5);
+    }
+  }
+}
+
+TEST_CASE("WaveletDecoder::transformBand with several threads") {
+
+  using haptics::waveletdecoder::DecodingPrecision;
+  using haptics::waveletdecoder::WaveletDecoder;
+
+  const int blockCount = 37;
+  const Band encoded = makeWaveletBand(blockCount, FS, BL);
+  for (DecodingPrecision precision : {DecodingPrecision::Double, DecodingPrecision::Single}) {
+    Band serial = encoded;
+    WaveletDecoder(precision).transformBand(serial, TIMESCALE);
+    for (size_t threadCount : {2, 5, 64}) {
+      Band parallel = encoded;
+      WaveletDecoder(precision, threadCount).transformBand(parallel, TIMESCALE);
+      REQUIRE(parallel.getEffectsSize() == blockCount);
+      for (int b = 0; b < blockCount; b++) {
+        CHECK(parallel.getEffectAt(b).getWaveletBitstream().empty());
+        CHECK(parallel.getEffectAt(b).getPosition() == serial.getEffectAt(b).getPosition());
+        REQUIRE(parallel.getEffectAt(b).getWaveletSamples().size() == BL);
+        CHECK(parallel.getEffectAt(b).getWaveletSamples() ==
+              serial.getEffectAt(b).getWaveletSamples());
+      }
+    }
+  }
+
+  Band serial = encoded;
+  Band parallel = encoded;
+  CHECK(WaveletDecoder().decodeBand(serial, TIMESCALE) ==
+        WaveletDecoder(DecodingPrecision::Double, 4).decodeBand(parallel, TIMESCALE));
 }